@@ -73,16 +73,23 @@
 
 #define LDAPUTILS_BUFF_LEN                 4096
 #define LDAPUTILS_OPT_LEN                  128
+#define LDAPUTILS_CONNS_MAX                64    // connections of parallel search
+#define LDAPUTILS_THREADS_MAX              256   // threads sorting or formatting
 
 
 #define LDAPUTILS_OPTIONS_COMMON           "cd:D:hH:np:P:uvVw:Wxy:Y:Z"
-#define LDAPUTILS_OPTIONS_SEARCH           "b:l:Ls:S:z:"
+#define LDAPUTILS_OPTIONS_SEARCH           "b:E:l:Ls:S:z:"
 
 
 #define LDAPUTILS_TREE_HIERARCHY           0x0000
 #define LDAPUTILS_TREE_BULLETS             0x0001
 
 
+// returned by a search callback which keeps the search entry; the
+// callback is responsible for releasing the entry with ldap_msgfree()
+#define LDAPUTILS_SEARCH_RETAIN            0x7fff
+
+
 /////////////////
 //             //
 //  Datatypes  //
@@ -91,12 +98,23 @@
 // MARK: - Datatypes
 
 typedef struct ldap_utils_attribute    LDAPUtilsAttribute;
+typedef struct ldap_utils_dn           LDAPUtilsDN;
+typedef struct ldap_utils_dn_cache     LDAPUtilsDNCache;
 typedef struct ldap_utils_entry        LDAPUtilsEntry;
 typedef struct ldap_utils_entries      LDAPUtilsEntries;
+typedef struct ldap_utils_mux          LDAPUtilsMux;
+typedef struct ldap_utils_output       LDAPUtilsOutput;
+typedef struct ldap_utils_pipeline     LDAPUtilsPipeline;
 typedef struct ldap_utils_tree         LDAPUtilsTree;
 typedef struct ldaputils_config_struct LDAPUtils;
 typedef struct ldap_utils_tree_opts    LDAPUtilsTreeOpts;
 
+// callback used to deliver search results as they are received
+typedef int (*LDAPUtilsSearchFunc)(LDAPUtils * lud, LDAPMessage * msg, void * context);
+
+// callback used to format a search entry into a buffer, `ld' is only used to decode the entry
+typedef int (*LDAPUtilsFormatFunc)(LDAP * ld, LDAPMessage * msg, LDAPUtilsOutput * out, void * context);
+
 struct ldap_utils_tree_opts
 {
    size_t    noleaf;
@@ -122,6 +140,13 @@ struct ldaputils_config_struct
    int               verbose;      // -v verbose mode
    int               want_pass;    // -W prompt for passowrd
    int               pad0;
+   int               pagesize;     // -E pr=size paged results page size
+   int               pagecrit;     // -E !pr=size paged results is critical
+   int               sortctrl;     //    server side sorting (1 supported, -1 unsupported)
+   int               vlvoffset;    //    --offset VLV index of first entry
+   int               vlvcount;     //    --count VLV number of entries
+   int               sortthreads;  //    --sort-threads threads used to sort in memory
+   size_t            maxmemory;    //    --max-memory bytes of sort keys held in memory
    struct berval     passwd;       //    stores password from -y, -w, and -W
    char **           attrs;        //    result attributes
    const char *      sasl_mech;    // -Y sasl mechanism
@@ -129,6 +154,7 @@ struct ldaputils_config_struct
    const char *      filter;       //    search filter
    const char *      passfile;     // -y password file
    const char *      sortattr;     // -S sort by attribute
+   const char *      sortrule;     //    ordering matching rule of sort attribute
 };
 
 
@@ -178,6 +204,13 @@ ldaputils_entries_sort(
          int                           (*compar)(const void *, const void *) );
 
 
+_LDAPUTILS_F int
+ldaputils_entries_sort_parallel(
+         LDAPUtilsEntries *            entries,
+         int                           (*compar)(const void *, const void *),
+         size_t                        threads );
+
+
 _LDAPUTILS_F int
 ldaputils_entry_cmp(
          const void *                  ptr1,
@@ -195,6 +228,13 @@ ldaputils_entry_free(
          LDAPUtilsEntry *              entry );
 
 
+_LDAPUTILS_F const struct berval * const *
+ldaputils_entry_get_attribute(
+         LDAPUtilsEntry *              entry,
+         const char *                  name,
+         size_t *                      lenp );
+
+
 _LDAPUTILS_F int
 ldaputils_count_entries(
          LDAPUtilsEntries *            entries );
@@ -217,6 +257,13 @@ ldaputils_get_entries(
          const char *                  sortattr );
 
 
+_LDAPUTILS_F LDAPUtilsEntries *
+ldaputils_get_entries_view(
+         LDAP *                        ld,
+         LDAPMessage *                 res,
+         const char *                  sortattr );
+
+
 _LDAPUTILS_F char **
 ldaputils_get_values(
             LDAP *                     ld,
@@ -239,6 +286,69 @@ ldaputils_values_sort(
             struct berval **           vals );
 
 
+//----------------------//
+// parsed DN prototypes //
+//----------------------//
+// MARK: parsed DN prototypes
+
+_LDAPUTILS_F void
+ldaputils_dn_cache_free(
+            LDAPUtilsDNCache *         cache );
+
+
+_LDAPUTILS_F LDAPUtilsDNCache *
+ldaputils_dn_cache_initialize( void );
+
+
+_LDAPUTILS_F void
+ldaputils_dn_free(
+            LDAPUtilsDN *              dn );
+
+
+_LDAPUTILS_F const char *
+ldaputils_dn_get_adc(
+            LDAPUtilsDN *              dn );
+
+
+_LDAPUTILS_F const char * const *
+ldaputils_dn_get_components(
+            const LDAPUtilsDN *        dn,
+            size_t *                   lenp );
+
+
+_LDAPUTILS_F const char *
+ldaputils_dn_get_dce(
+            LDAPUtilsDN *              dn );
+
+
+_LDAPUTILS_F const char * const *
+ldaputils_dn_get_normalized(
+            const LDAPUtilsDN *        dn,
+            size_t *                   lenp );
+
+
+_LDAPUTILS_F const char *
+ldaputils_dn_get_rdn(
+            const LDAPUtilsDN *        dn );
+
+
+_LDAPUTILS_F const char *
+ldaputils_dn_get_ufn(
+            LDAPUtilsDN *              dn );
+
+
+_LDAPUTILS_F LDAPUtilsDN *
+ldaputils_dn_parse(
+            LDAPUtilsDNCache *         cache,
+            const char *               dn );
+
+
+_LDAPUTILS_F LDAPUtilsDN *
+ldaputils_dn_parse_bv(
+            LDAPUtilsDNCache *         cache,
+            struct berval *            dn );
+
+
 //----------------------//
 // utilities prototypes //
 //----------------------//
@@ -261,6 +371,16 @@ ldaputils_getopt(
             const char *               arg );
 
 
+_LDAPUTILS_F int
+ldaputils_getopt_size(
+            LDAPUtils *                lud,
+            const char *               name,
+            const char *               arg,
+            size_t                     min,
+            size_t                     max,
+            size_t *                   valp );
+
+
 _LDAPUTILS_F void
 ldaputils_params(
             LDAPUtils *                lud );
@@ -338,17 +458,216 @@ ldaputils_initialize(
             const char *               prog_name );
 
 
+_LDAPUTILS_F int
+ldaputils_initialize_copy(
+            LDAPUtils **               lup,
+            LDAPUtils *                src );
+
+
 _LDAPUTILS_F int
 ldaputils_search(
             LDAPUtils *                lud,
             LDAPMessage **             resp );
 
 
+_LDAPUTILS_F int
+ldaputils_search_parallel(
+            LDAPUtils *                lud,
+            size_t                     conns,
+            int                        ordered,
+            LDAPUtilsSearchFunc        func,
+            void *                     context );
+
+
+_LDAPUTILS_F int
+ldaputils_search_sorted(
+            LDAPUtils *                lud,
+            LDAPUtilsSearchFunc        func,
+            void *                     context );
+
+
+_LDAPUTILS_F int
+ldaputils_search_stream(
+            LDAPUtils *                lud,
+            LDAPUtilsSearchFunc        func,
+            void *                     context );
+
+
+_LDAPUTILS_F int
+ldaputils_supported_control(
+            LDAPUtils *                lud,
+            const char *               oid );
+
+
 _LDAPUTILS_F void
 ldaputils_unbind(
             LDAPUtils *                lud );
 
 
+//-------------------------------//
+// search multiplexer prototypes //
+//-------------------------------//
+// MARK: search multiplexer prototypes
+
+_LDAPUTILS_F void
+ldaputils_mux_free(
+            LDAPUtilsMux *             mux );
+
+
+_LDAPUTILS_F int
+ldaputils_mux_initialize(
+            LDAPUtilsMux **            muxp,
+            LDAPUtils *                lud );
+
+
+_LDAPUTILS_F int
+ldaputils_mux_result(
+            LDAPUtilsMux *             mux,
+            struct timeval *           timeout );
+
+
+_LDAPUTILS_F int
+ldaputils_mux_search(
+            LDAPUtilsMux *             mux,
+            const char *               base,
+            int                        scope,
+            const char *               filter,
+            char **                    attrs,
+            struct timeval *           timeout,
+            LDAPUtilsSearchFunc        func,
+            void *                     context );
+
+
+_LDAPUTILS_F int
+ldaputils_mux_search_ext(
+            LDAPUtilsMux *             mux,
+            const char *               base,
+            int                        scope,
+            const char *               filter,
+            char **                    attrs,
+            struct timeval *           timeout,
+            int                        sizelimit,
+            LDAPUtilsSearchFunc        func,
+            void *                     context );
+
+
+//----------------------------//
+// buffered output prototypes //
+//----------------------------//
+// MARK: buffered output prototypes
+
+_LDAPUTILS_F int
+ldaputils_output_base64(
+            LDAPUtilsOutput *          out,
+            const void *               data,
+            size_t                     len );
+
+
+_LDAPUTILS_F void
+ldaputils_output_commit(
+            LDAPUtilsOutput *          out,
+            size_t                     len );
+
+
+_LDAPUTILS_F int
+ldaputils_output_csv(
+            LDAPUtilsOutput *          out,
+            const void *               data,
+            size_t                     len,
+            int                        sep );
+
+
+_LDAPUTILS_F int
+ldaputils_output_flush(
+            LDAPUtilsOutput *          out );
+
+
+_LDAPUTILS_F void
+ldaputils_output_free(
+            LDAPUtilsOutput *          out );
+
+
+_LDAPUTILS_F int
+ldaputils_output_initialize(
+            LDAPUtilsOutput **         outp,
+            int                        fd,
+            size_t                     threshold );
+
+
+_LDAPUTILS_F int
+ldaputils_output_json(
+            LDAPUtilsOutput *          out,
+            const void *               data,
+            size_t                     len );
+
+
+_LDAPUTILS_F int
+ldaputils_output_json_value(
+            LDAPUtilsOutput *          out,
+            const void *               data,
+            size_t                     len );
+
+
+_LDAPUTILS_F int
+ldaputils_output_printf(
+            LDAPUtilsOutput *          out,
+            const char *               fmt,
+            ... );
+
+
+_LDAPUTILS_F int
+ldaputils_output_putc(
+            LDAPUtilsOutput *          out,
+            int                        c );
+
+
+_LDAPUTILS_F int
+ldaputils_output_puts(
+            LDAPUtilsOutput *          out,
+            const char *               str );
+
+
+_LDAPUTILS_F char *
+ldaputils_output_reserve(
+            LDAPUtilsOutput *          out,
+            size_t                     len );
+
+
+_LDAPUTILS_F int
+ldaputils_output_write(
+            LDAPUtilsOutput *          out,
+            const void *               data,
+            size_t                     len );
+
+
+//---------------------------//
+// entry pipeline prototypes //
+//---------------------------//
+// MARK: entry pipeline prototypes
+
+_LDAPUTILS_F int
+ldaputils_pipeline_entry(
+            LDAPUtils *                lud,
+            LDAPMessage *              msg,
+            void *                     context );
+
+
+_LDAPUTILS_F int
+ldaputils_pipeline_finish(
+            LDAPUtilsPipeline *        pipe,
+            size_t *                   countp );
+
+
+_LDAPUTILS_F int
+ldaputils_pipeline_initialize(
+            LDAPUtilsPipeline **       pipep,
+            LDAPUtilsOutput *          out,
+            const char *               sep,
+            size_t                     threads,
+            LDAPUtilsFormatFunc        func,
+            void **                    contexts );
+
+
 //----------------------//
 // LDAP tree prototypes //
 //----------------------//
@@ -375,6 +694,14 @@ ldaputils_tree_add_entry(
             int                        copy );
 
 
+_LDAPUTILS_F int
+ldaputils_tree_add_message(
+            LDAPUtilsTree *            tree,
+            LDAP *                     ld,
+            LDAPMessage *              msg,
+            int                        copy );
+
+
 _LDAPUTILS_F void
 ldaputils_tree_free(
             LDAPUtilsTree *            tree );
@@ -398,5 +725,12 @@ ldaputils_tree_print(
             LDAPUtilsTreeOpts *        opts );
 
 
+_LDAPUTILS_F int
+ldaputils_tree_search(
+            LDAPUtils *                lud,
+            LDAPUtilsTree *            tree,
+            int                        copy );
+
+
 LDAPUTILS_END_C_DECLS
 #endif /* end of header */
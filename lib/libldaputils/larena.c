@@ -0,0 +1,248 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2025 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/larena.c contains arena allocator functions and variables
+ */
+#define _LIB_LIBLDAPUTILS_LARENA_C 1
+#include "larena.h"
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+// MARK: - Headers
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+// MARK: - Definitions
+
+#define LDAPUTILS_ARENA_ALIGN(size) \
+   (((size) + (_Alignof(max_align_t) - 1)) & ~((size_t)_Alignof(max_align_t) - 1))
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+// MARK: - Prototypes
+
+static LDAPUtilsArenaBlock *
+ldaputils_arena_block(
+         size_t                        size );
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+// MARK: - Functions
+
+/// allocates memory from arena
+/// @param[in] arena   reference to arena
+/// @param[in] size    number of bytes to allocate
+///
+/// Memory returned by the arena is aligned for any type and is released
+/// only when the arena is freed.  Requests larger than a quarter of the
+/// block size are given a dedicated block so the current block is not
+/// abandoned.
+///
+/// @return    Returns pointer to memory or NULL on error
+/// @see       ldaputils_arena_free, ldaputils_arena_initialize
+void *
+ldaputils_arena_alloc(
+         LDAPUtilsArena *              arena,
+         size_t                        size )
+{
+   void *                  ptr;
+   LDAPUtilsArenaBlock *   block;
+
+   assert(arena != NULL);
+
+   size = LDAPUTILS_ARENA_ALIGN(((size)) ? size : 1);
+
+   // allocates dedicated block for large requests
+   if (size > (arena->block_size / 4))
+   {
+      if ((block = ldaputils_arena_block(size)) == NULL)
+         return(NULL);
+      block->used = size;
+      if ((arena->blocks))
+      {
+         block->next        = arena->blocks->next;
+         arena->blocks->next = block;
+      } else {
+         arena->blocks      = block;
+      };
+      arena->count++;
+      return(block->data);
+   };
+
+   // starts new block when current block is full
+   if ( (!(arena->blocks)) || ((arena->blocks->size - arena->blocks->used) < size) )
+   {
+      if ((block = ldaputils_arena_block(arena->block_size)) == NULL)
+         return(NULL);
+      block->next   = arena->blocks;
+      arena->blocks = block;
+   };
+
+   block        = arena->blocks;
+   ptr          = &block->data[block->used];
+   block->used += size;
+   arena->count++;
+
+   return(ptr);
+}
+
+
+/// allocates block of arena memory
+/// @param[in] size    usable size of block
+///
+/// @return    Returns pointer to block or NULL on error
+LDAPUtilsArenaBlock *
+ldaputils_arena_block(
+         size_t                        size )
+{
+   size_t                  hdrlen;
+   LDAPUtilsArenaBlock *   block;
+
+   hdrlen = LDAPUTILS_ARENA_ALIGN(sizeof(LDAPUtilsArenaBlock));
+
+   if ((block = malloc(hdrlen + size)) == NULL)
+      return(NULL);
+   block->next = NULL;
+   block->size = size;
+   block->used = 0;
+   block->data = ((char *)block) + hdrlen;
+
+   return(block);
+}
+
+
+/// frees arena and all memory allocated from arena
+/// @param[in] arena   reference to arena
+void
+ldaputils_arena_free(
+         LDAPUtilsArena *              arena )
+{
+   LDAPUtilsArenaBlock *   block;
+
+   if (!(arena))
+      return;
+
+   while ((block = arena->blocks) != NULL)
+   {
+      arena->blocks = block->next;
+      free(block);
+   };
+
+   free(arena);
+
+   return;
+}
+
+
+/// initializes arena
+/// @param[in] block_size   size of blocks allocated by arena or 0 for default
+///
+/// @return    Returns pointer to arena or NULL on error
+LDAPUtilsArena *
+ldaputils_arena_initialize(
+         size_t                        block_size )
+{
+   LDAPUtilsArena *   arena;
+
+   if ((arena = malloc(sizeof(LDAPUtilsArena))) == NULL)
+      return(NULL);
+   memset(arena, 0, sizeof(LDAPUtilsArena));
+
+   arena->block_size = ((block_size)) ? block_size : LDAPUTILS_ARENA_BLOCK_SIZE;
+
+   return(arena);
+}
+
+
+/// copies buffer into arena
+/// @param[in] arena   reference to arena
+/// @param[in] ptr     buffer to copy
+/// @param[in] len     length of buffer
+///
+/// The copy is terminated with a NUL byte which is not included in len.
+///
+/// @return    Returns pointer to copy or NULL on error
+void *
+ldaputils_arena_memdup(
+         LDAPUtilsArena *              arena,
+         const void *                  ptr,
+         size_t                        len )
+{
+   char *   dup;
+
+   assert(arena != NULL);
+
+   if ((dup = ldaputils_arena_alloc(arena, (len+1))) == NULL)
+      return(NULL);
+   if ((len))
+      memcpy(dup, ptr, len);
+   dup[len] = '\0';
+
+   return(dup);
+}
+
+
+/// copies string into arena
+/// @param[in] arena   reference to arena
+/// @param[in] str     string to copy
+///
+/// @return    Returns pointer to copy or NULL on error
+char *
+ldaputils_arena_strdup(
+         LDAPUtilsArena *              arena,
+         const char *                  str )
+{
+   assert(str != NULL);
+   return(ldaputils_arena_memdup(arena, str, strlen(str)));
+}
+
+/* end of source file */
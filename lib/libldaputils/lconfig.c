@@ -53,6 +53,7 @@
 #include <strings.h>
 #include <fcntl.h>
 #include <assert.h>
+#include <limits.h>
 
 #ifdef HAVE_TERMIOS_H
 #   include <termios.h>
@@ -139,9 +140,10 @@ ldaputils_getopt(
          int                           c,
          const char *                  arg )
 {
-   int      rc;
-   int      valint;
-   char *   endptr;
+   int         rc;
+   int         valint;
+   long long   vallong;
+   char *      endptr;
 
    // checks argument
    switch(c)
@@ -258,6 +260,27 @@ ldaputils_getopt(
       };
       return(0);
 
+      case 'E':
+      if (arg[0] == '!')
+      {
+         lud->pagecrit = 1;
+         arg++;
+      };
+      if (strncasecmp(arg, "pr=", 3) != 0)
+      {
+         fprintf(stderr, "%s: unsupported search extension `%s'\n", lud->prog_name, arg);
+         return(1);
+      };
+      errno   = 0;
+      vallong = strtoll(&arg[3], &endptr, 10);
+      if ( (&arg[3] == endptr) || ((endptr[0] != '\0') && (endptr[0] != '/')) || (errno == ERANGE) || (vallong < 0) || (vallong > INT_MAX) )
+      {
+         fprintf(stderr, "%s: invalid page size `%s'\n", lud->prog_name, &arg[3]);
+         return(1);
+      };
+      lud->pagesize = (int)vallong;
+      return(0);
+
       case 'l':
       valint = atoi(arg);
       if ((rc = ldap_set_option(lud->ld, LDAP_OPT_TIMELIMIT, &valint)) != LDAP_SUCCESS)
@@ -310,6 +333,52 @@ ldaputils_getopt(
 }
 
 
+/// parses numeric argument of program specific option
+/// @param[in]  lud           reference to LDAP utiles descriptor
+/// @param[in]  name          long name of option
+/// @param[in]  arg           getopt argument
+/// @param[in]  min           smallest accepted value
+/// @param[in]  max           largest accepted value
+/// @param[out] valp          reference to store value
+///
+/// @return    If successfull, returns 0.  If the argument is not a number
+///            within range, prints an error and returns 1.
+int
+ldaputils_getopt_size(
+         LDAPUtils *                   lud,
+         const char *                  name,
+         const char *                  arg,
+         size_t                        min,
+         size_t                        max,
+         size_t *                      valp )
+{
+   unsigned long long   val;
+   char *               endptr;
+
+   assert(lud  != NULL);
+   assert(name != NULL);
+   assert(arg  != NULL);
+   assert(valp != NULL);
+
+   // strtoull() accepts and negates a leading minus sign
+   errno  = 0;
+   val    = 0;
+   endptr = NULL;
+   if ( (arg[0] >= '0') && (arg[0] <= '9') )
+      val = strtoull(arg, &endptr, 10);
+   if ( (!(endptr)) || (endptr[0] != '\0') || (errno == ERANGE) || (val < min) || (val > max) )
+   {
+      fprintf(stderr, "%s: --%s must be a number between %zu and %zu\n", lud->prog_name, name, min, max);
+      fprintf(stderr, "Try `%s --help' for more information.\n", lud->prog_name);
+      return(1);
+   };
+
+   *valp = (size_t)val;
+
+   return(0);
+}
+
+
 /// prints configuration to stdout
 /// @param[in] lud  reference to common configuration struct
 void
@@ -412,6 +481,11 @@ ldaputils_params(
    ldaputils_param_print(          "Search Scope:",     str);
    ldaputils_param_int(lud,        "Scope:",            lud->scope);
    ldaputils_param_print(          "Sort Attribute:",   lud->sortattr);
+   ldaputils_param_int(lud,        "Page Size:",        lud->pagesize);
+   ldaputils_param_int(lud,        "VLV Offset:",       lud->vlvoffset);
+   ldaputils_param_int(lud,        "VLV Count:",        lud->vlvcount);
+   ldaputils_param_int(lud,        "Sort Threads:",     lud->sortthreads);
+   ldaputils_param_int(lud,        "Max Memory (MiB):", (int)(lud->maxmemory / 1048576));
    ldaputils_param_option_int(lud, "Time Limit:",       LDAP_OPT_TIMELIMIT);
    ldaputils_param_option_int(lud, "Size Limit:",       LDAP_OPT_SIZELIMIT);
    ldaputils_param_option_int(lud, "Follow Referrals:", LDAP_OPT_REFERRALS);
@@ -694,6 +768,7 @@ ldaputils_usage_search(
       switch(short_options[pos])
       {
          case 'b': printf("  -b basedn                 base dn for search\n"); break;
+         case 'E': printf("  -E [!]pr=size             retrieve results in pages of `size' entries\n"); break;
          case 'l': printf("  -l limit                  time limit (in seconds) for search\n"); break;
          case 'L': printf("  -LL                       disables comments\n"); break;
          case 's': printf("  -s scope                  one of base, one, or sub (search scope)\n"); break;
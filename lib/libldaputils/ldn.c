@@ -0,0 +1,580 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2025 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/ldn.c contains parsed DN functions and variables
+ */
+#define _LIB_LIBLDAPUTILS_LDN_C 1
+#include "ldn.h"
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+// MARK: - Headers
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <assert.h>
+
+#include "larena.h"
+#include "lentry.h"
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+// MARK: - Prototypes
+
+static LDAPUtilsDNCache *
+ldaputils_dn_cache_alloc(
+         size_t                        block_size,
+         size_t                        buckets_size );
+
+
+static int
+ldaputils_dn_cache_grow(
+         LDAPUtilsDNCache *            cache );
+
+
+static const char *
+ldaputils_dn_format(
+         LDAPUtilsDN *                 dn,
+         char **                       strp,
+         unsigned                      flags );
+
+
+static size_t
+ldaputils_dn_hash(
+         size_t                        hash,
+         const char *                  rdn,
+         size_t                        len );
+
+
+static int
+ldaputils_dn_rdns(
+         LDAPUtilsDN *                 pdn,
+         size_t                        first );
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+// MARK: - Functions
+
+/// allocates table of DN suffixes
+/// @param[in] block_size     size of arena blocks or 0 for default
+/// @param[in] buckets_size   initial number of hash buckets, power of two
+///
+/// @return    Returns pointer to table or NULL on error
+LDAPUtilsDNCache *
+ldaputils_dn_cache_alloc(
+         size_t                        block_size,
+         size_t                        buckets_size )
+{
+   LDAPUtilsDNCache *   cache;
+
+   if ((cache = malloc(sizeof(LDAPUtilsDNCache))) == NULL)
+      return(NULL);
+   memset(cache, 0, sizeof(LDAPUtilsDNCache));
+
+   if ((cache->arena = ldaputils_arena_initialize(block_size)) == NULL)
+   {
+      ldaputils_dn_cache_free(cache);
+      return(NULL);
+   };
+
+   if ((cache->buckets = malloc(sizeof(LDAPUtilsDNSuffix *) * buckets_size)) == NULL)
+   {
+      ldaputils_dn_cache_free(cache);
+      return(NULL);
+   };
+   memset(cache->buckets, 0, (sizeof(LDAPUtilsDNSuffix *) * buckets_size));
+   cache->buckets_size = buckets_size;
+
+   return(cache);
+}
+
+
+/// frees table of DN suffixes
+/// @param[in] cache   reference to table
+///
+/// Parsed DNs which share the table must be freed before the table.
+void
+ldaputils_dn_cache_free(
+         LDAPUtilsDNCache *            cache )
+{
+   if (!(cache))
+      return;
+
+   if ((cache->buckets))
+      free(cache->buckets);
+
+   ldaputils_arena_free(cache->arena);
+
+   free(cache);
+
+   return;
+}
+
+
+// doubles number of hash buckets
+int
+ldaputils_dn_cache_grow(
+         LDAPUtilsDNCache *            cache )
+{
+   size_t                  size;
+   size_t                  u;
+   size_t                  pos;
+   LDAPUtilsDNSuffix *     suffix;
+   LDAPUtilsDNSuffix **    buckets;
+
+   assert(cache != NULL);
+
+   size = cache->buckets_size * 2;
+   if ((buckets = malloc(sizeof(LDAPUtilsDNSuffix *) * size)) == NULL)
+      return(LDAP_NO_MEMORY);
+   memset(buckets, 0, (sizeof(LDAPUtilsDNSuffix *) * size));
+
+   for(u = 0; (u < cache->buckets_size); u++)
+   {
+      while ((suffix = cache->buckets[u]) != NULL)
+      {
+         cache->buckets[u] = suffix->next;
+         pos               = suffix->hash & (size - 1);
+         suffix->next      = buckets[pos];
+         buckets[pos]      = suffix;
+      };
+   };
+
+   free(cache->buckets);
+   cache->buckets      = buckets;
+   cache->buckets_size = size;
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// initializes table of DN suffixes
+///
+/// DNs parsed with the same table store each distinct RDN of a shared
+/// parent, such as "ou=people,dc=example,dc=com", once.  The table is not
+/// thread safe.
+///
+/// @return    Returns pointer to table or NULL on error
+/// @see       ldaputils_dn_cache_free, ldaputils_dn_parse
+LDAPUtilsDNCache *
+ldaputils_dn_cache_initialize( void )
+{
+   return(ldaputils_dn_cache_alloc(LDAPUTILS_DN_CACHE_BLOCK_SIZE, LDAPUTILS_DN_CACHE_BUCKETS));
+}
+
+
+// derives DN in another format on first use
+const char *
+ldaputils_dn_format(
+         LDAPUtilsDN *                 dn,
+         char **                       strp,
+         unsigned                      flags )
+{
+   assert(dn   != NULL);
+   assert(strp != NULL);
+
+   if ((*strp))
+      return(*strp);
+
+   if (ldap_dn2str(dn->ldn, strp, flags) != LDAP_SUCCESS)
+      *strp = NULL;
+
+   return(*strp);
+}
+
+
+/// frees parsed DN
+/// @param[in] dn      reference to parsed DN
+void
+ldaputils_dn_free(
+         LDAPUtilsDN *                 dn )
+{
+   if (!(dn))
+      return;
+
+   if ((dn->ldn))
+      ldap_dnfree(dn->ldn);
+
+   if ((dn->ufn))
+      ldap_memfree(dn->ufn);
+   if ((dn->dce))
+      ldap_memfree(dn->dce);
+   if ((dn->adc))
+      ldap_memfree(dn->adc);
+
+   free(dn->rdns);
+   free(dn);
+
+   return;
+}
+
+
+/// retrieves DN in AD canonical format
+/// @param[in] dn      reference to parsed DN
+///
+/// @return    Returns string owned by the parsed DN or NULL on error
+const char *
+ldaputils_dn_get_adc(
+         LDAPUtilsDN *                 dn )
+{
+   assert(dn != NULL);
+   return(ldaputils_dn_format(dn, &dn->adc, LDAP_DN_FORMAT_AD_CANONICAL));
+}
+
+
+/// retrieves RDNs of DN starting with the root
+/// @param[in]  dn      reference to parsed DN
+/// @param[out] lenp    number of RDNs
+///
+/// @return    Returns NULL terminated list of RDNs
+const char * const *
+ldaputils_dn_get_components(
+         const LDAPUtilsDN *           dn,
+         size_t *                      lenp )
+{
+   assert(dn != NULL);
+   if ((lenp))
+      *lenp = dn->components_len;
+   return(dn->components);
+}
+
+
+/// retrieves DN in DCE format
+/// @param[in] dn      reference to parsed DN
+///
+/// @return    Returns string owned by the parsed DN or NULL on error
+const char *
+ldaputils_dn_get_dce(
+         LDAPUtilsDN *                 dn )
+{
+   assert(dn != NULL);
+   return(ldaputils_dn_format(dn, &dn->dce, LDAP_DN_FORMAT_DCE));
+}
+
+
+/// retrieves case folded RDNs of DN starting with the root
+/// @param[in]  dn      reference to parsed DN
+/// @param[out] lenp    number of RDNs
+///
+/// @return    Returns NULL terminated list of RDNs
+const char * const *
+ldaputils_dn_get_normalized(
+         const LDAPUtilsDN *           dn,
+         size_t *                      lenp )
+{
+   assert(dn != NULL);
+   if ((lenp))
+      *lenp = dn->components_len;
+   return(dn->normalized);
+}
+
+
+/// retrieves leftmost RDN of DN
+/// @param[in] dn      reference to parsed DN
+///
+/// @return    Returns RDN or an empty string for the root DSE
+const char *
+ldaputils_dn_get_rdn(
+         const LDAPUtilsDN *           dn )
+{
+   assert(dn != NULL);
+   return( ((dn->components_len)) ? dn->components[dn->components_len-1] : "" );
+}
+
+
+/// retrieves DN in user friendly naming format
+/// @param[in] dn      reference to parsed DN
+///
+/// @return    Returns string owned by the parsed DN or NULL on error
+const char *
+ldaputils_dn_get_ufn(
+         LDAPUtilsDN *                 dn )
+{
+   assert(dn != NULL);
+   return(ldaputils_dn_format(dn, &dn->ufn, LDAP_DN_FORMAT_UFN));
+}
+
+
+// case sensitive FNV-1a hash of RDN chained from hash of parent
+size_t
+ldaputils_dn_hash(
+         size_t                        hash,
+         const char *                  rdn,
+         size_t                        len )
+{
+   size_t   u;
+
+   for(u = 0; (u < len); u++)
+   {
+      hash ^= (unsigned char)rdn[u];
+      hash *= (size_t)0x100000001b3ULL;
+   };
+
+   return(hash);
+}
+
+
+/// retrieves interned suffix of DN
+/// @param[in] cache    reference to table of DN suffixes
+/// @param[in] parent   interned parent suffix or NULL for the root
+/// @param[in] rdn      leftmost RDN of suffix
+/// @param[in] len      length of RDN
+///
+/// RDNs are interned exactly as spelled so that a DN always returns the
+/// RDNs it was parsed from.
+///
+/// @return    Returns suffix owned by the table or NULL on error
+LDAPUtilsDNSuffix *
+ldaputils_dn_intern(
+         LDAPUtilsDNCache *            cache,
+         LDAPUtilsDNSuffix *           parent,
+         const char *                  rdn,
+         size_t                        len )
+{
+   size_t                  hash;
+   size_t                  pos;
+   char *                  str;
+   LDAPUtilsDNSuffix *     suffix;
+
+   assert(cache != NULL);
+   assert(rdn   != NULL);
+
+   hash = ldaputils_dn_hash( (((parent)) ? parent->hash : (size_t)0xcbf29ce484222325ULL), rdn, len);
+
+   // searches for existing suffix
+   for(suffix = cache->buckets[hash & (cache->buckets_size - 1)]; ((suffix)); suffix = suffix->next)
+      if ( (suffix->hash == hash) && (suffix->parent == parent) && (suffix->len == len) && (!(memcmp(suffix->rdn, rdn, len))) )
+         return(suffix);
+
+   // keeps chains short
+   if (cache->count >= cache->buckets_size)
+      if (ldaputils_dn_cache_grow(cache) != LDAP_SUCCESS)
+         return(NULL);
+
+   // stores RDN and case folded RDN
+   if ((suffix = ldaputils_arena_alloc(cache->arena, sizeof(LDAPUtilsDNSuffix))) == NULL)
+      return(NULL);
+   if ((str = ldaputils_arena_alloc(cache->arena, ((len + 1) * 2))) == NULL)
+      return(NULL);
+   memcpy(str, rdn, len);
+   str[len] = '\0';
+   ldaputils_sortkey_fold(&str[len+1], rdn, len);
+   str[(len*2)+1] = '\0';
+
+   suffix->hash   = hash;
+   suffix->len    = len;
+   suffix->depth  = ((parent)) ? (parent->depth + 1) : 1;
+   suffix->rdn    = str;
+   suffix->norm   = &str[len+1];
+   suffix->parent = parent;
+
+   pos                 = hash & (cache->buckets_size - 1);
+   suffix->next        = cache->buckets[pos];
+   cache->buckets[pos] = suffix;
+   cache->count++;
+
+   return(suffix);
+}
+
+
+/// parses DN into RDNs
+/// @param[in] cache   table of DN suffixes shared between DNs or NULL
+/// @param[in] dn      string representation of DN
+///
+/// The RDNs are stored in reverse order, starting with the root, along
+/// with their case folded forms.  When a table is given, the parent RDNs
+/// are interned in the table and only the leftmost RDN is stored with the
+/// parsed DN, so the table grows with the number of distinct parents
+/// rather than the number of DNs.  The UFN, DCE and AD canonical formats
+/// are derived from the parsed DN the first time they are requested.
+///
+/// @return    Returns pointer to parsed DN or NULL on error
+/// @see       ldaputils_dn_cache_initialize, ldaputils_dn_free,
+///            ldaputils_dn_parse_bv
+LDAPUtilsDN *
+ldaputils_dn_parse(
+         LDAPUtilsDNCache *            cache,
+         const char *                  dn )
+{
+   struct berval     bv;
+
+   assert(dn != NULL);
+
+   bv.bv_val = (char *)dn;
+   bv.bv_len = strlen(dn);
+
+   return(ldaputils_dn_parse_bv(cache, &bv));
+}
+
+
+/// parses DN which is not terminated into RDNs
+/// @param[in] cache   table of DN suffixes shared between DNs or NULL
+/// @param[in] dn      DN as a counted string
+///
+/// Allows the DN of a message returned by ldap_get_dn_ber() to be parsed
+/// without first copying it into a string.
+///
+/// @return    Returns pointer to parsed DN or NULL on error
+/// @see       ldaputils_dn_parse
+LDAPUtilsDN *
+ldaputils_dn_parse_bv(
+         LDAPUtilsDNCache *            cache,
+         struct berval *               dn )
+{
+   size_t                  len;
+   size_t                  u;
+   size_t                  first;
+   struct berval           bv;
+   LDAPDN                  ldn;
+   LDAPUtilsDN *           pdn;
+   LDAPUtilsDNSuffix *     suffix;
+
+   assert(dn != NULL);
+
+   // parses DN
+   ldn = NULL;
+   if (ldap_bv2dn(dn, &ldn, LDAP_DN_FORMAT_LDAP) != LDAP_SUCCESS)
+      return(NULL);
+   for(len = 0; ( ((ldn)) && ((ldn[len])) ); len++);
+
+   // allocates parsed DN and lists of RDNs in one block
+   if ((pdn = malloc(sizeof(LDAPUtilsDN) + (sizeof(char *) * (len+1) * 2))) == NULL)
+   {
+      if ((ldn))
+         ldap_dnfree(ldn);
+      return(NULL);
+   };
+   memset(pdn, 0, sizeof(LDAPUtilsDN));
+   pdn->ldn             = ldn;
+   pdn->components_len  = len;
+   pdn->components      = (const char **)&pdn[1];
+   pdn->normalized      = &pdn->components[len+1];
+   pdn->components[len] = NULL;
+   pdn->normalized[len] = NULL;
+
+   // interns parent RDNs starting with the root
+   suffix = NULL;
+   first  = ( ((cache)) && ((len)) ) ? (len - 1) : 0;
+   for(u = 0; (u < first); u++)
+   {
+      if (ldap_rdn2bv(ldn[len-u-1], &bv, (LDAP_DN_FORMAT_LDAPV3 | LDAP_DN_PRETTY)) != LDAP_SUCCESS)
+      {
+         ldaputils_dn_free(pdn);
+         return(NULL);
+      };
+      suffix = ldaputils_dn_intern(cache, suffix, bv.bv_val, bv.bv_len);
+      ldap_memfree(bv.bv_val);
+      if (!(suffix))
+      {
+         ldaputils_dn_free(pdn);
+         return(NULL);
+      };
+      pdn->components[u] = suffix->rdn;
+      pdn->normalized[u] = suffix->norm;
+   };
+   pdn->suffix = suffix;
+
+   // stores remaining RDNs with the parsed DN
+   if (ldaputils_dn_rdns(pdn, first) != LDAP_SUCCESS)
+   {
+      ldaputils_dn_free(pdn);
+      return(NULL);
+   };
+
+   return(pdn);
+}
+
+
+// stores RDNs which are not interned, and their case folded forms, in a
+// single buffer owned by the parsed DN
+int
+ldaputils_dn_rdns(
+         LDAPUtilsDN *                 pdn,
+         size_t                        first )
+{
+   size_t            u;
+   size_t            len;
+   size_t            size;
+   char *            str;
+   struct berval     bv;
+
+   if (first >= pdn->components_len)
+      return(LDAP_SUCCESS);
+
+   // encodes RDNs and holds them in the list until the buffer is allocated
+   size = 0;
+   for(u = first; (u < pdn->components_len); u++)
+   {
+      if (ldap_rdn2bv(pdn->ldn[pdn->components_len-u-1], &bv, (LDAP_DN_FORMAT_LDAPV3 | LDAP_DN_PRETTY)) != LDAP_SUCCESS)
+         break;
+      pdn->components[u] = bv.bv_val;
+      size += (bv.bv_len + 1) * 2;
+   };
+   if ( (u < pdn->components_len) || ((pdn->rdns = malloc(size)) == NULL) )
+   {
+      while(u > first)
+         ldap_memfree((char *)pdn->components[--u]);
+      pdn->components[first] = NULL;
+      return(LDAP_NO_MEMORY);
+   };
+
+   // copies RDNs into buffer
+   str = pdn->rdns;
+   for(u = first; (u < pdn->components_len); u++)
+   {
+      len = strlen(pdn->components[u]);
+      memcpy(str, pdn->components[u], len);
+      str[len] = '\0';
+      ldaputils_sortkey_fold(&str[len+1], str, len);
+      str[(len*2)+1] = '\0';
+      ldap_memfree((char *)pdn->components[u]);
+      pdn->components[u] = str;
+      pdn->normalized[u] = &str[len+1];
+      str += (len + 1) * 2;
+   };
+
+   return(LDAP_SUCCESS);
+}
+
+/* end of source file */
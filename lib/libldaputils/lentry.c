@@ -52,6 +52,18 @@
 #include <assert.h>
 
 #include "lconfig.h"
+#include "larena.h"
+#include "lsort.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+// MARK: - Definitions
+
+#define LDAPUTILS_INDEX_MIN_SIZE 16
 
 
 //////////////////
@@ -94,6 +106,45 @@ ldaputils_entries_initialize(
          void );
 
 
+static LDAPUtilsEntry *
+ldaputils_entry_arena(
+         LDAPUtilsArena *              arena,
+         LDAP *                        ld,
+         LDAPMessage *                 msg,
+         const char *                  sortattr,
+         int                           view );
+
+
+static int
+ldaputils_entry_index(
+         LDAPUtilsEntry *              entry,
+         size_t                        count );
+
+
+static LDAPUtilsAttribute **
+ldaputils_entry_index_slot(
+         LDAPUtilsEntry *              entry,
+         const char *                  name );
+
+
+static int
+ldaputils_entry_keys(
+         LDAPUtilsEntry *              entry );
+
+
+static size_t
+ldaputils_entry_index_hash(
+         const char *                  name );
+
+
+static LDAPUtilsEntries *
+ldaputils_get_entries_arena(
+         LDAP *                        ld,
+         LDAPMessage *                 res,
+         const char *                  sortattr,
+         int                           view );
+
+
 static struct berval **
 ldaputils_values_len_copy(
          struct berval **              vals );
@@ -250,7 +301,8 @@ ldaputils_berval_cmp(
          const struct berval **        ptr1,
          const struct berval **        ptr2 )
 {
-   int rc;
+   int      rc;
+   size_t   len;
 
    // quick check of the arguments
    if ( (!(ptr1)) && (!(ptr2)) )
@@ -268,12 +320,17 @@ ldaputils_berval_cmp(
    if (!(*ptr2))
       return(1);
 
+   // values may not be terminated, so only compare the common length
+   len = ((*ptr1)->bv_len < (*ptr2)->bv_len) ? (*ptr1)->bv_len : (*ptr2)->bv_len;
+
    // case insensitive compare
-   if ((rc = strcasecmp((*ptr1)->bv_val, (*ptr2)->bv_val)))
+   if ((rc = strncasecmp((*ptr1)->bv_val, (*ptr2)->bv_val, len)))
       return(rc);
+   if ((*ptr1)->bv_len != (*ptr2)->bv_len)
+      return(((*ptr1)->bv_len < (*ptr2)->bv_len) ? -1 : 1);
 
    // case sensitive compare
-   if ((rc = strcmp((*ptr1)->bv_val, (*ptr2)->bv_val)))
+   if ((rc = memcmp((*ptr1)->bv_val, (*ptr2)->bv_val, len)))
       return(rc);
 
    // fall back to comparing memory location
@@ -293,17 +350,21 @@ ldaputils_entries_add_entry(
          LDAPUtilsEntries *            entries,
          LDAPUtilsEntry *              entry )
 {
-   size_t            len;
+   size_t            size;
    LDAPUtilsEntry ** list;
 
    assert(entries != NULL);
    assert(entry   != NULL);
 
    // increase size of entry array
-   len = sizeof(LDAPUtilsEntry *) * (entries->count + 2);
-   if ((list = realloc(entries->list, len)) == NULL)
-      return(LDAP_NO_MEMORY);
-   entries->list = list;
+   if ((entries->count + 2) > entries->size)
+   {
+      size = (entries->size < 32) ? 32 : (entries->size * 2);
+      if ((list = realloc(entries->list, (sizeof(LDAPUtilsEntry *) * size))) == NULL)
+         return(LDAP_NO_MEMORY);
+      entries->list = list;
+      entries->size = size;
+   };
 
    // save entry reference to list
    entries->list[entries->count++] = entry;
@@ -315,6 +376,9 @@ ldaputils_entries_add_entry(
 
 /// frees list of entries
 /// @param[in] entries   list of entries to free
+///
+/// Entries allocated from the arena of the list are released with the
+/// arena instead of individually.
 void
 ldaputils_entries_free(
          LDAPUtilsEntries *            entries )
@@ -325,11 +389,17 @@ ldaputils_entries_free(
 
    if ((entries->list))
    {
-      for(x = 0; x < entries->count; x++)
-         ldaputils_entry_free(entries->list[x]);
+      if (!(entries->arena))
+         for(x = 0; x < entries->count; x++)
+            ldaputils_entry_free(entries->list[x]);
       free(entries->list);
    };
 
+   ldaputils_arena_free(entries->arena);
+
+   if ((entries->res))
+      ldap_msgfree(entries->res);
+
    free(entries);
 
    return;
@@ -355,6 +425,7 @@ ldaputils_entries_initialize(
       return(NULL);
    };
    memset(entries->list, 0, sizeof(LDAPUtilsEntry *));
+   entries->size = 1;
 
    return(entries);
 }
@@ -379,54 +450,233 @@ ldaputils_entries_sort(
 }
 
 
+/// sorts entries using multiple threads
+/// @param[in] entries   list of entries to sort
+/// @param[in] compar    compare function to use for sorting entries
+/// @param[in] threads   maximum number of threads to use
+///
+/// @return    Return 0 on success or -1 on error,
+/// @see       ldaputils_entries_sort
+int
+ldaputils_entries_sort_parallel(
+         LDAPUtilsEntries *            entries,
+         int                           (*compar)(const void *, const void *),
+         size_t                        threads )
+{
+   assert(entries != NULL);
+
+   if (compar == NULL)
+      compar = ldaputils_entry_cmp;
+   if (ldaputils_sort(entries->list, entries->count, sizeof(LDAPUtilsEntry *), compar, threads) != LDAP_SUCCESS)
+      return(-1);
+   return(0);
+}
+
+
 int
 ldaputils_entry_add_attribute(
          LDAPUtilsEntry *              entry,
          const char *                  name,
          struct berval **              vals )
 {
-   size_t                  u;
-   size_t                  size;
    int                     err;
+   size_t                  size;
    void *                  ptr;
+   LDAPUtilsAttribute **   slot;
+
+   assert(entry        != NULL);
+   assert(name         != NULL);
+   assert(entry->arena == NULL);
+
+   // grows index to keep it at most half full
+   if ((err = ldaputils_entry_index(entry, (entry->attrs_count + 1))) != LDAP_SUCCESS)
+      return(err);
+
+   // adds values to existing attribute
+   slot = ldaputils_entry_index_slot(entry, name);
+   if ((*slot))
+      return(ldaputils_attribute_add_values(*slot, vals));
+
+   // resize attribute array
+   if ((entry->attrs_count + 2) > entry->attrs_size)
+   {
+      size = ((entry->attrs_size)) ? (entry->attrs_size * 2) : 8;
+      if ((ptr = realloc(entry->attrs, (sizeof(LDAPUtilsAttribute *) * size))) == NULL)
+         return(LDAP_NO_MEMORY);
+      entry->attrs      = ptr;
+      entry->attrs_size = size;
+   };
+
+   // allocate and assign attributes
+   if ((entry->attrs[entry->attrs_count] = ldaputils_attribute_initialize(name, vals)) == NULL)
+      return(LDAP_NO_MEMORY);
+   *slot = entry->attrs[entry->attrs_count];
+   entry->attrs_count++;
+   entry->attrs[entry->attrs_count] = NULL;
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// copies LDAP entry into arena
+/// @param[in] arena       arena which owns the entry
+/// @param[in] ld          refernce to LDAP socket data
+/// @param[in] msg         refernce to LDAP search entry
+/// @param[in] sortattr    attribute to use for sorting entries
+/// @param[in] view        reference values within msg instead of copying
+///
+/// The entry, DN, DN components, attributes and values are allocated from
+/// the arena and are released when the arena is freed.  Copied values are
+/// terminated with a NUL byte which is not included in the value length.
+/// If view is set, the values point into the BER encoded msg, are not NUL
+/// terminated, and are only valid while msg is allocated.
+///
+/// @return    Returns entry or NULL on error
+LDAPUtilsEntry *
+ldaputils_entry_arena(
+         LDAPUtilsArena *              arena,
+         LDAP *                        ld,
+         LDAPMessage *                 msg,
+         const char *                  sortattr,
+         int                           view )
+{
+   int                     rc;
+   size_t                  len;
+   size_t                  size;
+   size_t                  u;
+   char **                 dns;
+   void *                  ptr;
+   BerElement *            ber;
+   BerVarray               vals;
+   struct berval           bv;
+   struct berval *         bvs;
    LDAPUtilsAttribute *    attr;
+   LDAPUtilsEntry *        entry;
 
-   assert(entry != NULL);
-   assert(name  != NULL);
+   assert(arena != NULL);
+   assert(ld    != NULL);
+   assert(msg   != NULL);
+
+   if ((entry = ldaputils_arena_alloc(arena, sizeof(LDAPUtilsEntry))) == NULL)
+      return(NULL);
+   memset(entry, 0, sizeof(LDAPUtilsEntry));
+   entry->arena = arena;
+
+   // copies DN
+   ber = NULL;
+   if (ldap_get_dn_ber(ld, msg, &ber, &bv) != LDAP_SUCCESS)
+   {
+      if ((ber))
+         ber_free(ber, 0);
+      return(NULL);
+   };
+   if ((entry->dn = ldaputils_arena_memdup(arena, bv.bv_val, bv.bv_len)) == NULL)
+   {
+      ber_free(ber, 0);
+      return(NULL);
+   };
 
-   // find existing attribute
-   attr = NULL;
-   for(u = 0; u < entry->attrs_count; u++)
+   // copies DN components in reverse order
+   if ((dns = ldap_explode_dn(entry->dn, 0)) == NULL)
    {
-      if (!(strcmp(entry->attrs[u]->name, name)))
+      ber_free(ber, 0);
+      return(NULL);
+   };
+   for(len = 0; ((dns[len])); len++);
+   if ((entry->components = ldaputils_arena_alloc(arena, (sizeof(char *) * (len+1)))) == NULL)
+   {
+      ldaputils_value_free(dns);
+      ber_free(ber, 0);
+      return(NULL);
+   };
+   for(u = 0; u < len; u++)
+   {
+      if ((entry->components[len-u-1] = ldaputils_arena_strdup(arena, dns[u])) == NULL)
+      {
+         ldaputils_value_free(dns);
+         ber_free(ber, 0);
+         return(NULL);
+      };
+   };
+   entry->components[len] = NULL;
+   entry->components_len  = len;
+   entry->rdn             = ((len)) ? entry->components[len-1] : entry->dn;
+   ldaputils_value_free(dns);
+
+   // copies attributes
+   vals = NULL;
+   for(rc = ldap_get_attribute_ber(ld, msg, ber, &bv, &vals); ((rc == LDAP_SUCCESS) && ((bv.bv_val))); rc = ldap_get_attribute_ber(ld, msg, ber, &bv, &vals))
+   {
+      for(len = 0; ( ((vals)) && ((vals[len].bv_val)) ); len++);
+
+      // grows attribute list
+      if ((entry->attrs_count + 2) > entry->attrs_size)
+      {
+         size = ((entry->attrs_size)) ? (entry->attrs_size * 2) : 16;
+         if ((ptr = ldaputils_arena_alloc(arena, (sizeof(LDAPUtilsAttribute *) * size))) == NULL)
+            break;
+         if ((entry->attrs))
+            memcpy(ptr, entry->attrs, (sizeof(LDAPUtilsAttribute *) * entry->attrs_count));
+         entry->attrs      = ptr;
+         entry->attrs_size = size;
+      };
+
+      // copies values
+      attr = ldaputils_arena_alloc(arena, sizeof(LDAPUtilsAttribute));
+      bvs  = ldaputils_arena_alloc(arena, (sizeof(struct berval) * len));
+      ptr  = ldaputils_arena_alloc(arena, (sizeof(struct berval *) * (len+1)));
+      if ( (!(attr)) || (!(bvs)) || (!(ptr)) || ((attr->name = ldaputils_arena_memdup(arena, bv.bv_val, bv.bv_len)) == NULL) )
+         break;
+      attr->vals = ptr;
+      attr->len  = len;
+      for(u = 0; u < len; u++)
+      {
+         bvs[u] = vals[u];
+         if (!(view))
+            if ((bvs[u].bv_val = ldaputils_arena_memdup(arena, vals[u].bv_val, vals[u].bv_len)) == NULL)
+               break;
+         attr->vals[u] = &bvs[u];
+      };
+      if (u < len)
+         break;
+      attr->vals[len] = NULL;
+      ldaputils_values_sort(attr->vals);
+
+      // saves sort value
+      if ( ((sortattr)) && ((len)) && (!(strcasecmp(sortattr, attr->name))) )
       {
-         attr = entry->attrs[u];
-         u = entry->attrs_count;
+         entry->sortval = attr->vals[0]->bv_val;
+         if ((view))
+            if ((entry->sortval = ldaputils_arena_memdup(arena, attr->vals[0]->bv_val, attr->vals[0]->bv_len)) == NULL)
+               break;
       };
+
+      entry->attrs[entry->attrs_count++] = attr;
+      entry->attrs[entry->attrs_count]   = NULL;
+
+      if ((vals))
+         ber_memfree(vals);
+      vals = NULL;
    };
+   ber_free(ber, 0);
 
-   // adds values
-   if ((attr))
+   // reports allocation error from attribute loop
+   if ( (rc == LDAP_SUCCESS) && ((bv.bv_val)) )
    {
-      if ((err = ldaputils_attribute_add_values(attr, vals)) != LDAP_SUCCESS)
-         return(err);
-      return(LDAP_SUCCESS);
+      if ((vals))
+         ber_memfree(vals);
+      return(NULL);
    };
 
-   // resize attribute array
-   size = sizeof(LDAPUtilsAttribute *) * (entry->attrs_count + 2);
-   if ((ptr = realloc(entry->attrs, size)) == NULL)
-      return(LDAP_NO_MEMORY);
-   entry->attrs                       = ptr;
-   entry->attrs[entry->attrs_count+0] = NULL;
-   entry->attrs[entry->attrs_count+1] = NULL;
+   // indexes attributes
+   if (ldaputils_entry_index(entry, entry->attrs_count) != LDAP_SUCCESS)
+      return(NULL);
 
-   // allocate and assign attributes
-   if ((entry->attrs[entry->attrs_count] = ldaputils_attribute_initialize(name, vals)) == NULL)
-      return(LDAP_NO_MEMORY);
-   entry->attrs_count++;
+   // generates sort keys
+   if (ldaputils_entry_keys(entry) != LDAP_SUCCESS)
+      return(NULL);
 
-   return(LDAP_SUCCESS);
+   return(entry);
 }
 
 
@@ -469,7 +719,12 @@ ldaputils_entry_cmp(
       return(1);
 
    // compare of sort value
-   if ((rc = strcasecmp(e1->sortval, e2->sortval)))
+   if ( ((e1->sortkey.bv_val)) && ((e2->sortkey.bv_val)) )
+   {
+      if ((rc = ldaputils_sortkey_cmp(&e1->sortkey, &e2->sortkey)))
+         return(rc);
+   }
+   else if ((rc = strcasecmp(e1->sortval, e2->sortval)))
       return(rc);
    if ((rc = strcmp(e1->sortval, e2->sortval)))
       return(rc);
@@ -511,6 +766,17 @@ ldaputils_entry_cmp_dn(
    if (!(e2))
       return(1);
 
+   // compare of case folded DN components
+   if ( ((e1->dnkey.bv_val)) && ((e2->dnkey.bv_val)) )
+   {
+      if ((rc = ldaputils_sortkey_cmp(&e1->dnkey, &e2->dnkey)))
+         return(rc);
+      for(u = 0; u < e1->components_len; u++)
+         if ((rc = strcmp(e1->components[u], e2->components[u])))
+            return(rc);
+      return(0);
+   };
+
    if ( (!(e1->components)) || (!(e2->components)) )
    {
       if ((rc = strcasecmp(e1->dn, e2->dn)))
@@ -574,6 +840,14 @@ ldaputils_entry_copy(
       };
       new->attrs_count++;
    };
+   new->attrs_size = entry->attrs_count + 1;
+
+   // indexes attributes
+   if (ldaputils_entry_index(new, new->attrs_count) != LDAP_SUCCESS)
+   {
+      ldaputils_entry_free(new);
+      return(NULL);
+   };
 
    return(new);
 }
@@ -588,17 +862,25 @@ ldaputils_entry_free(
 
    assert(entry != NULL);
 
+   // entry is released with its arena
+   if ((entry->arena))
+      return;
+
    if (entry->dn != NULL)
       ldap_memfree(entry->dn);
    entry->dn = NULL;
 
-   // frees sort value
+   // frees sort value and sort keys
    if (entry->sortval != NULL)
       free(entry->sortval);
+   if (entry->sortkey.bv_val != NULL)
+      free(entry->sortkey.bv_val);
+   if (entry->dnkey.bv_val != NULL)
+      free(entry->dnkey.bv_val);
 
    // frees DN components
-   if (entry->components != NULL)
-      free(entry->components);
+   if (entry->pdn != NULL)
+      ldaputils_dn_free(entry->pdn);
 
    // frees attributes
    if (entry->attrs != NULL)
@@ -620,51 +902,270 @@ ldaputils_entry_free(
       entry->attrs = NULL;
    };
 
+   // frees attribute index
+   if (entry->index != NULL)
+      free(entry->index);
+
    free(entry);
 
    return;
 }
 
 
+/// retrieves values of attribute
+/// @param[in] entry       reference to entry
+/// @param[in] name        attribute description, including any options
+/// @param[out] lenp       returns number of values if not NULL
+///
+/// Attribute descriptions are matched case insensitively using the index
+/// of the entry.  Options are part of the description, so "cn" and
+/// "cn;lang-en" are distinct attributes.
+///
+/// @return    Returns NULL terminated array of values or NULL if the entry
+///            does not contain the attribute.
+const struct berval * const *
+ldaputils_entry_get_attribute(
+         LDAPUtilsEntry *              entry,
+         const char *                  name,
+         size_t *                      lenp )
+{
+   LDAPUtilsAttribute **   slot;
+
+   assert(entry != NULL);
+   assert(name  != NULL);
+
+   if ((lenp))
+      *lenp = 0;
+
+   if (!(entry->index_size))
+      return(NULL);
+   if ((slot = ldaputils_entry_index_slot(entry, name)) == NULL)
+      return(NULL);
+   if (!(*slot))
+      return(NULL);
+
+   if ((lenp))
+      *lenp = (*slot)->len;
+
+   return((const struct berval * const *)(*slot)->vals);
+}
+
+
+/// sizes attribute index to hold count attributes
+/// @param[in] entry       reference to entry
+/// @param[in] count       number of attributes the index must hold
+///
+/// The index is rebuilt if it would be more than half full.  Indexes of
+/// entries owned by an arena are allocated from the arena.
+///
+/// @return    Returns LDAP_SUCCESS or LDAP_NO_MEMORY
+int
+ldaputils_entry_index(
+         LDAPUtilsEntry *              entry,
+         size_t                        count )
+{
+   size_t                  size;
+   size_t                  u;
+   LDAPUtilsAttribute **   index;
+   LDAPUtilsAttribute **   old;
+   LDAPUtilsAttribute **   slot;
+
+   assert(entry != NULL);
+
+   if ((count * 2) <= entry->index_size)
+      return(LDAP_SUCCESS);
+
+   for(size = LDAPUTILS_INDEX_MIN_SIZE; (size < (count * 2)); size *= 2);
+
+   if ((entry->arena))
+      index = ldaputils_arena_alloc(entry->arena, (sizeof(LDAPUtilsAttribute *) * size));
+   else
+      index = malloc(sizeof(LDAPUtilsAttribute *) * size);
+   if (!(index))
+      return(LDAP_NO_MEMORY);
+   memset(index, 0, (sizeof(LDAPUtilsAttribute *) * size));
+
+   old               = entry->index;
+   entry->index      = index;
+   entry->index_size = size;
+   for(u = 0; (u < entry->attrs_count); u++)
+   {
+      slot  = ldaputils_entry_index_slot(entry, entry->attrs[u]->name);
+      *slot = entry->attrs[u];
+   };
+
+   if ( ((old)) && (!(entry->arena)) )
+      free(old);
+
+   return(LDAP_SUCCESS);
+}
+
+
+// case insensitive FNV-1a hash of attribute description
+size_t
+ldaputils_entry_index_hash(
+         const char *                  name )
+{
+   size_t         hash;
+   unsigned char  c;
+
+   assert(name != NULL);
+
+   hash = (size_t)2166136261U;
+   for(; ((*name)); name++)
+   {
+      c     = (unsigned char)*name;
+      hash ^= (size_t)( ((c >= 'A') && (c <= 'Z')) ? (c | 0x20) : c );
+      hash *= (size_t)16777619U;
+   };
+
+   return(hash);
+}
+
+
+/// finds index slot of attribute
+/// @param[in] entry       reference to entry
+/// @param[in] name        attribute description
+///
+/// @return    Returns slot containing the attribute, or the empty slot in
+///            which the attribute would be stored.
+LDAPUtilsAttribute **
+ldaputils_entry_index_slot(
+         LDAPUtilsEntry *              entry,
+         const char *                  name )
+{
+   size_t   mask;
+   size_t   pos;
+
+   assert(entry             != NULL);
+   assert(entry->index_size != 0);
+
+   // linear probing always finds an empty slot since the index is at
+   // most half full
+   mask = entry->index_size - 1;
+   for(pos = ldaputils_entry_index_hash(name) & mask; ((entry->index[pos])); pos = (pos + 1) & mask)
+      if (!(strcasecmp(entry->index[pos]->name, name)))
+         break;
+
+   return(&entry->index[pos]);
+}
+
+
 // initializes list of entries
 LDAPUtilsEntry *
 ldaputils_entry_initialize(
          const char *                  dn )
 {
-   size_t           len;
-   size_t           u;
-   char           * str;
+   LDAPUtilsDN *     pdn;
+
+   assert(dn != NULL);
+
+   if ((pdn = ldaputils_dn_parse(NULL, dn)) == NULL)
+      return(NULL);
+
+   return(ldaputils_entry_initialize_dn(dn, pdn));
+}
+
+
+/// initializes entry from parsed DN
+/// @param[in] dn      string representation of DN
+/// @param[in] pdn     parsed DN
+///
+/// The entry takes ownership of the parsed DN, even on error, and uses its
+/// RDNs as the DN components of the entry.
+///
+/// @return    Returns pointer to entry or NULL on error
+LDAPUtilsEntry *
+ldaputils_entry_initialize_dn(
+         const char *                  dn,
+         LDAPUtilsDN *                 pdn )
+{
    LDAPUtilsEntry * entry;
 
+   assert(dn  != NULL);
+   assert(pdn != NULL);
+
    // initialize memory
    if ((entry = malloc(sizeof(LDAPUtilsEntry))) == NULL)
+   {
+      ldaputils_dn_free(pdn);
       return(NULL);
+   };
    memset(entry, 0, sizeof(LDAPUtilsEntry));
+   entry->pdn = pdn;
 
    // copy dn
    if ((entry->dn = strdup(dn)) == NULL)
    {
-      free(entry);
+      ldaputils_entry_free(entry);
       return(NULL);
    };
 
-   // breaks DN into components
-   if ((entry->components = ldap_explode_dn(entry->dn, 0)) == NULL)
+   // uses RDNs of parsed DN as components
+   entry->components     = pdn->components;
+   entry->components_len = pdn->components_len;
+   entry->rdn            = ldaputils_dn_get_rdn(pdn);
+
+   // generates sort keys
+   if (ldaputils_entry_keys(entry) != LDAP_SUCCESS)
    {
       ldaputils_entry_free(entry);
       return(NULL);
    };
-   entry->rdn = entry->components[0];
-   for(len = 0; (entry->components[len] != NULL); len++);
-   entry->components_len = len;
-   for(u = 0; (u < (len/2)); u++)
+
+   return(entry);
+}
+
+
+/// generates case folded sort keys of entry
+/// @param[in] entry       reference to entry
+///
+/// The DN key joins the case folded DN components, starting with the
+/// root, with NUL bytes so that a single memcmp() orders entries the same
+/// as comparing each component.  Keys of entries owned by an arena are
+/// allocated from the arena.
+///
+/// @return    Returns LDAP_SUCCESS or LDAP_NO_MEMORY
+int
+ldaputils_entry_keys(
+         LDAPUtilsEntry *              entry )
+{
+   size_t      len;
+   size_t      u;
+   char *      str;
+
+   assert(entry != NULL);
+
+   // generates sort value key
+   if ( ((entry->sortval)) && (!(entry->sortkey.bv_val)) )
    {
-      str                        = entry->components[u];
-      entry->components[u]       = entry->components[len-u-1];
-      entry->components[len-u-1] = str;
+      len = strlen(entry->sortval);
+      str = ((entry->arena)) ? ldaputils_arena_alloc(entry->arena, (len+1)) : malloc(len+1);
+      if (!(str))
+         return(LDAP_NO_MEMORY);
+      entry->sortkey.bv_val = str;
+      entry->sortkey.bv_len = ldaputils_sortkey_fold(str, entry->sortval, len);
+      str[len]              = '\0';
    };
 
-   return(entry);
+   // generates DN key
+   if ( ((entry->components)) && (!(entry->dnkey.bv_val)) )
+   {
+      for(len = 0, u = 0; u < entry->components_len; u++)
+         len += strlen(entry->components[u]) + 1;
+      str = ((entry->arena)) ? ldaputils_arena_alloc(entry->arena, (len+1)) : malloc(len+1);
+      if (!(str))
+         return(LDAP_NO_MEMORY);
+      entry->dnkey.bv_val = str;
+      for(u = 0; u < entry->components_len; u++)
+      {
+         str   += ldaputils_sortkey_fold(str, entry->components[u], strlen(entry->components[u]));
+         *str++ = '\0';
+      };
+      entry->dnkey.bv_len = ((len)) ? (len - 1) : 0;
+   };
+
+   return(LDAP_SUCCESS);
 }
 
 
@@ -694,19 +1195,31 @@ ldaputils_next_entry(
 /// @param[in] res         refernce to LDAP result message
 /// @param[in] sortattr    attribute to use for sorting entries
 ///
+/// The entries are allocated from an arena owned by the list, so the
+/// entries are released together by ldaputils_entries_free().
+///
 /// @return    Returns sorted array of LDAPUtilsEntries
+/// @see       ldaputils_get_entries_view
 LDAPUtilsEntries *
 ldaputils_get_entries(
          LDAP *                        ld,
          LDAPMessage *                 res,
          const char *                  sortattr )
+{
+   return(ldaputils_get_entries_arena(ld, res, sortattr, 0));
+}
+
+
+// retrieves LDAP entries from result into arena
+LDAPUtilsEntries *
+ldaputils_get_entries_arena(
+         LDAP *                        ld,
+         LDAPMessage *                 res,
+         const char *                  sortattr,
+         int                           view )
 {
    int                  err;
-   char *               name;
-   char *               str;
-   BerElement *         ber;
    LDAPMessage *        msg;
-   struct berval **     vals;
    LDAPUtilsEntry *     entry;
    LDAPUtilsEntries *   entries;
 
@@ -715,49 +1228,54 @@ ldaputils_get_entries(
 
    if ((entries = ldaputils_entries_initialize()) == NULL)
       return(NULL);
+   if ((entries->arena = ldaputils_arena_initialize(0)) == NULL)
+   {
+      ldaputils_entries_free(entries);
+      return(NULL);
+   };
 
-   msg = ldap_first_entry(ld, res);
-   while(msg)
+   for(msg = ldap_first_entry(ld, res); ((msg)); msg = ldap_next_entry(ld, msg))
    {
-      // initial entry
-      if ((str = ldap_get_dn(ld, msg)) == NULL)
+      if ((entry = ldaputils_entry_arena(entries->arena, ld, msg, sortattr, view)) == NULL)
       {
          ldaputils_entries_free(entries);
          return(NULL);
       };
-      if ((entry = ldaputils_entry_initialize(str)) == NULL)
+      if ((err = ldaputils_entries_add_entry(entries, entry)) != LDAP_SUCCESS)
       {
-         free(str);
          ldaputils_entries_free(entries);
          return(NULL);
       };
-      free(str);
+   };
 
-      // retrieves attributes
-      name = ldap_first_attribute(ld, msg, &ber);
-      while(name != NULL)
-      {
-         // retrieve values
-         if ((vals = ldap_get_values_len(ld, msg, name)) != NULL)
-         {
-            ldaputils_entry_add_attribute(entry, name, vals);
-            if ( ((sortattr)) && (!(strcasecmp(sortattr, name))) )
-            {
-               ldaputils_values_sort(vals);
-               entry->sortval = strdup(vals[0]->bv_val);
-            };
-            ldaputils_value_free_len(vals);
-         };
-
-         name = ldap_next_attribute(ld, msg, ber);
-      };
-      ber_free(ber, 0);
+   return(entries);
+}
 
-      if ((err = ldaputils_entries_add_entry(entries, entry)) != LDAP_SUCCESS)
-         ldaputils_entry_free(entry);
 
-      msg = ldap_next_entry(ld, msg);
-   };
+/// retrieves LDAP entries from result without copying values
+/// @param[in] ld          refernce to LDAP socket data
+/// @param[in] res         refernce to LDAP result message
+/// @param[in] sortattr    attribute to use for sorting entries
+///
+/// The attribute values of the entries point into the BER encoded result
+/// instead of being copied and are not NUL terminated.  On success the list
+/// takes ownership of res, which is freed by ldaputils_entries_free(), so
+/// the values remain valid for the life of the list.  On error the caller
+/// retains ownership of res.
+///
+/// @return    Returns sorted array of LDAPUtilsEntries
+/// @see       ldaputils_get_entries
+LDAPUtilsEntries *
+ldaputils_get_entries_view(
+         LDAP *                        ld,
+         LDAPMessage *                 res,
+         const char *                  sortattr )
+{
+   LDAPUtilsEntries *   entries;
+
+   if ((entries = ldaputils_get_entries_arena(ld, res, sortattr, 1)) == NULL)
+      return(NULL);
+   entries->res = res;
 
    return(entries);
 }
@@ -890,6 +1408,58 @@ ldaputils_values_len_copy(
 }
 
 
+/// compares two case folded sort keys
+/// @param[in] key1   first sort key
+/// @param[in] key2   second sort key
+///
+/// @return    Returns an integer less than, equal to, or greater than zero
+///            if key1 sorts before, with, or after key2.
+int
+ldaputils_sortkey_cmp(
+         const struct berval *         key1,
+         const struct berval *         key2 )
+{
+   int      rc;
+
+   assert(key1 != NULL);
+   assert(key2 != NULL);
+
+   if ((rc = memcmp(key1->bv_val, key2->bv_val, ((key1->bv_len < key2->bv_len) ? key1->bv_len : key2->bv_len))))
+      return(rc);
+   if (key1->bv_len != key2->bv_len)
+      return((key1->bv_len < key2->bv_len) ? -1 : 1);
+   return(0);
+}
+
+
+/// copies value as case folded sort key
+/// @param[out] dst   buffer of at least len bytes
+/// @param[in]  src   value to fold
+/// @param[in]  len   length of value
+///
+/// Only ASCII letters are folded, which matches the case insensitive
+/// ordering of strcasecmp() in the C locale.
+///
+/// @return    Returns number of bytes written to dst
+size_t
+ldaputils_sortkey_fold(
+         char *                        dst,
+         const char *                  src,
+         size_t                        len )
+{
+   size_t         u;
+   unsigned char  c;
+
+   for(u = 0; u < len; u++)
+   {
+      c      = (unsigned char)src[u];
+      dst[u] = (char)( ((c >= 'A') && (c <= 'Z')) ? (c | 0x20) : c );
+   };
+
+   return(len);
+}
+
+
 void
 ldaputils_value_free(
          char **                       vals )
@@ -78,4 +78,23 @@ extern LDAPUtilsEntry *
 ldaputils_entry_initialize(
          const char *                  dn );
 
+
+extern LDAPUtilsEntry *
+ldaputils_entry_initialize_dn(
+         const char *                  dn,
+         LDAPUtilsDN *                 pdn );
+
+
+extern int
+ldaputils_sortkey_cmp(
+         const struct berval *         key1,
+         const struct berval *         key2 );
+
+
+extern size_t
+ldaputils_sortkey_fold(
+         char *                        dst,
+         const char *                  src,
+         size_t                        len );
+
 #endif /* end of header file */
@@ -49,6 +49,7 @@
 #   include <config.h>
 #endif
 
+#include <stdio.h>
 #include <ldap.h>
 #include <ldaputils.h>
 
@@ -68,6 +69,83 @@
 /////////////////
 // MARK: - Datatypes
 
+typedef struct ldap_utils_arena        LDAPUtilsArena;
+typedef struct ldap_utils_arena_block  LDAPUtilsArenaBlock;
+typedef struct ldap_utils_dn_suffix    LDAPUtilsDNSuffix;
+typedef struct ldap_utils_spill        LDAPUtilsSpill;
+typedef struct ldap_utils_spill_rec    LDAPUtilsSpillRec;
+typedef struct ldap_utils_spill_run    LDAPUtilsSpillRun;
+
+// encodes value as a sort key which orders correctly using memcmp()
+typedef size_t (*LDAPUtilsKeyFunc)(char * dst, const char * src, size_t len);
+
+
+struct ldap_utils_arena
+{
+   size_t                  block_size;
+   size_t                  count;       // number of allocations
+   LDAPUtilsArenaBlock *   blocks;
+};
+
+
+struct ldap_utils_arena_block
+{
+   LDAPUtilsArenaBlock *   next;
+   size_t                  size;
+   size_t                  used;
+   char *                  data;
+};
+
+
+// parsed DN with RDNs interned in a suffix table
+struct ldap_utils_dn
+{
+   size_t                  components_len;
+   LDAPDN                  ldn;         // parsed DN used to derive other formats
+   const char **           components;  // RDNs starting with the root
+   const char **           normalized;  // case folded RDNs starting with the root
+   LDAPUtilsDNSuffix *     suffix;      // interned parent DN, NULL if not shared
+   char *                  rdns;        // RDNs which are not interned
+   char *                  ufn;
+   char *                  dce;
+   char *                  adc;
+};
+
+
+// interning table of DN suffixes shared by parsed DNs
+struct ldap_utils_dn_cache
+{
+   size_t                  count;
+   size_t                  buckets_size; // power of two
+   LDAPUtilsDNSuffix **    buckets;
+   LDAPUtilsArena *        arena;       // owns suffixes, RDN strings, and tree nodes
+};
+
+
+// output appended to a buffer which is written once full
+struct ldap_utils_output
+{
+   int                     fd;
+   int                     err;         // first write error
+   size_t                  len;
+   size_t                  size;        // bytes written at once when full
+   char *                  buff;
+};
+
+
+// DN suffix stored once for every DN which ends with it
+struct ldap_utils_dn_suffix
+{
+   size_t                  hash;
+   size_t                  len;         // length of RDN
+   size_t                  depth;       // number of RDNs in suffix
+   const char *            rdn;         // leftmost RDN of suffix
+   const char *            norm;        // case folded RDN
+   LDAPUtilsDNSuffix *     parent;      // suffix without leftmost RDN
+   LDAPUtilsDNSuffix *     next;        // next suffix in hash bucket
+};
+
+
 struct ldap_utils_attribute
 {
    char *            name;
@@ -81,10 +159,59 @@ struct ldap_utils_entry
    char *                  dn;
    const char *            rdn;
    char *                  sortval;
+   struct berval           sortkey;     // case folded sortval
+   struct berval           dnkey;       // case folded DN components
    size_t                  components_len;
    size_t                  attrs_count;
-   char **                 components;
+   size_t                  attrs_size;
+   size_t                  index_size;  // power of two, at most half full
+   const char **           components;
    LDAPUtilsAttribute **   attrs;
+   LDAPUtilsAttribute **   index;       // open addressing hash of attrs
+   LDAPUtilsArena *        arena;       // owns entry memory if not NULL
+   LDAPUtilsDN *           pdn;         // parsed DN which owns components
+};
+
+
+// sort key and DN of an entry waiting to be sorted
+struct ldap_utils_spill_rec
+{
+   struct berval           key;         // bv_val is NULL without sort value
+   struct berval           dn;
+};
+
+
+// sorted run of records written to a temporary file
+struct ldap_utils_spill_run
+{
+   FILE *                  fs;          // NULL once run is exhausted
+   size_t                  level;       // times records were merged
+   size_t                  key_size;
+   size_t                  dn_size;
+   char *                  key;         // buffer of current sort key
+   char *                  dn;          // buffer of current DN
+   LDAPUtilsSpillRec       rec;         // current record of run
+};
+
+
+// bounded memory sort of records which spills sorted runs to disk
+struct ldap_utils_spill
+{
+   size_t                  max_memory;
+   size_t                  threads;
+   size_t                  used;        // bytes of records held in memory
+   size_t                  recs_len;
+   size_t                  recs_size;
+   size_t                  cursor;
+   size_t                  runs_len;
+   size_t                  heap_len;
+   size_t                  last;        // run of previously returned record
+   int                     merging;
+   int                     advance;     // last run must read its next record
+   LDAPUtilsSpillRec **    recs;
+   LDAPUtilsArena *        arena;
+   LDAPUtilsSpillRun *     runs;
+   size_t *                heap;        // min heap of runs by current record
 };
 
 
@@ -92,7 +219,10 @@ struct ldap_utils_entries
 {
    size_t               count;
    size_t               cursor;
+   size_t               size;
    LDAPUtilsEntry **    list;
+   LDAPUtilsArena *     arena;
+   LDAPMessage *        res;
 };
 
 
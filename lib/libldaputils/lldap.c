@@ -44,12 +44,117 @@
 
 #include <errno.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
+#include <strings.h>
 #include <ldap.h>
 #include <stdlib.h>
 #include <assert.h>
 
 #include "lconfig.h"
+#include "lentry.h"
+#include "lsort.h"
+
+
+/////////////////
+//             //
+//  Datatypes  //
+//             //
+/////////////////
+// MARK: - Datatypes
+
+// search entry and the encoded value of the sort attribute
+typedef struct ldap_utils_sort_key LDAPUtilsSortKey;
+struct ldap_utils_sort_key
+{
+   LDAPMessage *        msg;
+   struct berval        key;
+   struct berval        dn;         // breaks ties between equal keys
+};
+
+
+// search entries retained to be sorted in memory
+typedef struct ldap_utils_sort_keys LDAPUtilsSortKeys;
+struct ldap_utils_sort_keys
+{
+   size_t               len;
+   size_t               size;
+   LDAPUtilsSortKey *   keys;
+   LDAPUtilsKeyFunc     keyfunc;
+};
+
+
+// bounded memory sort and the sort key encoder used to fill it
+typedef struct ldap_utils_sort_spill LDAPUtilsSortSpill;
+struct ldap_utils_sort_spill
+{
+   LDAPUtilsSpill *     spill;
+   LDAPUtilsKeyFunc     keyfunc;
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+// MARK: - Prototypes
+
+static int
+ldaputils_search_results(
+         LDAPUtils *                   lud,
+         int                           msgid,
+         LDAPUtilsSearchFunc           func,
+         void *                        context,
+         LDAPControl ***               sctrlsp );
+
+
+static int
+ldaputils_search_sorted_add(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 msg,
+         void *                        context );
+
+
+static int
+ldaputils_search_sorted_attrs(
+         LDAPUtils *                   lud );
+
+
+static int
+ldaputils_search_sorted_cmp(
+         const void *                  ptr1,
+         const void *                  ptr2 );
+
+
+static int
+ldaputils_search_sorted_fetch(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 res,
+         void *                        context );
+
+
+static int
+ldaputils_search_sorted_spill(
+         LDAPUtils *                   lud,
+         LDAPUtilsSearchFunc           func,
+         void *                        context );
+
+
+static int
+ldaputils_search_sorted_spill_add(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 msg,
+         void *                        context );
+
+
+static int
+ldaputils_search_sorted_key(
+         LDAP *                        ld,
+         LDAPMessage *                 msg,
+         const char *                  sortattr,
+         LDAPUtilsKeyFunc              keyfunc,
+         struct berval *               key );
 
 
 /////////////////
@@ -131,4 +236,728 @@ ldaputils_search(
    return(LDAP_SUCCESS);
 }
 
+
+/// receives results of a search and passes each entry to a callback
+/// @param[in]  lud       reference to LDAP utilities struct
+/// @param[in]  msgid     message ID of search request
+/// @param[in]  func      function called once for each search entry
+/// @param[in]  context   opaque reference passed to func
+/// @param[out] sctrlsp   reference for returned server controls
+///
+/// @return    Returns the error code from the OpenLDAP library
+/// @see       ldaputils_search_stream
+int
+ldaputils_search_results(
+         LDAPUtils *                   lud,
+         int                           msgid,
+         LDAPUtilsSearchFunc           func,
+         void *                        context,
+         LDAPControl ***               sctrlsp )
+{
+   int            rc;
+   int            err;
+   LDAP *         ld;
+   LDAPMessage *  res;
+
+   assert(lud  != NULL);
+   assert(func != NULL);
+
+   ld  = lud->ld;
+
+   while(1)
+   {
+      res = NULL;
+      switch(ldap_result(ld, msgid, LDAP_MSG_ONE, NULL, &res))
+      {
+         case -1:
+         err = LDAP_OTHER;
+         ldap_get_option(ld, LDAP_OPT_RESULT_CODE, &err);
+         return(err);
+
+         case 0:
+         continue;
+
+         case LDAP_RES_SEARCH_ENTRY:
+         if ((err = func(lud, res, context)) == LDAPUTILS_SEARCH_RETAIN)
+            err = LDAP_SUCCESS;
+         else
+            ldap_msgfree(res);
+         if (err != LDAP_SUCCESS)
+         {
+            ldap_abandon_ext(ld, msgid, NULL, NULL);
+            return(err);
+         };
+         break;
+
+         case LDAP_RES_SEARCH_RESULT:
+         rc = ldap_parse_result(ld, res, &err, NULL, NULL, NULL, sctrlsp, 1);
+         if (rc != LDAP_SUCCESS)
+            return(rc);
+         return(err);
+
+         default:
+         ldap_msgfree(res);
+         break;
+      };
+   };
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// performs LDAP search and passes each entry to a callback in sorted order
+/// @param[in] lud       reference to LDAP utilities struct
+/// @param[in] func      function called once for each search entry
+/// @param[in] context   opaque reference passed to func
+///
+/// If the root DSE of the server lists the Server Side Sorting control
+/// (RFC 2891) as a supported control, the entries are sorted by the server
+/// and streamed to func as they are received.  Otherwise, or if the server
+/// is unable to sort by the requested attribute, the complete result is
+/// retrieved and sorted in memory before being passed to func.  The entries
+/// passed to func must not be retained when sorted in memory.  If the sort
+/// attribute is not among the requested attributes, or if a memory budget
+/// was set, the results are sorted by ldaputils_search_sorted_spill().
+///
+/// If a window was requested with `--offset' and `--count', only the
+/// entries within the window are passed to func.  The window is retrieved
+/// with the Virtual List View control when the server supports both the
+/// sorting and VLV controls.
+///
+/// @return    Returns the error code from the OpenLDAP library
+/// @see       ldaputils_search_stream, ldaputils_supported_control
+int
+ldaputils_search_sorted(
+         LDAPUtils *                   lud,
+         LDAPUtilsSearchFunc           func,
+         void *                        context )
+{
+   int                  err;
+   size_t               x;
+   size_t               first;
+   size_t               last;
+   LDAPUtilsSortKeys    sorted;
+
+   assert(lud  != NULL);
+   assert(func != NULL);
+
+   if (!(lud->sortattr))
+      return( (lud->vlvcount > 0) ? LDAP_PARAM_ERROR : ldaputils_search_stream(lud, func, context) );
+
+   // checks server for sort and VLV controls
+   if (lud->sortctrl == 0)
+      lud->sortctrl = (ldaputils_supported_control(lud, LDAP_CONTROL_SORTREQUEST) == LDAP_SUCCESS) ? 1 : -1;
+   if ( (lud->sortctrl > 0) && (lud->vlvcount > 0) )
+      if (ldaputils_supported_control(lud, LDAP_CONTROL_VLVREQUEST) != LDAP_SUCCESS)
+         lud->sortctrl = -1;
+
+   // requests server side sorting
+   if (lud->sortctrl > 0)
+   {
+      if ((err = ldaputils_search_stream(lud, func, context)) != LDAP_UNAVAILABLE_CRITICAL_EXTENSION)
+         return(err);
+      lud->sortctrl = -1;
+   };
+
+   // sorts within memory budget, or by separately retrieved sort values
+   if ( (lud->maxmemory > 0) || (!(ldaputils_search_sorted_attrs(lud))) )
+      return(ldaputils_search_sorted_spill(lud, func, context));
+
+   // retains entries and sort values as results are received
+   memset(&sorted, 0, sizeof(sorted));
+   sorted.keyfunc = ldaputils_sortkey_func(lud->sortrule);
+   err            = ldaputils_search_stream(lud, &ldaputils_search_sorted_add, &sorted);
+
+   // determines window of entries
+   first = 0;
+   last  = sorted.len;
+   if (lud->vlvcount > 0)
+   {
+      first = (lud->vlvoffset > 1) ? (size_t)(lud->vlvoffset - 1) : 0;
+      first = (first < sorted.len) ? first : sorted.len;
+      last  = ((sorted.len - first) < (size_t)lud->vlvcount) ? sorted.len : (first + (size_t)lud->vlvcount);
+   };
+
+   // sorts and passes entries to callback
+   if (err == LDAP_SUCCESS)
+   {
+      if (ldaputils_sort(sorted.keys, sorted.len, sizeof(LDAPUtilsSortKey), &ldaputils_search_sorted_cmp, (size_t)lud->sortthreads) != LDAP_SUCCESS)
+         qsort(sorted.keys, sorted.len, sizeof(LDAPUtilsSortKey), &ldaputils_search_sorted_cmp);
+      for(x = first; ( (x < last) && (err == LDAP_SUCCESS) ); x++)
+         err = func(lud, sorted.keys[x].msg, context);
+   };
+
+   // frees resources
+   for(x = 0; x < sorted.len; x++)
+   {
+      ldap_msgfree(sorted.keys[x].msg);
+      ldap_memfree(sorted.keys[x].dn.bv_val);
+      free(sorted.keys[x].key.bv_val);
+   };
+   free(sorted.keys);
+
+   return(err);
+}
+
+
+// retains search entry with its sort value until results are sorted
+int
+ldaputils_search_sorted_add(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 msg,
+         void *                        context )
+{
+   int                  err;
+   size_t               size;
+   void *               ptr;
+   LDAPUtilsSortKey *   key;
+   LDAPUtilsSortKeys *  sorted;
+
+   assert(lud     != NULL);
+   assert(msg     != NULL);
+   assert(context != NULL);
+
+   sorted = context;
+
+   if (sorted->len >= sorted->size)
+   {
+      size = (sorted->size) ? (sorted->size * 2) : 1024;
+      if ((ptr = realloc(sorted->keys, (sizeof(LDAPUtilsSortKey) * size))) == NULL)
+         return(LDAP_NO_MEMORY);
+      sorted->keys = ptr;
+      sorted->size = size;
+   };
+
+   key = &sorted->keys[sorted->len];
+   if ((key->dn.bv_val = ldap_get_dn(lud->ld, msg)) == NULL)
+      return(LDAP_NO_MEMORY);
+   key->dn.bv_len = strlen(key->dn.bv_val);
+   if ((err = ldaputils_search_sorted_key(lud->ld, msg, lud->sortattr, sorted->keyfunc, &key->key)) != LDAP_SUCCESS)
+   {
+      ldap_memfree(key->dn.bv_val);
+      return(err);
+   };
+   key->msg = msg;
+   sorted->len++;
+
+   return(LDAPUTILS_SEARCH_RETAIN);
+}
+
+
+// determines if sort attribute is returned with requested attributes
+int
+ldaputils_search_sorted_attrs(
+         LDAPUtils *                   lud )
+{
+   size_t      x;
+
+   if (!(lud->attrs))
+      return(1);
+   for(x = 0; ((lud->attrs[x])); x++)
+      if ( (!(strcmp(lud->attrs[x], "*"))) || (!(strcasecmp(lud->attrs[x], lud->sortattr))) )
+         return(1);
+
+   return(0);
+}
+
+
+/// compares sort values of two entries
+/// @param[in] ptr1   reference to first sort key
+/// @param[in] ptr2   reference to second sort key
+///
+/// As with server side sorting (RFC 2891), entries without the sort
+/// attribute are sorted last.  Entries with equal sort values are ordered
+/// by DN, the same as ldaputils_spill_rec_cmp().
+///
+/// @return    Returns an integer less than, equal to, or greater than zero
+int
+ldaputils_search_sorted_cmp(
+         const void *                  ptr1,
+         const void *                  ptr2 )
+{
+   int                        rc;
+   const LDAPUtilsSortKey *   key1;
+   const LDAPUtilsSortKey *   key2;
+
+   key1 = ptr1;
+   key2 = ptr2;
+
+   if ( (!(key1->key.bv_val)) || (!(key2->key.bv_val)) )
+   {
+      if ( ((key1->key.bv_val)) || ((key2->key.bv_val)) )
+         return( ((key1->key.bv_val)) ? -1 : 1 );
+   }
+   else if ((rc = ldaputils_sortkey_cmp(&key1->key, &key2->key)))
+      return(rc);
+
+   return(ldaputils_sortkey_cmp(&key1->dn, &key2->dn));
+}
+
+
+// stores result of entry retrieved while merging sorted runs
+int
+ldaputils_search_sorted_fetch(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 res,
+         void *                        context )
+{
+   assert(lud     != NULL);
+   assert(context != NULL);
+   *((LDAPMessage **)context) = res;
+   return(LDAPUTILS_SEARCH_RETAIN);
+}
+
+
+/// sorts search results within a memory budget
+/// @param[in] lud         reference to LDAP utilities struct
+/// @param[in] func        function called for each entry in sorted order
+/// @param[in] context     caller data passed to func
+///
+/// The search is first performed for only the sort attribute.  The sort
+/// key and DN of each entry are kept in memory until lud->maxmemory, if
+/// set, is exceeded, at which point they are written to disk as a sorted
+/// run.
+/// The runs are then merged and each entry is retrieved by DN, in batches
+/// of concurrent base searches, and passed to func in sorted order.
+///
+/// The results are not a snapshot of the directory.  Entries are
+/// retrieved again after all sort keys were collected, so an entry changed
+/// in between is written with its current attributes at its old position.
+/// Entries deleted or renamed in between are not passed to func and do not
+/// count against lud->vlvcount; the remaining entries are still passed to
+/// func and LDAP_NO_SUCH_OBJECT is returned afterwards.
+///
+/// @return    Returns the error code from the OpenLDAP library, or
+///            LDAP_NO_SUCH_OBJECT if entries could no longer be retrieved
+/// @see       ldaputils_search_sorted
+int
+ldaputils_search_sorted_spill(
+         LDAPUtils *                   lud,
+         LDAPUtilsSearchFunc           func,
+         void *                        context )
+{
+   int                  err;
+   size_t               x;
+   size_t               len;
+   size_t               skip;
+   size_t               remaining;
+   size_t               missing;
+   size_t               budget;
+   char *               attrs[2];
+   char **              saved;
+   const char *         dn;
+   LDAPMessage *        msg;
+   LDAPMessage *        batch[LDAPUTILS_SPILL_FETCH_BATCH];
+   LDAPUtilsMux *       mux;
+   LDAPUtilsSpill *     spill;
+   LDAPUtilsSortSpill   state;
+
+   assert(lud  != NULL);
+   assert(func != NULL);
+
+   budget = (lud->maxmemory > 0) ? lud->maxmemory : SIZE_MAX;
+   if ((err = ldaputils_spill_initialize(&spill, budget, (size_t)lud->sortthreads)) != LDAP_SUCCESS)
+      return(err);
+   state.spill   = spill;
+   state.keyfunc = ldaputils_sortkey_func(lud->sortrule);
+
+   // collects sort keys and DNs using only the sort attribute
+   attrs[0]   = (char *)lud->sortattr;
+   attrs[1]   = NULL;
+   saved      = lud->attrs;
+   lud->attrs = attrs;
+   err        = ldaputils_search_stream(lud, &ldaputils_search_sorted_spill_add, &state);
+   lud->attrs = saved;
+   if (err != LDAP_SUCCESS)
+   {
+      ldaputils_spill_free(spill);
+      return(err);
+   };
+
+   // determines window of entries
+   skip      = 0;
+   remaining = SIZE_MAX;
+   if (lud->vlvcount > 0)
+   {
+      skip      = (lud->vlvoffset > 1) ? (size_t)(lud->vlvoffset - 1) : 0;
+      remaining = (size_t)lud->vlvcount;
+   };
+
+   // retrieves entries in sorted order
+   missing = 0;
+   while ( (err == LDAP_SUCCESS) && (remaining > 0) )
+   {
+      if ((err = ldaputils_mux_initialize(&mux, lud)) != LDAP_SUCCESS)
+         break;
+
+      // submits batch of base searches, no larger than the entries still
+      // needed since entries which are no longer found are replaced by the
+      // next batch
+      len = 0;
+      while ( (len < LDAPUTILS_SPILL_FETCH_BATCH) && (len < remaining) && (err == LDAP_SUCCESS) )
+      {
+         if ( ((err = ldaputils_spill_next(spill, &dn)) != LDAP_SUCCESS) || (!(dn)) )
+            break;
+         if (skip > 0)
+         {
+            skip--;
+            continue;
+         };
+         batch[len] = NULL;
+         if ((err = ldaputils_mux_search(mux, dn, LDAP_SCOPE_BASE, "(objectClass=*)", lud->attrs, NULL, &ldaputils_search_sorted_fetch, &batch[len])) != LDAP_SUCCESS)
+            break;
+         len++;
+      };
+      if (len == 0)
+      {
+         ldaputils_mux_free(mux);
+         break;
+      };
+
+      // waits for batch and passes entries to callback in order
+      if (err == LDAP_SUCCESS)
+         err = ldaputils_mux_result(mux, NULL);
+      ldaputils_mux_free(mux);
+      for(x = 0; x < len; x++)
+      {
+         msg = ((batch[x])) ? ldap_first_entry(lud->ld, batch[x]) : NULL;
+         if ( (err == LDAP_SUCCESS) && (!(msg)) )
+            missing++;
+         if ( (err == LDAP_SUCCESS) && ((msg)) )
+         {
+            err = func(lud, msg, context);
+            remaining--;
+         };
+         if ((batch[x]))
+            ldap_msgfree(batch[x]);
+      };
+   };
+
+   ldaputils_spill_free(spill);
+
+   if ( (err == LDAP_SUCCESS) && (missing > 0) )
+      return(LDAP_NO_SUCH_OBJECT);
+
+   return(err);
+}
+
+
+// adds sort key and DN of search entry to bounded memory sort
+int
+ldaputils_search_sorted_spill_add(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 msg,
+         void *                        context )
+{
+   int                  err;
+   char *               dn;
+   struct berval        key;
+   LDAPUtilsSortSpill * state;
+
+   assert(lud     != NULL);
+   assert(msg     != NULL);
+   assert(context != NULL);
+
+   state = context;
+
+   if ((dn = ldap_get_dn(lud->ld, msg)) == NULL)
+      return(LDAP_NO_MEMORY);
+   if ((err = ldaputils_search_sorted_key(lud->ld, msg, lud->sortattr, state->keyfunc, &key)) != LDAP_SUCCESS)
+   {
+      ldap_memfree(dn);
+      return(err);
+   };
+
+   err = ldaputils_spill_add(state->spill, &key, dn);
+
+   free(key.bv_val);
+   ldap_memfree(dn);
+
+   return(err);
+}
+
+
+/// generates sort key of entry
+/// @param[in]  ld         reference to LDAP socket data
+/// @param[in]  msg        reference to LDAP search entry
+/// @param[in]  sortattr   attribute to use for sorting entries
+/// @param[in]  keyfunc    encoder of the ordering rule of the attribute
+/// @param[out] key        returns sort key, or NULL bv_val if the entry
+///                        does not contain the attribute
+///
+/// Each value is encoded once by keyfunc so that keys are compared with
+/// memcmp() without parsing values again.  As with server side sorting
+/// (RFC 2891), the smallest value of a multi-valued attribute is used.
+///
+/// @return    Returns LDAP_SUCCESS or LDAP_NO_MEMORY
+int
+ldaputils_search_sorted_key(
+         LDAP *                        ld,
+         LDAPMessage *                 msg,
+         const char *                  sortattr,
+         LDAPUtilsKeyFunc              keyfunc,
+         struct berval *               key )
+{
+   size_t               x;
+   size_t               size;
+   size_t               tmpsize;
+   size_t               keysize;
+   void *               ptr;
+   struct berval        tmp;
+   struct berval        swap;
+   struct berval **     vals;
+
+   key->bv_val = NULL;
+   key->bv_len = 0;
+
+   if ((vals = ldap_get_values_len(ld, msg, sortattr)) == NULL)
+      return(LDAP_SUCCESS);
+
+   // encodes values and keeps the smallest key
+   memset(&tmp, 0, sizeof(tmp));
+   tmpsize = 0;
+   keysize = 0;
+   for(x = 0; ((vals[x])); x++)
+   {
+      if (LDAPUTILS_SORTKEY_SIZE(vals[x]->bv_len) > tmpsize)
+      {
+         tmpsize = LDAPUTILS_SORTKEY_SIZE(vals[x]->bv_len);
+         if ((ptr = realloc(tmp.bv_val, tmpsize)) == NULL)
+         {
+            free(tmp.bv_val);
+            free(key->bv_val);
+            key->bv_val = NULL;
+            ldap_value_free_len(vals);
+            return(LDAP_NO_MEMORY);
+         };
+         tmp.bv_val = ptr;
+      };
+      tmp.bv_len = keyfunc(tmp.bv_val, vals[x]->bv_val, vals[x]->bv_len);
+      if ( ((key->bv_val)) && (ldaputils_sortkey_cmp(&tmp, key) >= 0) )
+         continue;
+      swap    = *key;
+      *key    = tmp;
+      tmp     = swap;
+      size    = keysize;
+      keysize = tmpsize;
+      tmpsize = size;
+   };
+   free(tmp.bv_val);
+
+   ldap_value_free_len(vals);
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// performs LDAP search and passes each entry to a callback as it arrives
+/// @param[in] lud       reference to LDAP utilities struct
+/// @param[in] func      function called once for each search entry
+/// @param[in] context   opaque reference passed to func
+///
+/// Each entry is freed as soon as the callback returns, unless the callback
+/// returns LDAPUTILS_SEARCH_RETAIN, so the complete result set is never held
+/// in memory.  If a page size was requested with
+/// `-E pr=size', the search is repeated with the Simple Paged Results
+/// control (RFC 2696) until the server returns an empty cookie.  If server
+/// side sorting was enabled by ldaputils_search_sorted(), the Server Side
+/// Sorting control (RFC 2891) is sent as a critical control, along with the
+/// Virtual List View control if a window of entries was requested.  If the
+/// callback returns a value other than LDAP_SUCCESS, the search is
+/// abandoned and the value is returned to the caller.
+///
+/// @return    Returns the error code from the OpenLDAP library
+/// @see       ldaputils_search, ldaputils_bind_s
+int
+ldaputils_search_stream(
+         LDAPUtils *                   lud,
+         LDAPUtilsSearchFunc           func,
+         void *                        context )
+{
+   int               rc;
+   int               err;
+   int               msgid;
+   ber_int_t         count;
+   ber_int_t         target;
+   LDAP *            ld;
+   LDAPControl *     ctrls[3];
+   LDAPControl **    sctrls;
+   LDAPControl *     ctrl;
+   LDAPControl *     sortctrl;
+   LDAPControl *     vlvctrl;
+   LDAPSortKey **    keys;
+   LDAPVLVInfo       vlvinfo;
+   struct berval     cookie;
+
+   assert(lud  != NULL);
+   assert(func != NULL);
+
+   ld       = lud->ld;
+   sortctrl = NULL;
+   vlvctrl  = NULL;
+
+   // creates server side sort control
+   if ( ((lud->sortattr)) && (lud->sortctrl > 0) )
+   {
+      if ((err = ldap_create_sort_keylist(&keys, (char *)lud->sortattr)) != LDAP_SUCCESS)
+         return(err);
+      err = ldap_create_sort_control(ld, keys, 1, &sortctrl);
+      ldap_free_sort_keylist(keys);
+      if (err != LDAP_SUCCESS)
+         return(err);
+   };
+
+   // creates virtual list view control
+   if ( ((sortctrl)) && (lud->vlvcount > 0) )
+   {
+      memset(&vlvinfo, 0, sizeof(vlvinfo));
+      vlvinfo.ldvlv_version      = 1;
+      vlvinfo.ldvlv_before_count = 0;
+      vlvinfo.ldvlv_after_count  = lud->vlvcount - 1;
+      vlvinfo.ldvlv_offset       = (lud->vlvoffset > 1) ? lud->vlvoffset : 1;
+      vlvinfo.ldvlv_count        = 0;
+      if ((err = ldap_create_vlv_control(ld, &vlvinfo, &vlvctrl)) != LDAP_SUCCESS)
+      {
+         ldap_control_free(sortctrl);
+         return(err);
+      };
+   };
+
+   // performs search without paging
+   if ( (lud->pagesize < 1) || ((vlvctrl)) )
+   {
+      ctrls[0] = sortctrl;
+      ctrls[1] = vlvctrl;
+      ctrls[2] = NULL;
+      err = ldap_search_ext(ld, NULL, lud->scope, lud->filter, lud->attrs, 0, (((sortctrl)) ? ctrls : NULL), NULL, NULL, -1, &msgid);
+      if ((sortctrl))
+         ldap_control_free(sortctrl);
+      if (err != LDAP_SUCCESS)
+      {
+         if ((vlvctrl))
+            ldap_control_free(vlvctrl);
+         return(err);
+      };
+      if (!(vlvctrl))
+         return(ldaputils_search_results(lud, msgid, func, context, NULL));
+      ldap_control_free(vlvctrl);
+
+      // checks result of virtual list view
+      sctrls = NULL;
+      if ((err = ldaputils_search_results(lud, msgid, func, context, &sctrls)) == LDAP_SUCCESS)
+         if ((ctrl = ldap_control_find(LDAP_CONTROL_VLVRESPONSE, sctrls, NULL)) != NULL)
+            if ((rc = ldap_parse_vlvresponse_control(ld, ctrl, &target, &count, NULL, &err)) != LDAP_SUCCESS)
+               err = rc;
+      if ((sctrls))
+         ldap_controls_free(sctrls);
+      return(err);
+   };
+
+   memset(&cookie, 0, sizeof(cookie));
+
+   // requests pages until the server returns an empty cookie
+   do
+   {
+      // creates paged results control
+      if ((err = ldap_create_page_control(ld, lud->pagesize, &cookie, lud->pagecrit, &ctrls[0])) != LDAP_SUCCESS)
+      {
+         ber_memfree(cookie.bv_val);
+         if ((sortctrl))
+            ldap_control_free(sortctrl);
+         return(err);
+      };
+      ctrls[1] = sortctrl;
+      ctrls[2] = NULL;
+
+      // sends search request
+      err = ldap_search_ext(ld, NULL, lud->scope, lud->filter, lud->attrs, 0, ctrls, NULL, NULL, -1, &msgid);
+      ldap_control_free(ctrls[0]);
+      ber_memfree(cookie.bv_val);
+      memset(&cookie, 0, sizeof(cookie));
+      if (err != LDAP_SUCCESS)
+         break;
+
+      // processes page of results
+      sctrls = NULL;
+      if ((err = ldaputils_search_results(lud, msgid, func, context, &sctrls)) != LDAP_SUCCESS)
+      {
+         if ((sctrls))
+            ldap_controls_free(sctrls);
+         break;
+      };
+
+      // retrieves cookie for next page
+      if ((ctrl = ldap_control_find(LDAP_CONTROL_PAGEDRESULTS, sctrls, NULL)) != NULL)
+         err = ldap_parse_pageresponse_control(ld, ctrl, &count, &cookie);
+      if ((sctrls))
+         ldap_controls_free(sctrls);
+      if (err != LDAP_SUCCESS)
+         break;
+   } while (cookie.bv_len > 0);
+
+   ber_memfree(cookie.bv_val);
+   if ((sortctrl))
+      ldap_control_free(sortctrl);
+
+   return(err);
+}
+
+
+/// checks root DSE of server for a supported control
+/// @param[in] lud   reference to LDAP utilities struct
+/// @param[in] oid   OID of control
+///
+/// @return    Returns LDAP_SUCCESS if the control is supported,
+///            LDAP_UNAVAILABLE_CRITICAL_EXTENSION if the control is not
+///            supported, otherwise the error code from the OpenLDAP library
+int
+ldaputils_supported_control(
+         LDAPUtils *                   lud,
+         const char *                  oid )
+{
+   int               err;
+   size_t            x;
+   LDAP *            ld;
+   LDAPMessage *     res;
+   LDAPMessage *     msg;
+   struct berval **  vals;
+   struct timeval    timeout;
+
+   static char *     attrs[] = { "supportedControl", NULL };
+
+   assert(lud != NULL);
+   assert(oid != NULL);
+
+   ld  = lud->ld;
+
+   // searches root DSE
+   timeout.tv_sec    = 5;
+   timeout.tv_usec   = 0;
+   res               = NULL;
+   if ((err = ldap_search_ext_s(ld, "", LDAP_SCOPE_BASE, "(objectclass=*)", attrs, 0, NULL, NULL, &timeout, 0, &res)) != LDAP_SUCCESS)
+   {
+      if ((res))
+         ldap_msgfree(res);
+      return(err);
+   };
+   if ((msg = ldap_first_entry(ld, res)) == NULL)
+   {
+      ldap_msgfree(res);
+      return(LDAP_UNAVAILABLE_CRITICAL_EXTENSION);
+   };
+
+   // compares supported controls
+   err = LDAP_UNAVAILABLE_CRITICAL_EXTENSION;
+   if ((vals = ldap_get_values_len(ld, msg, "supportedControl")) != NULL)
+   {
+      for(x = 0; ( ((vals[x])) && (err != LDAP_SUCCESS) ); x++)
+         if ( (vals[x]->bv_len == strlen(oid)) && (!(memcmp(vals[x]->bv_val, oid, vals[x]->bv_len))) )
+            err = LDAP_SUCCESS;
+      ldap_value_free_len(vals);
+   };
+   ldap_msgfree(res);
+
+   return(err);
+}
+
 /* end of source file */
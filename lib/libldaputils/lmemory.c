@@ -127,6 +127,97 @@ ldaputils_initialize(
 }
 
 
+/// creates a new LDAP connection using the configuration of another
+/// @param[out] ludp   reference for the new LDAP utilities struct
+/// @param[in]  src    LDAP utilities struct to copy
+///
+/// The returned connection has not been bound and must be passed to
+/// ldaputils_bind_s() before use.  The password and other strings are
+/// shared with src and must outlive the copy.
+///
+/// @return    Returns the error code from the OpenLDAP library
+/// @see       ldaputils_initialize, ldaputils_bind_s, ldaputils_unbind
+int
+ldaputils_initialize_copy(
+         LDAPUtils **                  ludp,
+         LDAPUtils *                   src )
+{
+   int                  err;
+   int                  i;
+   size_t               len;
+   char *               str;
+   struct timeval *     tv;
+   LDAPUtils *          lud;
+
+   static const int     int_opts[] =
+   {
+      LDAP_OPT_PROTOCOL_VERSION,
+      LDAP_OPT_DEBUG_LEVEL,
+      LDAP_OPT_DEREF,
+      LDAP_OPT_SIZELIMIT,
+      LDAP_OPT_TIMELIMIT,
+      0
+   };
+
+   assert(ludp != NULL);
+   assert(src  != NULL);
+
+   // allocate initial memory for base struct
+   if ((lud = malloc(sizeof(LDAPUtils))) == NULL)
+      return(LDAP_NO_MEMORY);
+   memcpy(lud, src, sizeof(LDAPUtils));
+   lud->ld     = NULL;
+   lud->attrs  = NULL;
+
+   // copy attribute list
+   if ((src->attrs))
+   {
+      for(len = 0; ((src->attrs[len])); len++);
+      if ((lud->attrs = malloc(sizeof(char *) * (len+1))) == NULL)
+      {
+         ldaputils_unbind(lud);
+         return(LDAP_NO_MEMORY);
+      };
+      memcpy(lud->attrs, src->attrs, (sizeof(char *) * (len+1)));
+   };
+
+   // initialize LDAP library with URI of source
+   str = NULL;
+   ldap_get_option(src->ld, LDAP_OPT_URI, &str);
+   err = ldap_initialize(&lud->ld, str);
+   if ((str))
+      ldap_memfree(str);
+   if (err != LDAP_SUCCESS)
+   {
+      ldaputils_unbind(lud);
+      return(err);
+   };
+
+   // copy options
+   for(i = 0; ((int_opts[i])); i++)
+      if (ldap_get_option(src->ld, int_opts[i], &err) == LDAP_OPT_SUCCESS)
+         ldap_set_option(lud->ld, int_opts[i], &err);
+   if (ldap_get_option(src->ld, LDAP_OPT_REFERRALS, &err) == LDAP_OPT_SUCCESS)
+      ldap_set_option(lud->ld, LDAP_OPT_REFERRALS, ((err)) ? LDAP_OPT_ON : LDAP_OPT_OFF);
+   str = NULL;
+   if ( (ldap_get_option(src->ld, LDAP_OPT_DEFBASE, &str) == LDAP_OPT_SUCCESS) && ((str)) )
+   {
+      ldap_set_option(lud->ld, LDAP_OPT_DEFBASE, str);
+      ldap_memfree(str);
+   };
+   tv = NULL;
+   if ( (ldap_get_option(src->ld, LDAP_OPT_NETWORK_TIMEOUT, &tv) == LDAP_OPT_SUCCESS) && ((tv)) )
+   {
+      ldap_set_option(lud->ld, LDAP_OPT_NETWORK_TIMEOUT, tv);
+      ldap_memfree(tv);
+   };
+
+   *ludp = lud;
+
+   return(LDAP_SUCCESS);
+}
+
+
 /// frees common config
 /// @param[in] lud   reference to LDAP utilities struct
 ///
@@ -0,0 +1,314 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2025 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/lmux.c contains search multiplexer functions and variables
+ */
+#define _LIB_LIBLDAPUTILS_LMUX_C 1
+#include "lmux.h"
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+// MARK: - Headers
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <ldap.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "lconfig.h"
+
+
+/////////////////
+//             //
+//  Datatypes  //
+//             //
+/////////////////
+// MARK: - Datatypes
+
+typedef struct ldap_utils_mux_request LDAPUtilsMuxRequest;
+
+// outstanding search request
+struct ldap_utils_mux_request
+{
+   int                     msgid;
+   int                     done;
+   LDAPUtilsSearchFunc     func;
+   void *                  context;
+};
+
+
+// search requests sharing a single connection
+struct ldap_utils_mux
+{
+   LDAPUtils *             lud;
+   size_t                  pending;
+   size_t                  reqs_len;
+   size_t                  reqs_size;
+   LDAPUtilsMuxRequest *   reqs;
+};
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+// MARK: - Functions
+
+/// abandons outstanding requests and frees resources
+/// @param[in] mux   reference to search multiplexer
+///
+/// @see       ldaputils_mux_initialize
+void
+ldaputils_mux_free(
+         LDAPUtilsMux *                mux )
+{
+   size_t   x;
+
+   if (!(mux))
+      return;
+
+   for(x = 0; x < mux->reqs_len; x++)
+      if (!(mux->reqs[x].done))
+         ldap_abandon_ext(mux->lud->ld, mux->reqs[x].msgid, NULL, NULL);
+
+   if ((mux->reqs))
+      free(mux->reqs);
+   free(mux);
+
+   return;
+}
+
+
+/// allocates search multiplexer for a bound connection
+/// @param[out] muxp   reference to search multiplexer pointer
+/// @param[in]  lud    reference to LDAP utilities struct
+///
+/// @return    Returns the error code from the OpenLDAP library
+/// @see       ldaputils_mux_free, ldaputils_mux_search, ldaputils_mux_result
+int
+ldaputils_mux_initialize(
+         LDAPUtilsMux **               muxp,
+         LDAPUtils *                   lud )
+{
+   LDAPUtilsMux *    mux;
+
+   assert(muxp != NULL);
+   assert(lud  != NULL);
+
+   if ((mux = malloc(sizeof(LDAPUtilsMux))) == NULL)
+      return(LDAP_NO_MEMORY);
+   memset(mux, 0, sizeof(LDAPUtilsMux));
+   mux->lud = lud;
+
+   *muxp = mux;
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// waits for all submitted searches to complete
+/// @param[in] mux       reference to search multiplexer
+/// @param[in] timeout   maximum time to wait for each result or NULL
+///
+/// Results are received in the order the searches complete.  The complete
+/// result chain of each search is passed to the function registered with
+/// the search and is freed when the function returns, unless the function
+/// returns LDAPUTILS_SEARCH_RETAIN.  The remaining searches are still
+/// collected if a function returns an error.
+///
+/// @return    Returns the first error code returned by a function or from
+///            the OpenLDAP library
+/// @see       ldaputils_mux_search
+int
+ldaputils_mux_result(
+         LDAPUtilsMux *                mux,
+         struct timeval *              timeout )
+{
+   int                     rc;
+   int                     err;
+   int                     msgid;
+   size_t                  x;
+   void *                  context;
+   LDAP *                  ld;
+   LDAPMessage *           res;
+   LDAPUtilsMuxRequest *   req;
+   LDAPUtilsSearchFunc     func;
+
+   assert(mux != NULL);
+
+   ld  = mux->lud->ld;
+   err = LDAP_SUCCESS;
+
+   while (mux->pending > 0)
+   {
+      // receives next completed search
+      res = NULL;
+      switch(ldap_result(ld, LDAP_RES_ANY, LDAP_MSG_ALL, timeout, &res))
+      {
+         case -1:
+         rc = LDAP_OTHER;
+         ldap_get_option(ld, LDAP_OPT_RESULT_CODE, &rc);
+         return( (err != LDAP_SUCCESS) ? err : rc );
+
+         case 0:
+         return( (err != LDAP_SUCCESS) ? err : LDAP_TIMEOUT );
+
+         default:
+         break;
+      };
+
+      // locates request
+      msgid = ldap_msgid(res);
+      req   = NULL;
+      for(x = 0; ( (x < mux->reqs_len) && (!(req)) ); x++)
+         if ( (mux->reqs[x].msgid == msgid) && (!(mux->reqs[x].done)) )
+            req = &mux->reqs[x];
+      if (!(req))
+      {
+         ldap_msgfree(res);
+         continue;
+      };
+      req->done = 1;
+      mux->pending--;
+
+      // removes request from list before the function submits more searches
+      func    = req->func;
+      context = req->context;
+      *req    = mux->reqs[--mux->reqs_len];
+
+      // dispatches result
+      if ((rc = func(mux->lud, res, context)) == LDAPUTILS_SEARCH_RETAIN)
+         continue;
+      ldap_msgfree(res);
+      if ( (rc != LDAP_SUCCESS) && (err == LDAP_SUCCESS) )
+         err = rc;
+   };
+
+   return(err);
+}
+
+
+/// submits search without waiting for the result
+/// @param[in] mux       reference to search multiplexer
+/// @param[in] base      search base
+/// @param[in] scope     search scope
+/// @param[in] filter    search filter
+/// @param[in] attrs     attributes to return
+/// @param[in] timeout   search time limit or NULL
+/// @param[in] func      function passed the result of the search
+/// @param[in] context   opaque reference passed to func
+///
+/// @return    Returns the error code from the OpenLDAP library
+/// @see       ldaputils_mux_result, ldaputils_mux_search_ext
+int
+ldaputils_mux_search(
+         LDAPUtilsMux *                mux,
+         const char *                  base,
+         int                           scope,
+         const char *                  filter,
+         char **                       attrs,
+         struct timeval *              timeout,
+         LDAPUtilsSearchFunc           func,
+         void *                        context )
+{
+   return(ldaputils_mux_search_ext(mux, base, scope, filter, attrs, timeout, -1, func, context));
+}
+
+
+/// submits search with a size limit without waiting for the result
+/// @param[in] mux         reference to search multiplexer
+/// @param[in] base        search base
+/// @param[in] scope       search scope
+/// @param[in] filter      search filter
+/// @param[in] attrs       attributes to return
+/// @param[in] timeout     search time limit or NULL
+/// @param[in] sizelimit   maximum entries to return or -1 for the default
+/// @param[in] func        function passed the result of the search
+/// @param[in] context     opaque reference passed to func
+///
+/// A search which reaches the size limit completes with the result code
+/// LDAP_SIZELIMIT_EXCEEDED in the result chain passed to func.
+///
+/// @return    Returns the error code from the OpenLDAP library
+/// @see       ldaputils_mux_result, ldaputils_mux_search
+int
+ldaputils_mux_search_ext(
+         LDAPUtilsMux *                mux,
+         const char *                  base,
+         int                           scope,
+         const char *                  filter,
+         char **                       attrs,
+         struct timeval *              timeout,
+         int                           sizelimit,
+         LDAPUtilsSearchFunc           func,
+         void *                        context )
+{
+   int                     err;
+   int                     msgid;
+   size_t                  size;
+   void *                  ptr;
+   LDAPUtilsMuxRequest *   req;
+
+   assert(mux  != NULL);
+   assert(func != NULL);
+
+   // grows request list
+   if (mux->reqs_len >= mux->reqs_size)
+   {
+      size = (mux->reqs_size) ? (mux->reqs_size * 2) : 8;
+      if ((ptr = realloc(mux->reqs, (sizeof(LDAPUtilsMuxRequest) * size))) == NULL)
+         return(LDAP_NO_MEMORY);
+      mux->reqs      = ptr;
+      mux->reqs_size = size;
+   };
+
+   // sends search request
+   if ((err = ldap_search_ext(mux->lud->ld, base, scope, filter, attrs, 0, NULL, NULL, timeout, sizelimit, &msgid)) != LDAP_SUCCESS)
+      return(err);
+
+   req = &mux->reqs[mux->reqs_len++];
+   memset(req, 0, sizeof(LDAPUtilsMuxRequest));
+   req->msgid   = msgid;
+   req->func    = func;
+   req->context = context;
+   mux->pending++;
+
+   return(LDAP_SUCCESS);
+}
+
+/* end of source file */
@@ -0,0 +1,890 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2025 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/loutput.c contains buffered output functions and variables
+ */
+#define _LIB_LIBLDAPUTILS_LOUTPUT_C 1
+#include "loutput.h"
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+// MARK: - Headers
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <sys/uio.h>
+
+#if defined(__AVX2__)
+#   include <immintrin.h>
+#elif defined(__SSE2__)
+#   include <emmintrin.h>
+#endif
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+// MARK: - Prototypes
+
+static size_t
+ldaputils_output_csv_scan(
+         const char *                  data,
+         size_t                        len,
+         int                           sep );
+
+
+static size_t
+ldaputils_output_json_scan(
+         const char *                  data,
+         size_t                        len );
+
+
+static size_t
+ldaputils_output_utf8_seq(
+         const char *                  data,
+         size_t                        len );
+
+
+static int
+ldaputils_output_utf8_valid(
+         const char *                  data,
+         size_t                        len );
+
+
+static int
+ldaputils_output_writev(
+         LDAPUtilsOutput *             out,
+         struct iovec *                iov,
+         int                           iovcnt );
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+// MARK: - Functions
+
+/// appends value encoded with base64
+/// @param[in] out     reference to output buffer
+/// @param[in] data    value to append
+/// @param[in] len     length of value
+///
+/// The value is encoded as described by RFC 4648 without line breaks.
+///
+/// @return    Returns the error code from the OpenLDAP library
+int
+ldaputils_output_base64(
+         LDAPUtilsOutput *             out,
+         const void *                  data,
+         size_t                        len )
+{
+   size_t                  pos;
+   size_t                  chunk;
+   size_t                  used;
+   char *                  buff;
+   const unsigned char *   str;
+
+   static const char b64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+   assert(out  != NULL);
+   assert(data != NULL);
+
+   str = data;
+
+   // encodes large values in chunks instead of enlarging the buffer
+   while (len > 0)
+   {
+      chunk = (len < LDAPUTILS_OUTPUT_BASE64_CHUNK) ? len : LDAPUTILS_OUTPUT_BASE64_CHUNK;
+      if ((buff = ldaputils_output_reserve(out, (((chunk + 2) / 3) * 4))) == NULL)
+         return(out->err);
+
+      for(pos = 0, used = 0; ((pos + 3) <= chunk); pos += 3, used += 4)
+      {
+         buff[used+0] = b64[  str[pos+0] >> 2 ];
+         buff[used+1] = b64[ ((str[pos+0] & 0x03) << 4) | (str[pos+1] >> 4) ];
+         buff[used+2] = b64[ ((str[pos+1] & 0x0f) << 2) | (str[pos+2] >> 6) ];
+         buff[used+3] = b64[   str[pos+2] & 0x3f ];
+      };
+
+      // pads remaining bytes of final chunk
+      if (pos < chunk)
+      {
+         buff[used+0] = b64[ str[pos+0] >> 2 ];
+         if ((pos + 1) < chunk)
+         {
+            buff[used+1] = b64[ ((str[pos+0] & 0x03) << 4) | (str[pos+1] >> 4) ];
+            buff[used+2] = b64[  (str[pos+1] & 0x0f) << 2 ];
+         }
+         else
+         {
+            buff[used+1] = b64[ (str[pos+0] & 0x03) << 4 ];
+            buff[used+2] = '=';
+         };
+         buff[used+3] = '=';
+         used += 4;
+      };
+
+      ldaputils_output_commit(out, used);
+      str += chunk;
+      len -= chunk;
+   };
+
+   return(out->err);
+}
+
+
+/// appends bytes written into reserved space of buffer
+/// @param[in] out     reference to output buffer
+/// @param[in] len     number of bytes written
+///
+/// @see       ldaputils_output_reserve
+void
+ldaputils_output_commit(
+         LDAPUtilsOutput *             out,
+         size_t                        len )
+{
+   assert(out != NULL);
+   assert((out->len + len) <= out->size);
+   out->len += len;
+   return;
+}
+
+
+/// appends value escaped for a quoted CSV field
+/// @param[in] out     reference to output buffer
+/// @param[in] data    value to append
+/// @param[in] len     length of value
+/// @param[in] sep     separator of multiple values or 0
+///
+/// Double quotes are doubled as described by RFC 4180.  Delimiters and line
+/// breaks need no escaping within a quoted field.  If a separator is given,
+/// separators and backslashes within the value are preceded by a backslash
+/// so that values joined by the separator can be split again.  Runs of
+/// bytes which need no escaping are appended at once.
+///
+/// @return    Returns the error code from the OpenLDAP library
+int
+ldaputils_output_csv(
+         LDAPUtilsOutput *             out,
+         const void *                  data,
+         size_t                        len,
+         int                           sep )
+{
+   size_t         run;
+   char           esc[2];
+   const char *   str;
+
+   assert(out  != NULL);
+   assert(data != NULL);
+
+   str = data;
+
+   while (len > 0)
+   {
+      // appends bytes before next special byte
+      if ((run = ldaputils_output_csv_scan(str, len, sep)) > 0)
+         ldaputils_output_write(out, str, run);
+      if (run == len)
+         break;
+
+      // escapes special byte
+      esc[0] = (str[run] == '"') ? '"' : '\\';
+      esc[1] = str[run];
+      ldaputils_output_write(out, esc, 2);
+
+      str += run + 1;
+      len -= run + 1;
+   };
+
+   return(out->err);
+}
+
+
+// finds first byte which is escaped in CSV field
+size_t
+ldaputils_output_csv_scan(
+         const char *                  data,
+         size_t                        len,
+         int                           sep )
+{
+   size_t         pos;
+   char           c1;
+   char           c2;
+   char           c3;
+#if defined(__AVX2__)
+   unsigned       mask32;
+   __m256i        w1;
+   __m256i        w2;
+   __m256i        w3;
+   __m256i        chunk32;
+#endif
+#if defined(__SSE2__)
+   unsigned       mask16;
+   __m128i        v1;
+   __m128i        v2;
+   __m128i        v3;
+   __m128i        chunk16;
+#endif
+
+   // searches for quote only if values are not separated
+   c1  = '"';
+   c2  = (sep) ? (char)sep : '"';
+   c3  = (sep) ? '\\' : '"';
+   pos = 0;
+
+#if defined(__AVX2__)
+   w1 = _mm256_set1_epi8(c1);
+   w2 = _mm256_set1_epi8(c2);
+   w3 = _mm256_set1_epi8(c3);
+   for(; ((pos + 32) <= len); pos += 32)
+   {
+      chunk32 = _mm256_loadu_si256((const __m256i *)&data[pos]);
+      chunk32 = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk32, w1), _mm256_cmpeq_epi8(chunk32, w2)), _mm256_cmpeq_epi8(chunk32, w3));
+      if ((mask32 = (unsigned)_mm256_movemask_epi8(chunk32)) != 0)
+         return(pos + (size_t)__builtin_ctz(mask32));
+   };
+#endif
+
+#if defined(__SSE2__)
+   v1 = _mm_set1_epi8(c1);
+   v2 = _mm_set1_epi8(c2);
+   v3 = _mm_set1_epi8(c3);
+   for(; ((pos + 16) <= len); pos += 16)
+   {
+      chunk16 = _mm_loadu_si128((const __m128i *)&data[pos]);
+      chunk16 = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk16, v1), _mm_cmpeq_epi8(chunk16, v2)), _mm_cmpeq_epi8(chunk16, v3));
+      if ((mask16 = (unsigned)_mm_movemask_epi8(chunk16)) != 0)
+         return(pos + (size_t)__builtin_ctz(mask16));
+   };
+#endif
+
+   // scans remaining bytes
+   for(; (pos < len); pos++)
+      if ( (data[pos] == c1) || (data[pos] == c2) || (data[pos] == c3) )
+         return(pos);
+
+   return(len);
+}
+
+
+/// writes buffered bytes to file descriptor
+/// @param[in] out     reference to output buffer
+///
+/// Buffers without a file descriptor are left unchanged.
+///
+/// @return    Returns LDAP_SUCCESS or LDAP_LOCAL_ERROR if an earlier or
+///            the current write failed
+int
+ldaputils_output_flush(
+         LDAPUtilsOutput *             out )
+{
+   struct iovec      iov;
+
+   assert(out != NULL);
+
+   if ( (!(out->len)) || (out->fd < 0) )
+      return(out->err);
+
+   iov.iov_base = out->buff;
+   iov.iov_len  = out->len;
+   out->len     = 0;
+
+   return(ldaputils_output_writev(out, &iov, 1));
+}
+
+
+/// frees output buffer without writing buffered bytes
+/// @param[in] out     reference to output buffer
+///
+/// @see       ldaputils_output_flush, ldaputils_output_initialize
+void
+ldaputils_output_free(
+         LDAPUtilsOutput *             out )
+{
+   if (!(out))
+      return;
+   if ((out->buff))
+      free(out->buff);
+   free(out);
+   return;
+}
+
+
+/// allocates output buffer for file descriptor
+/// @param[out] outp        reference to output buffer pointer
+/// @param[in]  fd          file descriptor receiving output or -1
+/// @param[in]  threshold   number of buffered bytes which are written at
+///                         once or 0 for the default
+///
+/// Output is appended to a single buffer which is written with write(2)
+/// when the threshold is reached instead of through stdio.  Anything
+/// written to the descriptor with stdio must be flushed first.  If `fd'
+/// is -1, output is kept in memory and the buffer is enlarged as needed.
+///
+/// @return    Returns the error code from the OpenLDAP library
+/// @see       ldaputils_output_flush, ldaputils_output_free
+int
+ldaputils_output_initialize(
+         LDAPUtilsOutput **            outp,
+         int                           fd,
+         size_t                        threshold )
+{
+   LDAPUtilsOutput *    out;
+
+   assert(outp != NULL);
+
+   if ((out = malloc(sizeof(LDAPUtilsOutput))) == NULL)
+      return(LDAP_NO_MEMORY);
+   memset(out, 0, sizeof(LDAPUtilsOutput));
+   out->fd   = fd;
+   out->err  = LDAP_SUCCESS;
+   out->size = (threshold > 0) ? threshold : LDAPUTILS_OUTPUT_THRESHOLD;
+
+   if ((out->buff = malloc(out->size)) == NULL)
+   {
+      free(out);
+      return(LDAP_NO_MEMORY);
+   };
+
+   *outp = out;
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// appends value as a quoted JSON string
+/// @param[in] out     reference to output buffer
+/// @param[in] data    UTF-8 value to append
+/// @param[in] len     length of value
+///
+/// Quotes, backslashes, and control characters are escaped as described by
+/// RFC 8259.  Runs of bytes which need no escaping are appended at once.
+/// Bytes which are not part of a valid UTF-8 sequence are replaced with
+/// U+FFFD so that the result is always valid JSON.
+///
+/// @return    Returns the error code from the OpenLDAP library
+/// @see       ldaputils_output_json_value
+int
+ldaputils_output_json(
+         LDAPUtilsOutput *             out,
+         const void *                  data,
+         size_t                        len )
+{
+   size_t         run;
+   size_t         seq;
+   char           esc[6];
+   const char *   str;
+
+   static const char hex[] = "0123456789abcdef";
+
+   assert(out  != NULL);
+   assert(data != NULL);
+
+   str = data;
+
+   ldaputils_output_putc(out, '"');
+
+   while (len > 0)
+   {
+      // appends bytes before next special byte
+      if ((run = ldaputils_output_json_scan(str, len)) > 0)
+         ldaputils_output_write(out, str, run);
+      if (run == len)
+         break;
+      str += run;
+      len -= run;
+
+      // appends multibyte characters and replaces invalid sequences
+      if ((str[0] & 0x80))
+      {
+         for(run = 0; ((run < len) && ((str[run] & 0x80)) && ((seq = ldaputils_output_utf8_seq(&str[run], (len - run))) > 0)); run += seq);
+         if (!(run))
+         {
+            ldaputils_output_write(out, "\xef\xbf\xbd", 3);
+            run = 1;
+         }
+         else
+         {
+            ldaputils_output_write(out, str, run);
+         };
+         str += run;
+         len -= run;
+         continue;
+      };
+
+      // escapes quotes, backslashes, and control characters
+      esc[0] = '\\';
+      switch(str[0])
+      {
+         case '"':
+         case '\\': esc[1] = str[0]; seq = 2; break;
+         case '\b': esc[1] = 'b';    seq = 2; break;
+         case '\f': esc[1] = 'f';    seq = 2; break;
+         case '\n': esc[1] = 'n';    seq = 2; break;
+         case '\r': esc[1] = 'r';    seq = 2; break;
+         case '\t': esc[1] = 't';    seq = 2; break;
+         default:
+         esc[1] = 'u';
+         esc[2] = '0';
+         esc[3] = '0';
+         esc[4] = hex[(str[0] >> 4) & 0x0f];
+         esc[5] = hex[ str[0]       & 0x0f];
+         seq    = 6;
+         break;
+      };
+      ldaputils_output_write(out, esc, seq);
+
+      str++;
+      len--;
+   };
+
+   ldaputils_output_putc(out, '"');
+
+   return(out->err);
+}
+
+
+// finds first byte which is escaped or validated in JSON string
+size_t
+ldaputils_output_json_scan(
+         const char *                  data,
+         size_t                        len )
+{
+   size_t         pos;
+#if defined(__AVX2__)
+   unsigned       mask32;
+   __m256i        w1;
+   __m256i        w2;
+   __m256i        w3;
+   __m256i        chunk32;
+#endif
+#if defined(__SSE2__)
+   unsigned       mask16;
+   __m128i        v1;
+   __m128i        v2;
+   __m128i        v3;
+   __m128i        chunk16;
+#endif
+
+   pos = 0;
+
+   // signed comparison with space matches control characters and bytes
+   // of multibyte characters at once
+#if defined(__AVX2__)
+   w1 = _mm256_set1_epi8('"');
+   w2 = _mm256_set1_epi8('\\');
+   w3 = _mm256_set1_epi8(0x20);
+   for(; ((pos + 32) <= len); pos += 32)
+   {
+      chunk32 = _mm256_loadu_si256((const __m256i *)&data[pos]);
+      chunk32 = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk32, w1), _mm256_cmpeq_epi8(chunk32, w2)), _mm256_cmpgt_epi8(w3, chunk32));
+      if ((mask32 = (unsigned)_mm256_movemask_epi8(chunk32)) != 0)
+         return(pos + (size_t)__builtin_ctz(mask32));
+   };
+#endif
+
+#if defined(__SSE2__)
+   v1 = _mm_set1_epi8('"');
+   v2 = _mm_set1_epi8('\\');
+   v3 = _mm_set1_epi8(0x20);
+   for(; ((pos + 16) <= len); pos += 16)
+   {
+      chunk16 = _mm_loadu_si128((const __m128i *)&data[pos]);
+      chunk16 = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk16, v1), _mm_cmpeq_epi8(chunk16, v2)), _mm_cmplt_epi8(chunk16, v3));
+      if ((mask16 = (unsigned)_mm_movemask_epi8(chunk16)) != 0)
+         return(pos + (size_t)__builtin_ctz(mask16));
+   };
+#endif
+
+   // scans remaining bytes
+   for(; (pos < len); pos++)
+      if ( (data[pos] == '"') || (data[pos] == '\\') || (((unsigned char)data[pos]) < 0x20) || (((unsigned char)data[pos]) >= 0x80) )
+         return(pos);
+
+   return(len);
+}
+
+
+/// appends attribute value as JSON
+/// @param[in] out     reference to output buffer
+/// @param[in] data    value to append
+/// @param[in] len     length of value
+///
+/// Values which are valid UTF-8 are appended as a quoted string.  Other
+/// values, such as certificates or photos, are appended as an object with
+/// the value encoded with base64:
+///
+///    {"base64":"..."}
+///
+/// @return    Returns the error code from the OpenLDAP library
+/// @see       ldaputils_output_json
+int
+ldaputils_output_json_value(
+         LDAPUtilsOutput *             out,
+         const void *                  data,
+         size_t                        len )
+{
+   assert(out  != NULL);
+   assert(data != NULL);
+
+   if ((ldaputils_output_utf8_valid(data, len)))
+      return(ldaputils_output_json(out, data, len));
+
+   ldaputils_output_write(out, "{\"base64\":\"", 11);
+   ldaputils_output_base64(out, data, len);
+   ldaputils_output_write(out, "\"}", 2);
+
+   return(out->err);
+}
+
+
+/// appends formatted string
+/// @param[in] out     reference to output buffer
+/// @param[in] fmt     printf(3) format string
+///
+/// @return    Returns the error code from the OpenLDAP library
+int
+ldaputils_output_printf(
+         LDAPUtilsOutput *             out,
+         const char *                  fmt,
+         ... )
+{
+   int         len;
+   char *      buff;
+   va_list     args;
+
+   assert(out != NULL);
+   assert(fmt != NULL);
+
+   if ((buff = ldaputils_output_reserve(out, LDAPUTILS_OUTPUT_PRINTF_SIZE)) == NULL)
+      return(out->err);
+
+   va_start(args, fmt);
+   len = vsnprintf(buff, (out->size - out->len), fmt, args);
+   va_end(args);
+   if (len < 0)
+      return(LDAP_LOCAL_ERROR);
+
+   // formats again once enough space is reserved
+   if ((size_t)len >= (out->size - out->len))
+   {
+      if ((buff = ldaputils_output_reserve(out, ((size_t)len + 1))) == NULL)
+         return(out->err);
+      va_start(args, fmt);
+      vsnprintf(buff, ((size_t)len + 1), fmt, args);
+      va_end(args);
+   };
+
+   ldaputils_output_commit(out, (size_t)len);
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// appends character
+/// @param[in] out     reference to output buffer
+/// @param[in] c       character
+///
+/// @return    Returns the error code from the OpenLDAP library
+int
+ldaputils_output_putc(
+         LDAPUtilsOutput *             out,
+         int                           c )
+{
+   assert(out != NULL);
+
+   if (out->len >= out->size)
+      if (ldaputils_output_reserve(out, 1) == NULL)
+         return(out->err);
+
+   out->buff[out->len++] = (char)c;
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// appends string
+/// @param[in] out     reference to output buffer
+/// @param[in] str     string
+///
+/// @return    Returns the error code from the OpenLDAP library
+int
+ldaputils_output_puts(
+         LDAPUtilsOutput *             out,
+         const char *                  str )
+{
+   assert(str != NULL);
+   return(ldaputils_output_write(out, str, strlen(str)));
+}
+
+
+/// reserves contiguous space at end of buffer
+/// @param[in] out     reference to output buffer
+/// @param[in] len     number of bytes to reserve
+///
+/// Buffered bytes are written if the space is not available, and the
+/// buffer is enlarged if it is smaller than the requested space.  Escaping
+/// functions reserve the largest possible result, write into the space, and
+/// then append the bytes which were used with ldaputils_output_commit().
+///
+/// @return    Returns pointer to reserved space or NULL on error
+/// @see       ldaputils_output_commit
+char *
+ldaputils_output_reserve(
+         LDAPUtilsOutput *             out,
+         size_t                        len )
+{
+   size_t      size;
+   void *      ptr;
+
+   assert(out != NULL);
+
+   if ((out->size - out->len) >= len)
+      return(&out->buff[out->len]);
+
+   if (ldaputils_output_flush(out) != LDAP_SUCCESS)
+      return(NULL);
+
+   // buffers without a file descriptor still hold their bytes
+   if ((out->size - out->len) < len)
+   {
+      size = ((out->size * 2) > (out->len + len)) ? (out->size * 2) : (out->len + len);
+      if ((ptr = realloc(out->buff, size)) == NULL)
+      {
+         out->err = LDAP_NO_MEMORY;
+         return(NULL);
+      };
+      out->buff = ptr;
+      out->size = size;
+   };
+
+   return(&out->buff[out->len]);
+}
+
+
+// returns length of valid UTF-8 sequence starting with non-ASCII byte or 0
+size_t
+ldaputils_output_utf8_seq(
+         const char *                  data,
+         size_t                        len )
+{
+   size_t                  pos;
+   size_t                  seq;
+   unsigned char           lo;
+   unsigned char           hi;
+   const unsigned char *   str;
+
+   str = (const unsigned char *)data;
+   lo  = 0x80;
+   hi  = 0xbf;
+
+   // rejects overlong encodings, surrogates, and code points above U+10FFFF
+   if      ( (str[0] >= 0xc2) && (str[0] <= 0xdf) )   seq = 2;
+   else if (str[0] == 0xe0)                           { seq = 3; lo = 0xa0; }
+   else if (str[0] == 0xed)                           { seq = 3; hi = 0x9f; }
+   else if ( (str[0] >= 0xe1) && (str[0] <= 0xef) )   seq = 3;
+   else if (str[0] == 0xf0)                           { seq = 4; lo = 0x90; }
+   else if ( (str[0] >= 0xf1) && (str[0] <= 0xf3) )   seq = 4;
+   else if (str[0] == 0xf4)                           { seq = 4; hi = 0x8f; }
+   else
+      return(0);
+
+   if (seq > len)
+      return(0);
+   if ( (str[1] < lo) || (str[1] > hi) )
+      return(0);
+   for(pos = 2; (pos < seq); pos++)
+      if ( (str[pos] < 0x80) || (str[pos] > 0xbf) )
+         return(0);
+
+   return(seq);
+}
+
+
+// determines if value is valid UTF-8
+int
+ldaputils_output_utf8_valid(
+         const char *                  data,
+         size_t                        len )
+{
+   size_t         pos;
+   size_t         seq;
+#if defined(__AVX2__)
+   unsigned       mask32;
+#endif
+#if defined(__SSE2__)
+   unsigned       mask16;
+#endif
+
+   pos = 0;
+
+   while (pos < len)
+   {
+      // skips ASCII bytes
+#if defined(__AVX2__)
+      for(; ((pos + 32) <= len); pos += 32)
+      {
+         if ((mask32 = (unsigned)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i *)&data[pos]))) != 0)
+         {
+            pos += (size_t)__builtin_ctz(mask32);
+            break;
+         };
+      };
+#endif
+#if defined(__SSE2__)
+      for(; ((pos + 16) <= len); pos += 16)
+      {
+         if ((mask16 = (unsigned)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)&data[pos]))) != 0)
+         {
+            pos += (size_t)__builtin_ctz(mask16);
+            break;
+         };
+      };
+#endif
+      for(; ((pos < len) && (!(data[pos] & 0x80))); pos++);
+      if (pos == len)
+         break;
+
+      // validates multibyte character
+      if ((seq = ldaputils_output_utf8_seq(&data[pos], (len - pos))) == 0)
+         return(0);
+      pos += seq;
+   };
+
+   return(1);
+}
+
+
+/// appends bytes
+/// @param[in] out     reference to output buffer
+/// @param[in] data    bytes to append
+/// @param[in] len     number of bytes
+///
+/// Data which does not fit in the remaining buffer is written along with
+/// the buffered bytes using writev(2) instead of being copied.
+///
+/// @return    Returns the error code from the OpenLDAP library
+int
+ldaputils_output_write(
+         LDAPUtilsOutput *             out,
+         const void *                  data,
+         size_t                        len )
+{
+   char *            buff;
+   struct iovec      iov[2];
+
+   assert(out  != NULL);
+   assert(data != NULL);
+
+   if ((out->size - out->len) >= len)
+   {
+      memcpy(&out->buff[out->len], data, len);
+      out->len += len;
+      return(LDAP_SUCCESS);
+   };
+
+   // enlarges buffers without a file descriptor
+   if (out->fd < 0)
+   {
+      if ((buff = ldaputils_output_reserve(out, len)) == NULL)
+         return(out->err);
+      memcpy(buff, data, len);
+      out->len += len;
+      return(LDAP_SUCCESS);
+   };
+
+   iov[0].iov_base = out->buff;
+   iov[0].iov_len  = out->len;
+   iov[1].iov_base = (void *)data;
+   iov[1].iov_len  = len;
+   out->len        = 0;
+
+   return(ldaputils_output_writev(out, iov, 2));
+}
+
+
+// writes vector until complete
+int
+ldaputils_output_writev(
+         LDAPUtilsOutput *             out,
+         struct iovec *                iov,
+         int                           iovcnt )
+{
+   ssize_t     rc;
+   size_t      len;
+
+   assert(out != NULL);
+   assert(iov != NULL);
+
+   if (out->err != LDAP_SUCCESS)
+      return(out->err);
+
+   while (iovcnt > 0)
+   {
+      if ((rc = writev(out->fd, iov, iovcnt)) == -1)
+      {
+         if (errno == EINTR)
+            continue;
+         out->err = LDAP_LOCAL_ERROR;
+         return(out->err);
+      };
+
+      // skips written vectors
+      len = (size_t)rc;
+      while ( (iovcnt > 0) && (len >= iov->iov_len) )
+      {
+         len -= iov->iov_len;
+         iov++;
+         iovcnt--;
+      };
+      if (iovcnt > 0)
+      {
+         iov->iov_base  = &((char *)iov->iov_base)[len];
+         iov->iov_len  -= len;
+      };
+   };
+
+   return(LDAP_SUCCESS);
+}
+
+/* end of source file */
@@ -0,0 +1,527 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2025 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/lparallel.c contains parallel search functions and variables
+ */
+#define _LIB_LIBLDAPUTILS_LPARALLEL_C 1
+#include "lparallel.h"
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+// MARK: - Headers
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <ldap.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "lconfig.h"
+
+
+/////////////////
+//             //
+//  Datatypes  //
+//             //
+/////////////////
+// MARK: - Datatypes
+
+typedef struct ldap_utils_partition    LDAPUtilsPartition;
+typedef struct ldap_utils_parallel     LDAPUtilsParallel;
+typedef struct ldap_utils_worker       LDAPUtilsWorker;
+
+// subtree searched by a single connection
+struct ldap_utils_partition
+{
+   char *                  dn;
+   LDAPUtils *             lud;        // connection which searched partition
+   int                     done;
+   int                     pad0;
+   size_t                  msgs_len;
+   size_t                  msgs_size;
+   LDAPMessage **          msgs;       // entries waiting for their turn
+};
+
+
+// state shared between all connections
+struct ldap_utils_parallel
+{
+   pthread_mutex_t         mutex;
+   pthread_cond_t          cond;       // signaled when head advances
+   int                     ordered;
+   int                     err;
+   size_t                  next;       // next partition to search
+   size_t                  head;       // partition currently being written
+   size_t                  held;       // entries held by all partitions
+   size_t                  parts_len;
+   size_t                  parts_size;
+   LDAPUtilsPartition *    parts;
+   LDAPUtilsSearchFunc     func;
+   void *                  context;
+};
+
+
+// single connection
+struct ldap_utils_worker
+{
+   LDAPUtils *             lud;
+   LDAPUtilsParallel *     par;
+   size_t                  part;
+   pthread_t               thread;
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+// MARK: - Prototypes
+
+static int
+ldaputils_parallel_add_partition(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 msg,
+         void *                        context );
+
+
+static int
+ldaputils_parallel_flush(
+         LDAPUtilsParallel *           par );
+
+
+static void
+ldaputils_parallel_free(
+         LDAPUtilsParallel *           par );
+
+
+static int
+ldaputils_parallel_result(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 msg,
+         void *                        context );
+
+
+static void *
+ldaputils_parallel_worker(
+         void *                        arg );
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+// MARK: - Functions
+
+/// records child of search base as a partition
+/// @param[in] lud       reference to LDAP utilities struct
+/// @param[in] msg       child entry returned by one-level search
+/// @param[in] context   reference to parallel search state
+///
+/// @return    Returns the error code from the OpenLDAP library
+int
+ldaputils_parallel_add_partition(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 msg,
+         void *                        context )
+{
+   size_t                  size;
+   void *                  ptr;
+   LDAPUtilsParallel *     par;
+   LDAPUtilsPartition *    part;
+
+   assert(lud     != NULL);
+   assert(msg     != NULL);
+   assert(context != NULL);
+
+   par = context;
+
+   // grows partition list
+   if (par->parts_len >= par->parts_size)
+   {
+      size = (par->parts_size) ? (par->parts_size * 2) : 64;
+      if ((ptr = realloc(par->parts, (sizeof(LDAPUtilsPartition) * size))) == NULL)
+         return(LDAP_NO_MEMORY);
+      par->parts      = ptr;
+      par->parts_size = size;
+   };
+
+   part = &par->parts[par->parts_len];
+   memset(part, 0, sizeof(LDAPUtilsPartition));
+   if ((part->dn = ldap_get_dn(ldaputils_get_ld(lud), msg)) == NULL)
+      return(LDAP_NO_MEMORY);
+   par->parts_len++;
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// writes buffered entries of completed partitions in order
+/// @param[in] par   reference to parallel search state
+///
+/// Must be called with the mutex held.
+///
+/// @return    Returns the error code from the search callback
+int
+ldaputils_parallel_flush(
+         LDAPUtilsParallel *           par )
+{
+   size_t                  x;
+   int                     err;
+   LDAPUtilsPartition *    part;
+
+   assert(par != NULL);
+
+   while (par->head < par->parts_len)
+   {
+      part = &par->parts[par->head];
+
+      // writes entries received before partition reached the head
+      for(x = 0; x < part->msgs_len; x++)
+      {
+         err = LDAP_SUCCESS;
+         if (par->err == LDAP_SUCCESS)
+            if ((err = par->func(part->lud, part->msgs[x], par->context)) == LDAPUTILS_SEARCH_RETAIN)
+               continue;
+         if (err != LDAP_SUCCESS)
+            par->err = err;
+         ldap_msgfree(part->msgs[x]);
+      };
+      par->held     -= part->msgs_len;
+      part->msgs_len = 0;
+
+      // stops at first partition still being searched
+      if (!(part->done))
+         break;
+      par->head++;
+   };
+   pthread_cond_broadcast(&par->cond);
+
+   return(par->err);
+}
+
+
+/// frees resources used by parallel search state
+/// @param[in] par   reference to parallel search state
+void
+ldaputils_parallel_free(
+         LDAPUtilsParallel *           par )
+{
+   size_t   x;
+   size_t   y;
+
+   assert(par != NULL);
+
+   for(x = 0; x < par->parts_len; x++)
+   {
+      for(y = 0; y < par->parts[x].msgs_len; y++)
+         ldap_msgfree(par->parts[x].msgs[y]);
+      if ((par->parts[x].msgs))
+         free(par->parts[x].msgs);
+      ldap_memfree(par->parts[x].dn);
+   };
+   if ((par->parts))
+      free(par->parts);
+
+   pthread_cond_destroy(&par->cond);
+   pthread_mutex_destroy(&par->mutex);
+
+   return;
+}
+
+
+/// passes entry to search callback or holds it until its partition is written
+/// @param[in] lud       connection which received the entry
+/// @param[in] msg       search entry
+/// @param[in] context   reference to worker
+///
+/// @return    Returns the error code from the search callback
+int
+ldaputils_parallel_result(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 msg,
+         void *                        context )
+{
+   int                     err;
+   size_t                  size;
+   void *                  ptr;
+   LDAPUtilsWorker *       worker;
+   LDAPUtilsParallel *     par;
+   LDAPUtilsPartition *    part;
+
+   assert(lud     != NULL);
+   assert(msg     != NULL);
+   assert(context != NULL);
+
+   worker = context;
+   par    = worker->par;
+   part   = &par->parts[worker->part];
+
+   pthread_mutex_lock(&par->mutex);
+
+   // waits for earlier partitions once too many entries are held
+   while ( ((par->ordered)) && (worker->part != par->head) &&
+           (par->held >= LDAPUTILS_PARALLEL_HELD) && (par->err == LDAP_SUCCESS) )
+      pthread_cond_wait(&par->cond, &par->mutex);
+
+   // abandons search if another connection failed
+   if ((err = par->err) != LDAP_SUCCESS)
+   {
+      pthread_mutex_unlock(&par->mutex);
+      return(err);
+   };
+
+   // writes entry immediately
+   if ( (!(par->ordered)) || (worker->part == par->head) )
+   {
+      if ( ((err = par->func(lud, msg, par->context)) != LDAP_SUCCESS) && (err != LDAPUTILS_SEARCH_RETAIN) )
+      {
+         par->err = err;
+         pthread_cond_broadcast(&par->cond);
+      };
+      pthread_mutex_unlock(&par->mutex);
+      return(err);
+   };
+
+   // holds entry until partition reaches the head
+   if (part->msgs_len >= part->msgs_size)
+   {
+      size = (part->msgs_size) ? (part->msgs_size * 2) : 64;
+      if ((ptr = realloc(part->msgs, (sizeof(LDAPMessage *) * size))) == NULL)
+      {
+         par->err = LDAP_NO_MEMORY;
+         pthread_cond_broadcast(&par->cond);
+         pthread_mutex_unlock(&par->mutex);
+         return(LDAP_NO_MEMORY);
+      };
+      part->msgs      = ptr;
+      part->msgs_size = size;
+   };
+   part->msgs[part->msgs_len++] = msg;
+   par->held++;
+
+   pthread_mutex_unlock(&par->mutex);
+
+   return(LDAPUTILS_SEARCH_RETAIN);
+}
+
+
+/// performs LDAP search using multiple connections
+/// @param[in] lud       reference to LDAP utilities struct
+/// @param[in] conns     number of connections to use
+/// @param[in] ordered   write entries grouped by subtree in the order the
+///                      subtrees were returned by the server
+/// @param[in] func      function called once for each search entry
+/// @param[in] context   opaque reference passed to func
+///
+/// The children of the search base are retrieved with a one-level search
+/// and the subtree of each child is searched by one of `conns' separately
+/// bound connections.  Calls to func are serialized, so func does not need
+/// to be thread safe, however func may be passed the LDAP utilities struct
+/// of any connection.  Searches which are not subtree or children searches
+/// are performed on a single connection.  When ordered, entries of later
+/// subtrees are held in memory until earlier subtrees are written, and
+/// connections stop reading results once LDAPUTILS_PARALLEL_HELD entries
+/// are held.  Connections are read by separate threads, which requires the
+/// thread safe libldap_r with OpenLDAP 2.4.  configure links libldap_r
+/// instead of libldap when it is installed.
+///
+/// @return    Returns the error code from the OpenLDAP library
+/// @see       ldaputils_search_stream, ldaputils_initialize_copy
+int
+ldaputils_search_parallel(
+         LDAPUtils *                   lud,
+         size_t                        conns,
+         int                           ordered,
+         LDAPUtilsSearchFunc           func,
+         void *                        context )
+{
+   int                     err;
+   size_t                  x;
+   size_t                  started;
+   LDAPUtils               level;
+   LDAPUtilsParallel       par;
+   LDAPUtilsWorker *       workers;
+
+   static char *           no_attrs[] = { LDAP_NO_ATTRS, NULL };
+
+   assert(lud  != NULL);
+   assert(func != NULL);
+
+   if ( (conns < 2) || ((lud->scope != LDAP_SCOPE_SUBTREE) && (lud->scope != LDAP_SCOPE_CHILDREN)) )
+      return(ldaputils_search_stream(lud, func, context));
+
+   memset(&par, 0, sizeof(par));
+   par.ordered = ordered;
+   par.func    = func;
+   par.context = context;
+   if (pthread_mutex_init(&par.mutex, NULL) != 0)
+      return(LDAP_LOCAL_ERROR);
+   pthread_cond_init(&par.cond, NULL);
+
+   // searches with a copy of the search parameters, since func may be
+   // reading them in other threads
+   level = *lud;
+
+   // writes base entry
+   if (lud->scope == LDAP_SCOPE_SUBTREE)
+   {
+      level.scope = LDAP_SCOPE_BASE;
+      err = ldaputils_search_stream(&level, func, context);
+      if ( (err != LDAP_SUCCESS) && (err != LDAP_NO_SUCH_OBJECT) )
+      {
+         ldaputils_parallel_free(&par);
+         return(err);
+      };
+   };
+
+   // retrieves children of base as partitions
+   level.scope  = LDAP_SCOPE_ONELEVEL;
+   level.filter = "(objectclass=*)";
+   level.attrs  = no_attrs;
+   err = ldaputils_search_stream(&level, &ldaputils_parallel_add_partition, &par);
+   if (err != LDAP_SUCCESS)
+   {
+      ldaputils_parallel_free(&par);
+      return(err);
+   };
+   if (par.parts_len == 0)
+   {
+      ldaputils_parallel_free(&par);
+      return(LDAP_SUCCESS);
+   };
+
+   // opens and binds connections
+   conns = (conns > LDAPUTILS_CONNS_MAX) ? LDAPUTILS_CONNS_MAX : conns;
+   conns = (conns > par.parts_len)       ? par.parts_len       : conns;
+   if ((workers = malloc(sizeof(LDAPUtilsWorker) * conns)) == NULL)
+   {
+      ldaputils_parallel_free(&par);
+      return(LDAP_NO_MEMORY);
+   };
+   memset(workers, 0, (sizeof(LDAPUtilsWorker) * conns));
+   for(x = 0; ((x < conns) && (err == LDAP_SUCCESS)); x++)
+   {
+      workers[x].par = &par;
+      if ((err = ldaputils_initialize_copy(&workers[x].lud, lud)) != LDAP_SUCCESS)
+         break;
+      workers[x].lud->scope = LDAP_SCOPE_SUBTREE;
+      err = ldaputils_bind_s(workers[x].lud);
+   };
+
+   // starts searches
+   started = 0;
+   for(x = 0; ((x < conns) && (err == LDAP_SUCCESS)); x++)
+   {
+      if (pthread_create(&workers[x].thread, NULL, &ldaputils_parallel_worker, &workers[x]) != 0)
+      {
+         pthread_mutex_lock(&par.mutex);
+         err = par.err = LDAP_LOCAL_ERROR;
+         pthread_cond_broadcast(&par.cond);
+         pthread_mutex_unlock(&par.mutex);
+         break;
+      };
+      started++;
+   };
+
+   // waits for searches to complete
+   for(x = 0; x < started; x++)
+      pthread_join(workers[x].thread, NULL);
+   if (err == LDAP_SUCCESS)
+      err = par.err;
+
+   // frees resources
+   for(x = 0; x < conns; x++)
+      if ((workers[x].lud))
+         ldaputils_unbind(workers[x].lud);
+   free(workers);
+   ldaputils_parallel_free(&par);
+
+   return(err);
+}
+
+
+/// searches partitions until all partitions have been searched
+/// @param[in] arg   reference to worker
+void *
+ldaputils_parallel_worker(
+         void *                        arg )
+{
+   int                     err;
+   LDAPUtilsWorker *       worker;
+   LDAPUtilsParallel *     par;
+
+   assert(arg != NULL);
+
+   worker = arg;
+   par    = worker->par;
+
+   while(1)
+   {
+      // claims next partition
+      pthread_mutex_lock(&par->mutex);
+      if ( (par->err != LDAP_SUCCESS) || (par->next >= par->parts_len) )
+      {
+         pthread_mutex_unlock(&par->mutex);
+         return(NULL);
+      };
+      worker->part = par->next++;
+      par->parts[worker->part].lud = worker->lud;
+      pthread_mutex_unlock(&par->mutex);
+
+      // searches subtree of partition
+      if ((err = ldap_set_option(worker->lud->ld, LDAP_OPT_DEFBASE, par->parts[worker->part].dn)) == LDAP_SUCCESS)
+         err = ldaputils_search_stream(worker->lud, &ldaputils_parallel_result, worker);
+
+      // marks partition complete and writes any waiting partitions
+      pthread_mutex_lock(&par->mutex);
+      if ( (err != LDAP_SUCCESS) && (par->err == LDAP_SUCCESS) )
+      {
+         par->err = err;
+         pthread_cond_broadcast(&par->cond);
+      };
+      par->parts[worker->part].done = 1;
+      if ( ((par->ordered)) && (worker->part == par->head) )
+         ldaputils_parallel_flush(par);
+      pthread_mutex_unlock(&par->mutex);
+   };
+
+   return(NULL);
+}
+
+/* end of source file */
@@ -0,0 +1,461 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2025 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/lpipeline.c contains entry pipeline functions and variables
+ */
+#define _LIB_LIBLDAPUTILS_LPIPELINE_C 1
+#include "lpipeline.h"
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+// MARK: - Headers
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ldap.h>
+#include <pthread.h>
+#include <assert.h>
+
+
+/////////////////
+//             //
+//  Datatypes  //
+//             //
+/////////////////
+// MARK: - Datatypes
+
+typedef struct ldap_utils_pipeline_job       LDAPUtilsPipelineJob;
+typedef struct ldap_utils_pipeline_worker    LDAPUtilsPipelineWorker;
+
+// entry passing through pipeline
+struct ldap_utils_pipeline_job
+{
+   int                        formatted;
+   int                        pad0;
+   LDAPMessage *              msg;
+   LDAPUtilsOutput *          out;     // formatted entry
+};
+
+
+// thread formatting entries
+struct ldap_utils_pipeline_worker
+{
+   LDAPUtilsPipeline *        pipe;
+   void *                     context;
+   LDAP *                     ld;         // unconnected handle used to decode entries
+   pthread_t                  thread;
+};
+
+
+// state shared between receiver, formatters, and writer
+struct ldap_utils_pipeline
+{
+   pthread_mutex_t            mutex;
+   pthread_cond_t             space;      // signaled when an entry is written
+   pthread_cond_t             work;       // signaled when an entry is queued
+   pthread_cond_t             ready;      // signaled when an entry is formatted
+   int                        err;
+   int                        done;
+   size_t                     queued;     // entries passed to pipeline
+   size_t                     claimed;    // entries claimed by formatters
+   size_t                     written;    // entries passed to output
+   size_t                     jobs_len;
+   size_t                     workers_len;
+   size_t                     started;
+   LDAPUtilsOutput *          out;
+   const char *               sep;
+   LDAPUtilsFormatFunc        func;
+   LDAPUtilsPipelineJob *     jobs;       // ring of entries in sequence order
+   LDAPUtilsPipelineWorker *  workers;
+   pthread_t                  writer;
+   int                        writing;
+   int                        pad0;
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+// MARK: - Prototypes
+
+static void *
+ldaputils_pipeline_formatter(
+         void *                        arg );
+
+
+static void
+ldaputils_pipeline_free(
+         LDAPUtilsPipeline *           pipe );
+
+
+static void *
+ldaputils_pipeline_writer(
+         void *                        arg );
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+// MARK: - Functions
+
+/// queues search entry to be formatted and written
+/// @param[in] lud       connection which received the entry
+/// @param[in] msg       search entry
+/// @param[in] context   reference to pipeline
+///
+/// Used as the search callback of ldaputils_search_stream() or
+/// ldaputils_search_parallel().  Waits while the queue is full, so that a
+/// fast server cannot exhaust memory when the output is slow.
+///
+/// @return    Returns LDAPUTILS_SEARCH_RETAIN or the error code of an
+///            earlier entry to abandon the search
+/// @see       ldaputils_pipeline_initialize
+int
+ldaputils_pipeline_entry(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 msg,
+         void *                        context )
+{
+   int                        err;
+   LDAPUtilsPipeline *        pipe;
+   LDAPUtilsPipelineJob *     job;
+
+   assert(lud     != NULL);
+   assert(msg     != NULL);
+   assert(context != NULL);
+
+   pipe = context;
+
+   pthread_mutex_lock(&pipe->mutex);
+
+   // waits for writer to release oldest entry
+   while ( ((pipe->queued - pipe->written) >= pipe->jobs_len) && (pipe->err == LDAP_SUCCESS) )
+      pthread_cond_wait(&pipe->space, &pipe->mutex);
+   if ((err = pipe->err) != LDAP_SUCCESS)
+   {
+      pthread_mutex_unlock(&pipe->mutex);
+      return(err);
+   };
+
+   job            = &pipe->jobs[pipe->queued % pipe->jobs_len];
+   job->msg       = msg;
+   job->formatted = 0;
+   pipe->queued++;
+   pthread_cond_signal(&pipe->work);
+
+   pthread_mutex_unlock(&pipe->mutex);
+
+   return(LDAPUTILS_SEARCH_RETAIN);
+}
+
+
+/// waits for queued entries to be written and frees pipeline
+/// @param[in]  pipe     reference to pipeline
+/// @param[out] countp   reference for number of entries written or NULL
+///
+/// @return    Returns the first error code from the format callback or
+///            the output
+int
+ldaputils_pipeline_finish(
+         LDAPUtilsPipeline *           pipe,
+         size_t *                      countp )
+{
+   int         err;
+
+   assert(pipe != NULL);
+
+   pthread_mutex_lock(&pipe->mutex);
+   pipe->done = 1;
+   pthread_cond_broadcast(&pipe->work);
+   pthread_cond_broadcast(&pipe->ready);
+   pthread_mutex_unlock(&pipe->mutex);
+
+   ldaputils_pipeline_free(pipe);
+
+   err = pipe->err;
+   if ((countp))
+      *countp = pipe->written;
+   free(pipe);
+
+   return(err);
+}
+
+
+/// formats queued entries until pipeline is finished
+/// @param[in] arg   reference to worker
+void *
+ldaputils_pipeline_formatter(
+         void *                        arg )
+{
+   int                        err;
+   LDAPUtilsPipeline *        pipe;
+   LDAPUtilsPipelineJob *     job;
+   LDAPUtilsPipelineWorker *  worker;
+
+   assert(arg != NULL);
+
+   worker = arg;
+   pipe   = worker->pipe;
+
+   pthread_mutex_lock(&pipe->mutex);
+   while(1)
+   {
+      // claims next queued entry
+      while ( (pipe->claimed == pipe->queued) && (!(pipe->done)) )
+         pthread_cond_wait(&pipe->work, &pipe->mutex);
+      if (pipe->claimed == pipe->queued)
+         break;
+      job = &pipe->jobs[pipe->claimed % pipe->jobs_len];
+      pipe->claimed++;
+      err = pipe->err;
+      pthread_mutex_unlock(&pipe->mutex);
+
+      // formats entry unless an earlier entry failed
+      if (err == LDAP_SUCCESS)
+         err = pipe->func(worker->ld, job->msg, job->out, worker->context);
+      ldap_msgfree(job->msg);
+      job->msg = NULL;
+
+      // passes entry to writer
+      pthread_mutex_lock(&pipe->mutex);
+      if ( (err != LDAP_SUCCESS) && (pipe->err == LDAP_SUCCESS) )
+         pipe->err = err;
+      job->formatted = 1;
+      if (job == &pipe->jobs[pipe->written % pipe->jobs_len])
+         pthread_cond_signal(&pipe->ready);
+   };
+   pthread_mutex_unlock(&pipe->mutex);
+
+   return(NULL);
+}
+
+
+// stops threads and frees resources of pipeline except the pipeline
+void
+ldaputils_pipeline_free(
+         LDAPUtilsPipeline *           pipe )
+{
+   size_t      x;
+
+   assert(pipe != NULL);
+
+   for(x = 0; (x < pipe->started); x++)
+      pthread_join(pipe->workers[x].thread, NULL);
+   if ((pipe->writing))
+      pthread_join(pipe->writer, NULL);
+
+   for(x = 0; ( ((pipe->jobs)) && (x < pipe->jobs_len) ); x++)
+   {
+      if ((pipe->jobs[x].msg))
+         ldap_msgfree(pipe->jobs[x].msg);
+      ldaputils_output_free(pipe->jobs[x].out);
+   };
+   if ((pipe->jobs))
+      free(pipe->jobs);
+   for(x = 0; ( ((pipe->workers)) && (x < pipe->workers_len) ); x++)
+      if ((pipe->workers[x].ld))
+         ldap_unbind_ext(pipe->workers[x].ld, NULL, NULL);
+   if ((pipe->workers))
+      free(pipe->workers);
+
+   pthread_cond_destroy(&pipe->ready);
+   pthread_cond_destroy(&pipe->work);
+   pthread_cond_destroy(&pipe->space);
+   pthread_mutex_destroy(&pipe->mutex);
+
+   return;
+}
+
+
+/// starts threads which format search entries and write them in order
+/// @param[out] pipep      reference to pipeline pointer
+/// @param[in]  out        reference to output receiving formatted entries
+/// @param[in]  sep        string written between entries or NULL
+/// @param[in]  threads    number of threads formatting entries
+/// @param[in]  func       function which formats a single entry
+/// @param[in]  contexts   array of `threads' opaque references, one passed
+///                        to func by each thread
+///
+/// Entries passed to ldaputils_pipeline_entry() by the thread receiving
+/// search results are formatted by `threads' threads into separate buffers,
+/// and a single thread appends the buffers to `out' in the order the
+/// entries were received.  The number of entries waiting to be formatted
+/// or written is bounded.  Calls to func are not serialized, so each
+/// context must only be used by a single thread.  `out' must not be used
+/// until ldaputils_pipeline_finish() returns.
+///
+/// Each thread passes func its own unconnected LDAP handle to decode
+/// entries instead of the connection which received them.  libldap records
+/// errors in the handle, so decoding with the connection would race with
+/// the thread waiting in ldap_result(), and the connections of a parallel
+/// search are closed before the last entries are formatted.  Because no
+/// handle is shared between threads, the pipeline does not require the
+/// thread safe libldap_r of OpenLDAP 2.4.
+///
+/// @return    Returns the error code from the OpenLDAP library
+/// @see       ldaputils_pipeline_entry, ldaputils_pipeline_finish
+int
+ldaputils_pipeline_initialize(
+         LDAPUtilsPipeline **          pipep,
+         LDAPUtilsOutput *             out,
+         const char *                  sep,
+         size_t                        threads,
+         LDAPUtilsFormatFunc           func,
+         void **                       contexts )
+{
+   int                  err;
+   size_t               x;
+   LDAPUtilsPipeline *  pipe;
+
+   assert(pipep    != NULL);
+   assert(out      != NULL);
+   assert(threads  > 0);
+   assert(func     != NULL);
+   assert(contexts != NULL);
+
+   if ((pipe = malloc(sizeof(LDAPUtilsPipeline))) == NULL)
+      return(LDAP_NO_MEMORY);
+   memset(pipe, 0, sizeof(LDAPUtilsPipeline));
+   pipe->out         = out;
+   pipe->sep         = sep;
+   pipe->func        = func;
+   pipe->workers_len = threads;
+   pipe->jobs_len    = threads * LDAPUTILS_PIPELINE_JOBS;
+
+   if (pthread_mutex_init(&pipe->mutex, NULL) != 0)
+   {
+      free(pipe);
+      return(LDAP_LOCAL_ERROR);
+   };
+   pthread_cond_init(&pipe->space, NULL);
+   pthread_cond_init(&pipe->work,  NULL);
+   pthread_cond_init(&pipe->ready, NULL);
+
+   // allocates entry buffers
+   err = LDAP_SUCCESS;
+   if ((pipe->jobs = malloc(sizeof(LDAPUtilsPipelineJob) * pipe->jobs_len)) != NULL)
+   {
+      memset(pipe->jobs, 0, (sizeof(LDAPUtilsPipelineJob) * pipe->jobs_len));
+      for(x = 0; ((x < pipe->jobs_len) && (err == LDAP_SUCCESS)); x++)
+         err = ldaputils_output_initialize(&pipe->jobs[x].out, -1, LDAPUTILS_PIPELINE_BUFFER);
+   };
+   if ((pipe->workers = malloc(sizeof(LDAPUtilsPipelineWorker) * threads)) != NULL)
+   {
+      memset(pipe->workers, 0, (sizeof(LDAPUtilsPipelineWorker) * threads));
+      for(x = 0; ((x < threads) && (err == LDAP_SUCCESS)); x++)
+         err = ldap_initialize(&pipe->workers[x].ld, NULL);
+   };
+   if ( (!(pipe->jobs)) || (!(pipe->workers)) || (err != LDAP_SUCCESS) )
+   {
+      ldaputils_pipeline_free(pipe);
+      free(pipe);
+      return(LDAP_NO_MEMORY);
+   };
+
+   // starts writer and formatters
+   if (pthread_create(&pipe->writer, NULL, &ldaputils_pipeline_writer, pipe) == 0)
+      pipe->writing = 1;
+   for(x = 0; ( ((pipe->writing)) && (x < threads) ); x++)
+   {
+      pipe->workers[x].pipe    = pipe;
+      pipe->workers[x].context = contexts[x];
+      if (pthread_create(&pipe->workers[x].thread, NULL, &ldaputils_pipeline_formatter, &pipe->workers[x]) != 0)
+         break;
+      pipe->started++;
+   };
+   if (pipe->started < threads)
+   {
+      ldaputils_pipeline_finish(pipe, NULL);
+      return(LDAP_LOCAL_ERROR);
+   };
+
+   *pipep = pipe;
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// writes formatted entries in order until pipeline is finished
+/// @param[in] arg   reference to pipeline
+void *
+ldaputils_pipeline_writer(
+         void *                        arg )
+{
+   int                        err;
+   LDAPUtilsPipeline *        pipe;
+   LDAPUtilsPipelineJob *     job;
+
+   assert(arg != NULL);
+
+   pipe = arg;
+
+   pthread_mutex_lock(&pipe->mutex);
+   while(1)
+   {
+      // waits for oldest entry to be formatted
+      job = &pipe->jobs[pipe->written % pipe->jobs_len];
+      while ( ((pipe->written == pipe->queued) && (!(pipe->done))) ||
+              ((pipe->written <  pipe->queued) && (!(job->formatted))) )
+         pthread_cond_wait(&pipe->ready, &pipe->mutex);
+      if (pipe->written == pipe->queued)
+         break;
+      err = pipe->err;
+      pthread_mutex_unlock(&pipe->mutex);
+
+      // appends entry unless an earlier entry failed
+      if ( (err == LDAP_SUCCESS) && ((pipe->sep)) && ((pipe->written)) )
+         err = ldaputils_output_puts(pipe->out, pipe->sep);
+      if (err == LDAP_SUCCESS)
+         err = ldaputils_output_write(pipe->out, job->out->buff, job->out->len);
+      job->out->len = 0;
+
+      // releases entry to receiver
+      pthread_mutex_lock(&pipe->mutex);
+      if ( (err != LDAP_SUCCESS) && (pipe->err == LDAP_SUCCESS) )
+         pipe->err = err;
+      pipe->written++;
+      pthread_cond_signal(&pipe->space);
+   };
+   pthread_mutex_unlock(&pipe->mutex);
+
+   return(NULL);
+}
+
+/* end of source file */
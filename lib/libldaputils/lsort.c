@@ -0,0 +1,1351 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2025 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/lsort.c contains parallel sort functions and variables
+ */
+#define _LIB_LIBLDAPUTILS_LSORT_C 1
+#include "lsort.h"
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+// MARK: - Headers
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "larena.h"
+#include "lentry.h"
+
+
+/////////////////
+//             //
+//  Datatypes  //
+//             //
+/////////////////
+// MARK: - Datatypes
+
+typedef struct ldap_utils_sort_job     LDAPUtilsSortJob;
+typedef struct ldap_utils_sort_rule    LDAPUtilsSortRule;
+
+// chunk sorted, or pair of adjacent runs merged, by a single thread
+struct ldap_utils_sort_job
+{
+   pthread_t               thread;
+   int                     started;
+   int                     pad0;
+   int                     (*compar)(const void *, const void *);
+   size_t                  width;
+   size_t                  len1;       // elements in chunk or first run
+   size_t                  len2;       // elements in second run
+   char *                  src;
+   char *                  dst;        // merge destination
+};
+
+
+// sort key encoder of an ordering matching rule
+struct ldap_utils_sort_rule
+{
+   const char *            oid;
+   const char *            name;
+   LDAPUtilsKeyFunc        func;
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+// MARK: - Prototypes
+
+static int
+ldaputils_spill_cmp(
+         const void *                  ptr1,
+         const void *                  ptr2 );
+
+
+static int
+ldaputils_spill_flush(
+         LDAPUtilsSpill *              spill );
+
+
+static void
+ldaputils_spill_heapify(
+         LDAPUtilsSpill *              spill,
+         size_t                        pos );
+
+
+static int
+ldaputils_spill_merge(
+         LDAPUtilsSpill *              spill,
+         size_t                        first,
+         size_t                        count,
+         FILE **                       fsp );
+
+
+static int
+ldaputils_spill_read(
+         LDAPUtilsSpillRun *           run );
+
+
+static int
+ldaputils_spill_rec_cmp(
+         const LDAPUtilsSpillRec *     rec1,
+         const LDAPUtilsSpillRec *     rec2 );
+
+
+static void
+ldaputils_spill_release(
+         LDAPUtilsSpill *              spill,
+         size_t                        first,
+         size_t                        count );
+
+
+static FILE *
+ldaputils_spill_tmpfile(
+         void );
+
+
+static int
+ldaputils_spill_write(
+         FILE *                        fs,
+         const LDAPUtilsSpillRec *     rec );
+
+
+static int64_t
+ldaputils_sortkey_days(
+         int64_t                       year,
+         int64_t                       month,
+         int64_t                       day );
+
+
+static size_t
+ldaputils_sortkey_caseexact(
+         char *                        dst,
+         const char *                  src,
+         size_t                        len );
+
+
+static size_t
+ldaputils_sortkey_caseignore(
+         char *                        dst,
+         const char *                  src,
+         size_t                        len );
+
+
+static size_t
+ldaputils_sortkey_gentime(
+         char *                        dst,
+         const char *                  src,
+         size_t                        len );
+
+
+static size_t
+ldaputils_sortkey_integer(
+         char *                        dst,
+         const char *                  src,
+         size_t                        len );
+
+
+static size_t
+ldaputils_sortkey_invalid(
+         char *                        dst,
+         const char *                  src,
+         size_t                        len,
+         char                          prefix );
+
+
+static size_t
+ldaputils_sortkey_numeric(
+         char *                        dst,
+         const char *                  src,
+         size_t                        len );
+
+
+static size_t
+ldaputils_sortkey_octet(
+         char *                        dst,
+         const char *                  src,
+         size_t                        len );
+
+
+static size_t
+ldaputils_sortkey_string(
+         char *                        dst,
+         const char *                  src,
+         size_t                        len,
+         int                           fold );
+
+
+static void *
+ldaputils_sort_chunk(
+         void *                        arg );
+
+
+static void *
+ldaputils_sort_merge(
+         void *                        arg );
+
+
+static void
+ldaputils_sort_run(
+         LDAPUtilsSortJob *            jobs,
+         size_t                        count,
+         void *                        (*func)(void *) );
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+// MARK: - Variables
+
+static const LDAPUtilsSortRule ldaputils_sort_rules[] =
+{
+   { "2.5.13.3",  "caseIgnoreOrderingMatch",       &ldaputils_sortkey_caseignore },
+   { "2.5.13.6",  "caseExactOrderingMatch",        &ldaputils_sortkey_caseexact },
+   { "2.5.13.9",  "numericStringOrderingMatch",    &ldaputils_sortkey_numeric },
+   { "2.5.13.15", "integerOrderingMatch",          &ldaputils_sortkey_integer },
+   { "2.5.13.18", "octetStringOrderingMatch",      &ldaputils_sortkey_octet },
+   { "2.5.13.28", "generalizedTimeOrderingMatch",  &ldaputils_sortkey_gentime },
+   { NULL,        NULL,                            NULL }
+};
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+// MARK: - Functions
+
+/// adds record to bounded memory sort
+/// @param[in] spill       reference to spill sort
+/// @param[in] key         case folded sort key, bv_val is NULL if the
+///                        entry does not have a sort value
+/// @param[in] dn          DN of entry
+///
+/// Once the records held in memory exceed the memory budget, the records
+/// are sorted and written to a temporary file as a sorted run.
+///
+/// @return    Returns LDAP_SUCCESS or an LDAP error code
+/// @see       ldaputils_spill_next
+int
+ldaputils_spill_add(
+         LDAPUtilsSpill *              spill,
+         const struct berval *         key,
+         const char *                  dn )
+{
+   size_t               len;
+   size_t               size;
+   void *               ptr;
+   LDAPUtilsSpillRec *  rec;
+
+   assert(spill          != NULL);
+   assert(key            != NULL);
+   assert(dn             != NULL);
+   assert(spill->merging == 0);
+
+   // grows list of records
+   if (spill->recs_len >= spill->recs_size)
+   {
+      size = ((spill->recs_size)) ? (spill->recs_size * 2) : 1024;
+      if ((ptr = realloc(spill->recs, (sizeof(LDAPUtilsSpillRec *) * size))) == NULL)
+         return(LDAP_NO_MEMORY);
+      spill->recs      = ptr;
+      spill->recs_size = size;
+   };
+
+   // copies record into arena
+   len = strlen(dn);
+   if ((rec = ldaputils_arena_alloc(spill->arena, sizeof(LDAPUtilsSpillRec))) == NULL)
+      return(LDAP_NO_MEMORY);
+   memset(rec, 0, sizeof(LDAPUtilsSpillRec));
+   if ((rec->dn.bv_val = ldaputils_arena_memdup(spill->arena, dn, len)) == NULL)
+      return(LDAP_NO_MEMORY);
+   rec->dn.bv_len = len;
+   if ((key->bv_val))
+   {
+      if ((rec->key.bv_val = ldaputils_arena_memdup(spill->arena, key->bv_val, key->bv_len)) == NULL)
+         return(LDAP_NO_MEMORY);
+      rec->key.bv_len = key->bv_len;
+   };
+   spill->recs[spill->recs_len++] = rec;
+   spill->used += sizeof(LDAPUtilsSpillRec *) + sizeof(LDAPUtilsSpillRec) + rec->dn.bv_len + rec->key.bv_len + 2;
+
+   // writes sorted run once memory budget is exceeded
+   if (spill->used < spill->max_memory)
+      return(LDAP_SUCCESS);
+   return(ldaputils_spill_flush(spill));
+}
+
+
+// compares records referenced by list of records
+int
+ldaputils_spill_cmp(
+         const void *                  ptr1,
+         const void *                  ptr2 )
+{
+   return(ldaputils_spill_rec_cmp(*((const LDAPUtilsSpillRec * const *)ptr1), *((const LDAPUtilsSpillRec * const *)ptr2)));
+}
+
+
+/// writes records held in memory to temporary file as a sorted run
+/// @param[in] spill       reference to spill sort
+///
+/// Once the last LDAPUTILS_SPILL_FANIN runs have been merged the same number
+/// of times, they are merged into a single run.  This keeps the number of
+/// open runs logarithmic in the number of records.
+///
+/// @return    Returns LDAP_SUCCESS or an LDAP error code
+int
+ldaputils_spill_flush(
+         LDAPUtilsSpill *              spill )
+{
+   int                  err;
+   size_t               x;
+   size_t               first;
+   size_t               level;
+   void *               ptr;
+   FILE *               fs;
+   LDAPUtilsSpillRun *  run;
+
+   assert(spill != NULL);
+
+   if (!(spill->recs_len))
+      return(LDAP_SUCCESS);
+
+   // grows list of runs
+   if ((ptr = realloc(spill->runs, (sizeof(LDAPUtilsSpillRun) * (spill->runs_len + 1)))) == NULL)
+      return(LDAP_NO_MEMORY);
+   spill->runs = ptr;
+   run         = &spill->runs[spill->runs_len];
+   memset(run, 0, sizeof(LDAPUtilsSpillRun));
+
+   // sorts records
+   if (ldaputils_sort(spill->recs, spill->recs_len, sizeof(LDAPUtilsSpillRec *), &ldaputils_spill_cmp, spill->threads) != LDAP_SUCCESS)
+      qsort(spill->recs, spill->recs_len, sizeof(LDAPUtilsSpillRec *), &ldaputils_spill_cmp);
+
+   // writes records
+   if ((fs = ldaputils_spill_tmpfile()) == NULL)
+      return(LDAP_LOCAL_ERROR);
+   for(x = 0; x < spill->recs_len; x++)
+   {
+      if (ldaputils_spill_write(fs, spill->recs[x]) != LDAP_SUCCESS)
+      {
+         fclose(fs);
+         return(LDAP_LOCAL_ERROR);
+      };
+   };
+   if (fflush(fs) != 0)
+   {
+      fclose(fs);
+      return(LDAP_LOCAL_ERROR);
+   };
+   rewind(fs);
+   run->fs = fs;
+   spill->runs_len++;
+
+   // merges runs of the same level, levels never increase along the list
+   while (spill->runs_len >= LDAPUTILS_SPILL_FANIN)
+   {
+      first = spill->runs_len - LDAPUTILS_SPILL_FANIN;
+      level = spill->runs[first].level;
+      if (level != spill->runs[spill->runs_len - 1].level)
+         break;
+      if ((err = ldaputils_spill_merge(spill, first, LDAPUTILS_SPILL_FANIN, &fs)) != LDAP_SUCCESS)
+         return(err);
+      ldaputils_spill_release(spill, first, LDAPUTILS_SPILL_FANIN);
+      spill->runs[first].fs    = fs;
+      spill->runs[first].level = level + 1;
+      spill->runs_len          = first + 1;
+   };
+
+   // releases records held in memory
+   ldaputils_arena_free(spill->arena);
+   if ((spill->arena = ldaputils_arena_initialize(0)) == NULL)
+      return(LDAP_NO_MEMORY);
+   spill->recs_len = 0;
+   spill->used     = 0;
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// frees resources of bounded memory sort
+/// @param[in] spill       reference to spill sort
+///
+/// Temporary files are unlinked when created and are removed when closed.
+void
+ldaputils_spill_free(
+         LDAPUtilsSpill *              spill )
+{
+   size_t      x;
+
+   if (!(spill))
+      return;
+
+   for(x = 0; x < spill->runs_len; x++)
+   {
+      if ((spill->runs[x].fs))
+         fclose(spill->runs[x].fs);
+      free(spill->runs[x].key);
+      free(spill->runs[x].dn);
+   };
+   free(spill->runs);
+   free(spill->heap);
+   free(spill->recs);
+   if ((spill->arena))
+      ldaputils_arena_free(spill->arena);
+   free(spill);
+
+   return;
+}
+
+
+// restores min heap order of runs below position
+void
+ldaputils_spill_heapify(
+         LDAPUtilsSpill *              spill,
+         size_t                        pos )
+{
+   size_t      min;
+   size_t      child;
+   size_t      tmp;
+
+   while(1)
+   {
+      min = pos;
+      for(child = (pos * 2) + 1; ( (child <= ((pos * 2) + 2)) && (child < spill->heap_len) ); child++)
+         if (ldaputils_spill_rec_cmp(&spill->runs[spill->heap[child]].rec, &spill->runs[spill->heap[min]].rec) < 0)
+            min = child;
+      if (min == pos)
+         return;
+      tmp              = spill->heap[pos];
+      spill->heap[pos] = spill->heap[min];
+      spill->heap[min] = tmp;
+      pos              = min;
+   };
+}
+
+
+/// initializes bounded memory sort
+/// @param[out] spillp     returns reference to spill sort
+/// @param[in]  max_memory bytes of records to hold in memory before
+///                        writing a sorted run to disk
+/// @param[in]  threads    number of threads used to sort each run
+///
+/// @return    Returns LDAP_SUCCESS or LDAP_NO_MEMORY
+int
+ldaputils_spill_initialize(
+         LDAPUtilsSpill **             spillp,
+         size_t                        max_memory,
+         size_t                        threads )
+{
+   LDAPUtilsSpill *  spill;
+
+   assert(spillp != NULL);
+
+   if ((spill = malloc(sizeof(LDAPUtilsSpill))) == NULL)
+      return(LDAP_NO_MEMORY);
+   memset(spill, 0, sizeof(LDAPUtilsSpill));
+   spill->max_memory = max_memory;
+   spill->threads    = threads;
+
+   if ((spill->arena = ldaputils_arena_initialize(0)) == NULL)
+   {
+      ldaputils_spill_free(spill);
+      return(LDAP_NO_MEMORY);
+   };
+   if ((spill->heap = malloc(sizeof(size_t) * LDAPUTILS_SPILL_FANIN)) == NULL)
+   {
+      ldaputils_spill_free(spill);
+      return(LDAP_NO_MEMORY);
+   };
+
+   *spillp = spill;
+
+   return(LDAP_SUCCESS);
+}
+
+
+// merges count runs starting with run first into a new sorted run
+int
+ldaputils_spill_merge(
+         LDAPUtilsSpill *              spill,
+         size_t                        first,
+         size_t                        count,
+         FILE **                       fsp )
+{
+   int                  err;
+   size_t               x;
+   FILE *               fs;
+   LDAPUtilsSpillRun *  run;
+
+   assert(spill != NULL);
+   assert(fsp   != NULL);
+
+   *fsp = NULL;
+
+   // reads first record of each run
+   spill->heap_len = 0;
+   for(x = first; x < (first + count); x++)
+   {
+      if ((err = ldaputils_spill_read(&spill->runs[x])) != LDAP_SUCCESS)
+         return(err);
+      if ((spill->runs[x].fs))
+         spill->heap[spill->heap_len++] = x;
+   };
+   for(x = spill->heap_len / 2; x > 0; x--)
+      ldaputils_spill_heapify(spill, (x - 1));
+
+   // writes smallest record of the runs until all runs are exhausted
+   if ((fs = ldaputils_spill_tmpfile()) == NULL)
+      return(LDAP_LOCAL_ERROR);
+   while ((spill->heap_len))
+   {
+      run = &spill->runs[spill->heap[0]];
+      if (ldaputils_spill_write(fs, &run->rec) != LDAP_SUCCESS)
+      {
+         fclose(fs);
+         return(LDAP_LOCAL_ERROR);
+      };
+      if ((err = ldaputils_spill_read(run)) != LDAP_SUCCESS)
+      {
+         fclose(fs);
+         return(err);
+      };
+      if (!(run->fs))
+         spill->heap[0] = spill->heap[--spill->heap_len];
+      ldaputils_spill_heapify(spill, 0);
+   };
+   if (fflush(fs) != 0)
+   {
+      fclose(fs);
+      return(LDAP_LOCAL_ERROR);
+   };
+   rewind(fs);
+
+   *fsp = fs;
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// retrieves DN of next record in sorted order
+/// @param[in]  spill      reference to spill sort
+/// @param[out] dnp        returns DN, or NULL after the last record
+///
+/// The first call sorts the records still held in memory.  If runs were
+/// written to disk, the remaining records are written as a final run and
+/// the runs are merged using a min heap.  While more than
+/// LDAPUTILS_SPILL_FANIN runs exist, groups of runs are first merged into
+/// larger runs, so no more than LDAPUTILS_SPILL_FANIN runs are open at
+/// once.  The returned DN is valid until the next call.  No records may be
+/// added once this is called.
+///
+/// @return    Returns LDAP_SUCCESS or an LDAP error code
+int
+ldaputils_spill_next(
+         LDAPUtilsSpill *              spill,
+         const char **                 dnp )
+{
+   int                  err;
+   size_t               x;
+   size_t               count;
+   size_t               merged;
+   FILE *               fs;
+   LDAPUtilsSpillRun    out;
+   LDAPUtilsSpillRun *  run;
+
+   assert(spill != NULL);
+   assert(dnp   != NULL);
+
+   *dnp = NULL;
+
+   // prepares records for merging
+   if (!(spill->merging))
+   {
+      spill->merging = 1;
+      if (!(spill->runs_len))
+      {
+         if (ldaputils_sort(spill->recs, spill->recs_len, sizeof(LDAPUtilsSpillRec *), &ldaputils_spill_cmp, spill->threads) != LDAP_SUCCESS)
+            qsort(spill->recs, spill->recs_len, sizeof(LDAPUtilsSpillRec *), &ldaputils_spill_cmp);
+      } else {
+         if ((err = ldaputils_spill_flush(spill)) != LDAP_SUCCESS)
+            return(err);
+
+         // merges groups of runs until the runs can be merged at once
+         while (spill->runs_len > LDAPUTILS_SPILL_FANIN)
+         {
+            merged = 0;
+            for(x = 0; x < spill->runs_len; x += count)
+            {
+               count = spill->runs_len - x;
+               if (count > LDAPUTILS_SPILL_FANIN)
+                  count = LDAPUTILS_SPILL_FANIN;
+               if (count == 1)
+               {
+                  out = spill->runs[x];
+                  memset(&spill->runs[x], 0, sizeof(LDAPUtilsSpillRun));
+               } else {
+                  if ((err = ldaputils_spill_merge(spill, x, count, &fs)) != LDAP_SUCCESS)
+                     return(err);
+                  memset(&out, 0, sizeof(LDAPUtilsSpillRun));
+                  out.fs    = fs;
+                  out.level = spill->runs[x].level + 1;
+                  ldaputils_spill_release(spill, x, count);
+               };
+               spill->runs[merged++] = out;
+            };
+            spill->runs_len = merged;
+         };
+
+         // reads first record of each run
+         spill->heap_len = 0;
+         for(x = 0; x < spill->runs_len; x++)
+         {
+            if ((err = ldaputils_spill_read(&spill->runs[x])) != LDAP_SUCCESS)
+               return(err);
+            if ((spill->runs[x].fs))
+               spill->heap[spill->heap_len++] = x;
+         };
+         for(x = spill->heap_len / 2; x > 0; x--)
+            ldaputils_spill_heapify(spill, (x - 1));
+      };
+   };
+
+   // returns records sorted in memory
+   if (!(spill->runs_len))
+   {
+      if (spill->cursor < spill->recs_len)
+         *dnp = spill->recs[spill->cursor++]->dn.bv_val;
+      return(LDAP_SUCCESS);
+   };
+
+   // advances run of previously returned record
+   if ((spill->advance))
+   {
+      spill->advance = 0;
+      run            = &spill->runs[spill->last];
+      if ((err = ldaputils_spill_read(run)) != LDAP_SUCCESS)
+         return(err);
+      if (!(run->fs))
+         spill->heap[0] = spill->heap[--spill->heap_len];
+      ldaputils_spill_heapify(spill, 0);
+   };
+
+   // returns smallest record of all runs
+   if (!(spill->heap_len))
+      return(LDAP_SUCCESS);
+   spill->last    = spill->heap[0];
+   spill->advance = 1;
+   *dnp           = spill->runs[spill->last].rec.dn.bv_val;
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// reads next record of sorted run
+/// @param[in] run         reference to sorted run
+///
+/// The file of the run is closed and set to NULL once all records of the
+/// run have been read.
+///
+/// @return    Returns LDAP_SUCCESS or LDAP_LOCAL_ERROR
+int
+ldaputils_spill_read(
+         LDAPUtilsSpillRun *           run )
+{
+   size_t      keylen;
+   size_t      dnlen;
+   size_t      len;
+   void *      ptr;
+
+   assert(run     != NULL);
+   assert(run->fs != NULL);
+
+   if (fread(&keylen, sizeof(size_t), 1, run->fs) != 1)
+   {
+      fclose(run->fs);
+      run->fs = NULL;
+      return(LDAP_SUCCESS);
+   };
+   if (fread(&dnlen, sizeof(size_t), 1, run->fs) != 1)
+      return(LDAP_LOCAL_ERROR);
+
+   // reads sort key
+   len = (keylen == SIZE_MAX) ? 0 : keylen;
+   if ( (len + 1) > run->key_size)
+   {
+      if ((ptr = realloc(run->key, (len + 1))) == NULL)
+         return(LDAP_NO_MEMORY);
+      run->key      = ptr;
+      run->key_size = len + 1;
+   };
+   if (fread(run->key, 1, len, run->fs) != len)
+      return(LDAP_LOCAL_ERROR);
+   run->rec.key.bv_val = (keylen == SIZE_MAX) ? NULL : run->key;
+   run->rec.key.bv_len = len;
+
+   // reads DN
+   if ( (dnlen + 1) > run->dn_size)
+   {
+      if ((ptr = realloc(run->dn, (dnlen + 1))) == NULL)
+         return(LDAP_NO_MEMORY);
+      run->dn      = ptr;
+      run->dn_size = dnlen + 1;
+   };
+   if (fread(run->dn, 1, dnlen, run->fs) != dnlen)
+      return(LDAP_LOCAL_ERROR);
+   run->dn[dnlen]     = '\0';
+   run->rec.dn.bv_val = run->dn;
+   run->rec.dn.bv_len = dnlen;
+
+   return(LDAP_SUCCESS);
+}
+
+
+// compares records by sort key, then by DN, sorting missing keys last
+int
+ldaputils_spill_rec_cmp(
+         const LDAPUtilsSpillRec *     rec1,
+         const LDAPUtilsSpillRec *     rec2 )
+{
+   int      rc;
+
+   if ( (!(rec1->key.bv_val)) || (!(rec2->key.bv_val)) )
+   {
+      if ( ((rec1->key.bv_val)) || ((rec2->key.bv_val)) )
+         return( ((rec1->key.bv_val)) ? -1 : 1 );
+   }
+   else if ((rc = ldaputils_sortkey_cmp(&rec1->key, &rec2->key)))
+      return(rc);
+
+   return(ldaputils_sortkey_cmp(&rec1->dn, &rec2->dn));
+}
+
+
+// closes runs first to first + count - 1 and frees their buffers
+void
+ldaputils_spill_release(
+         LDAPUtilsSpill *              spill,
+         size_t                        first,
+         size_t                        count )
+{
+   size_t      x;
+
+   for(x = first; x < (first + count); x++)
+   {
+      if ((spill->runs[x].fs))
+         fclose(spill->runs[x].fs);
+      free(spill->runs[x].key);
+      free(spill->runs[x].dn);
+      memset(&spill->runs[x], 0, sizeof(LDAPUtilsSpillRun));
+   };
+
+   return;
+}
+
+
+/// creates temporary file for sorted run
+///
+/// The file is created in $TMPDIR, or /tmp if not set, and is unlinked
+/// immediately so it is removed when closed or when the process exits.
+///
+/// @return    Returns open file or NULL on error
+FILE *
+ldaputils_spill_tmpfile(
+         void )
+{
+   int            fd;
+   FILE *         fs;
+   const char *   dir;
+   char           path[4096];
+
+   if ((dir = getenv("TMPDIR")) == NULL)
+      dir = "/tmp";
+   if (snprintf(path, sizeof(path), "%s/ldaputils.XXXXXX", dir) >= (int)sizeof(path))
+      return(NULL);
+   if ((fd = mkstemp(path)) == -1)
+      return(NULL);
+   unlink(path);
+   if ((fs = fdopen(fd, "w+b")) == NULL)
+      close(fd);
+
+   return(fs);
+}
+
+
+/// writes record to sorted run
+/// @param[in] fs          file of sorted run
+/// @param[in] rec         record to write
+///
+/// Records are written as key length, DN length, key, and DN.  A key length
+/// of SIZE_MAX marks a record without a sort value.
+///
+/// @return    Returns LDAP_SUCCESS or LDAP_LOCAL_ERROR
+int
+ldaputils_spill_write(
+         FILE *                        fs,
+         const LDAPUtilsSpillRec *     rec )
+{
+   size_t      len;
+
+   assert(fs  != NULL);
+   assert(rec != NULL);
+
+   len = ((rec->key.bv_val)) ? rec->key.bv_len : SIZE_MAX;
+   if ( (fwrite(&len, sizeof(size_t), 1, fs) != 1) ||
+        (fwrite(&rec->dn.bv_len, sizeof(size_t), 1, fs) != 1) ||
+        ( ((rec->key.bv_len)) && (fwrite(rec->key.bv_val, 1, rec->key.bv_len, fs) != rec->key.bv_len) ) ||
+        (fwrite(rec->dn.bv_val,  1, rec->dn.bv_len,  fs) != rec->dn.bv_len) )
+      return(LDAP_LOCAL_ERROR);
+
+   return(LDAP_SUCCESS);
+}
+
+
+/// sorts array using multiple threads
+/// @param[in] base        array to sort
+/// @param[in] nel         number of elements in array
+/// @param[in] width       size of each element
+/// @param[in] compar      comparison function with the contract of qsort()
+/// @param[in] threads     maximum number of threads to use
+///
+/// The array is split into one chunk per thread and each chunk is sorted
+/// with qsort().  Adjacent runs are then merged in pairs, in parallel,
+/// until a single run remains.  Small arrays, or a thread count of zero or
+/// one, are sorted with qsort() in the calling thread.
+///
+/// @return    Returns LDAP_SUCCESS or LDAP_NO_MEMORY
+int
+ldaputils_sort(
+         void *                        base,
+         size_t                        nel,
+         size_t                        width,
+         int                           (*compar)(const void *, const void *),
+         size_t                        threads )
+{
+   size_t               x;
+   size_t               runs;
+   size_t               chunk;
+   size_t *             lens;
+   char *               buff;
+   char *               src;
+   char *               dst;
+   char *               ptr;
+   LDAPUtilsSortJob *   jobs;
+
+   assert(compar != NULL);
+
+   // limits threads to chunks worth the overhead
+   if (threads > (nel / LDAPUTILS_SORT_MIN_CHUNK))
+      threads = nel / LDAPUTILS_SORT_MIN_CHUNK;
+   if (threads < 2)
+   {
+      qsort(base, nel, width, compar);
+      return(LDAP_SUCCESS);
+   };
+
+   // allocates merge buffer, run lengths, and jobs
+   buff = malloc(nel * width);
+   lens = malloc(sizeof(size_t) * threads);
+   jobs = malloc(sizeof(LDAPUtilsSortJob) * threads);
+   if ( (!(buff)) || (!(lens)) || (!(jobs)) )
+   {
+      free(buff);
+      free(lens);
+      free(jobs);
+      return(LDAP_NO_MEMORY);
+   };
+   memset(jobs, 0, (sizeof(LDAPUtilsSortJob) * threads));
+
+   // sorts chunks
+   chunk = nel / threads;
+   ptr   = base;
+   for(x = 0; x < threads; x++)
+   {
+      lens[x]        = (x == (threads - 1)) ? (nel - (chunk * x)) : chunk;
+      jobs[x].compar = compar;
+      jobs[x].width  = width;
+      jobs[x].len1   = lens[x];
+      jobs[x].src    = ptr;
+      ptr           += lens[x] * width;
+   };
+   ldaputils_sort_run(jobs, threads, &ldaputils_sort_chunk);
+
+   // merges pairs of adjacent runs
+   src  = base;
+   dst  = buff;
+   runs = threads;
+   while (runs > 1)
+   {
+      ptr = src;
+      for(x = 0; x < (runs / 2); x++)
+      {
+         jobs[x].len1  = lens[(x*2)+0];
+         jobs[x].len2  = lens[(x*2)+1];
+         jobs[x].src   = ptr;
+         jobs[x].dst   = dst + (ptr - src);
+         lens[x]       = jobs[x].len1 + jobs[x].len2;
+         ptr          += lens[x] * width;
+      };
+      ldaputils_sort_run(jobs, (runs / 2), &ldaputils_sort_merge);
+
+      // copies odd run to destination
+      if ((runs % 2))
+      {
+         lens[runs/2] = lens[runs-1];
+         memcpy((dst + (ptr - src)), ptr, (lens[runs/2] * width));
+      };
+
+      runs = (runs / 2) + (runs % 2);
+      ptr  = src;
+      src  = dst;
+      dst  = ptr;
+   };
+
+   // copies sorted array back into place
+   if (src != base)
+      memcpy(base, src, (nel * width));
+
+   free(buff);
+   free(lens);
+   free(jobs);
+
+   return(LDAP_SUCCESS);
+}
+
+
+// sorts chunk of array
+void *
+ldaputils_sort_chunk(
+         void *                        arg )
+{
+   LDAPUtilsSortJob *   job;
+   job = arg;
+   qsort(job->src, job->len1, job->width, job->compar);
+   return(NULL);
+}
+
+
+// merges two adjacent sorted runs into destination
+void *
+ldaputils_sort_merge(
+         void *                        arg )
+{
+   char *               a;
+   char *               b;
+   char *               ea;
+   char *               eb;
+   char *               out;
+   LDAPUtilsSortJob *   job;
+
+   job = arg;
+   a   = job->src;
+   ea  = a + (job->len1 * job->width);
+   b   = ea;
+   eb  = b + (job->len2 * job->width);
+   out = job->dst;
+
+   // takes from first run on ties to keep equal elements in order
+   while ( (a < ea) && (b < eb) )
+   {
+      if (job->compar(b, a) < 0)
+      {
+         memcpy(out, b, job->width);
+         b += job->width;
+      } else {
+         memcpy(out, a, job->width);
+         a += job->width;
+      };
+      out += job->width;
+   };
+
+   memcpy(out, a, (size_t)(ea - a));
+   out += ea - a;
+   memcpy(out, b, (size_t)(eb - b));
+
+   return(NULL);
+}
+
+
+/// runs jobs on threads and waits for them to finish
+/// @param[in] jobs        list of jobs
+/// @param[in] count       number of jobs
+/// @param[in] func        thread start routine
+///
+/// The first job runs in the calling thread.  Jobs whose thread cannot
+/// be created are also run in the calling thread.
+void
+ldaputils_sort_run(
+         LDAPUtilsSortJob *            jobs,
+         size_t                        count,
+         void *                        (*func)(void *) )
+{
+   size_t      x;
+
+   for(x = 1; x < count; x++)
+      jobs[x].started = (pthread_create(&jobs[x].thread, NULL, func, &jobs[x]) == 0) ? 1 : 0;
+
+   func(&jobs[0]);
+   for(x = 1; x < count; x++)
+      if (!(jobs[x].started))
+         func(&jobs[x]);
+
+   for(x = 1; x < count; x++)
+      if ((jobs[x].started))
+         pthread_join(jobs[x].thread, NULL);
+
+   return;
+}
+
+// encodes caseExactOrderingMatch value with insignificant spaces removed
+size_t
+ldaputils_sortkey_caseexact(
+         char *                        dst,
+         const char *                  src,
+         size_t                        len )
+{
+   return(ldaputils_sortkey_string(dst, src, len, 0));
+}
+
+
+// encodes caseIgnoreOrderingMatch value with insignificant spaces removed
+size_t
+ldaputils_sortkey_caseignore(
+         char *                        dst,
+         const char *                  src,
+         size_t                        len )
+{
+   return(ldaputils_sortkey_string(dst, src, len, 1));
+}
+
+
+// returns days since 1970-01-01 of a proleptic Gregorian date
+int64_t
+ldaputils_sortkey_days(
+         int64_t                       year,
+         int64_t                       month,
+         int64_t                       day )
+{
+   int64_t     era;
+   int64_t     yoe;
+   int64_t     doy;
+
+   year -= (month <= 2) ? 1 : 0;
+   era   = ((year >= 0) ? year : (year - 399)) / 400;
+   yoe   = year - (era * 400);
+   doy   = (((153 * (month + ((month > 2) ? -3 : 9))) + 2) / 5) + day - 1;
+   return((era * 146097) + (yoe * 365) + (yoe / 4) - (yoe / 100) + doy - 719468);
+}
+
+
+/// returns sort key encoder of ordering matching rule
+/// @param[in] rule        OID or name of ordering matching rule
+///
+/// The encoder is selected once per sort so that values are parsed only
+/// when keys are generated, never while comparing.  Unknown rules, or a
+/// NULL rule, use case folded string keys.
+///
+/// @return    Returns sort key encoder
+LDAPUtilsKeyFunc
+ldaputils_sortkey_func(
+         const char *                  rule )
+{
+   size_t      x;
+
+   if (!(rule))
+      return(&ldaputils_sortkey_fold);
+
+   for(x = 0; ((ldaputils_sort_rules[x].oid)); x++)
+   {
+      if (!(strcmp(rule, ldaputils_sort_rules[x].oid)))
+         return(ldaputils_sort_rules[x].func);
+      if (!(strcasecmp(rule, ldaputils_sort_rules[x].name)))
+         return(ldaputils_sort_rules[x].func);
+   };
+
+   return(&ldaputils_sortkey_fold);
+}
+
+
+/// encodes generalizedTimeOrderingMatch value
+/// @param[out] dst        buffer of at least LDAPUTILS_SORTKEY_SIZE(len) bytes
+/// @param[in]  src        value to encode
+/// @param[in]  len        length of value
+///
+/// The time is converted to UTC and encoded as a fixed width string of
+/// fourteen digits of date and time followed by nine digits of fractional
+/// seconds.  Times without a time zone are treated as UTC.  Invalid times
+/// sort after all valid times.
+///
+/// @return    Returns length of key
+size_t
+ldaputils_sortkey_gentime(
+         char *                        dst,
+         const char *                  src,
+         size_t                        len )
+{
+   size_t      pos;
+   size_t      x;
+   int64_t     f[6];
+   int64_t     unit;
+   int64_t     frac;
+   int64_t     scale;
+   int64_t     secs;
+   int64_t     days;
+   int64_t     nsec;
+   int64_t     era;
+   int64_t     doe;
+   int64_t     yoe;
+   int64_t     doy;
+   int64_t     mp;
+   int64_t     year;
+   int64_t     month;
+   int64_t     day;
+   int64_t     tz;
+
+   // parses year, month, day, hour, and optional minute and second
+   memset(f, 0, sizeof(f));
+   pos  = 0;
+   unit = 3600;
+   for(x = 0; x < 6; x++)
+   {
+      if ( (x >= 4) && ( (pos >= len) || (src[pos] < '0') || (src[pos] > '9') ) )
+         break;
+      if ((pos + (((x)) ? 2 : 4)) > len)
+         return(ldaputils_sortkey_invalid(dst, src, len, '\x02'));
+      for(scale = ((x)) ? 2 : 4; scale > 0; scale--, pos++)
+      {
+         if ( (src[pos] < '0') || (src[pos] > '9') )
+            return(ldaputils_sortkey_invalid(dst, src, len, '\x02'));
+         f[x] = (f[x] * 10) + (src[pos] - '0');
+      };
+      unit = (x == 4) ? 60 : ((x == 5) ? 1 : unit);
+   };
+   if ( (f[1] < 1) || (f[1] > 12) || (f[2] < 1) || (f[2] > 31) || (f[3] > 23) || (f[4] > 59) || (f[5] > 60) )
+      return(ldaputils_sortkey_invalid(dst, src, len, '\x02'));
+
+   // parses fraction of the last unit as nanoseconds
+   frac = 0;
+   if ( (pos < len) && ( (src[pos] == '.') || (src[pos] == ',') ) )
+   {
+      for(pos++, scale = 100000000; ( (pos < len) && (src[pos] >= '0') && (src[pos] <= '9') ); pos++, scale /= 10)
+         frac += (src[pos] - '0') * scale;
+   };
+
+   // parses time zone
+   tz = 0;
+   if ( (pos < len) && ( (src[pos] == '+') || (src[pos] == '-') ) )
+   {
+      if ( ((pos + 3) > len) || (src[pos+1] < '0') || (src[pos+1] > '9') || (src[pos+2] < '0') || (src[pos+2] > '9') )
+         return(ldaputils_sortkey_invalid(dst, src, len, '\x02'));
+      tz = (((src[pos+1] - '0') * 10) + (src[pos+2] - '0')) * 3600;
+      if ( ((pos + 5) <= len) && (src[pos+3] >= '0') && (src[pos+3] <= '9') && (src[pos+4] >= '0') && (src[pos+4] <= '9') )
+         tz += (((src[pos+3] - '0') * 10) + (src[pos+4] - '0')) * 60;
+      tz = (src[pos] == '-') ? -tz : tz;
+   };
+
+   // converts to UTC
+   secs  = (ldaputils_sortkey_days(f[0], f[1], f[2]) * 86400) + (f[3] * 3600) + (f[4] * 60) + f[5] - tz;
+   nsec  = frac * unit;
+   secs += nsec / 1000000000;
+   nsec  = nsec % 1000000000;
+   days  = ((secs >= 0) ? secs : (secs - 86399)) / 86400;
+   secs -= days * 86400;
+
+   // converts days to civil date
+   days += 719468;
+   era   = ((days >= 0) ? days : (days - 146096)) / 146097;
+   doe   = days - (era * 146097);
+   yoe   = (doe - (doe / 1460) + (doe / 36524) - (doe / 146096)) / 365;
+   doy   = doe - ((365 * yoe) + (yoe / 4) - (yoe / 100));
+   mp    = ((5 * doy) + 2) / 153;
+   day   = doy - (((153 * mp) + 2) / 5) + 1;
+   month = mp + ((mp < 10) ? 3 : -9);
+   year  = yoe + (era * 400) + ((month <= 2) ? 1 : 0);
+   if ( (year < 0) || (year > 9999) )
+      return(ldaputils_sortkey_invalid(dst, src, len, '\x02'));
+
+   dst[0] = '\x01';
+   snprintf(&dst[1], 24, "%04d%02d%02d%02d%02d%02d%09d", (int)year, (int)month, (int)day, (int)(secs / 3600), (int)((secs / 60) % 60), (int)(secs % 60), (int)nsec);
+
+   return(24);
+}
+
+
+/// encodes integerOrderingMatch value
+/// @param[out] dst        buffer of at least LDAPUTILS_SORTKEY_SIZE(len) bytes
+/// @param[in]  src        value to encode
+/// @param[in]  len        length of value
+///
+/// Integers of any length are encoded as a sign byte, the number of digits,
+/// and the digits.  The digit count and digits of negative integers are
+/// inverted so that larger magnitudes sort first.  Invalid integers sort
+/// after all valid integers.
+///
+/// @return    Returns length of key
+size_t
+ldaputils_sortkey_integer(
+         char *                        dst,
+         const char *                  src,
+         size_t                        len )
+{
+   int         neg;
+   size_t      pos;
+   size_t      end;
+   size_t      n;
+   size_t      x;
+
+   // trims spaces, sign, and leading zeros
+   for(pos = 0; ( (pos < len) && (src[pos] == ' ') ); pos++);
+   for(end = len; ( (end > pos) && (src[end-1] == ' ') ); end--);
+   neg = ( (pos < end) && (src[pos] == '-') ) ? 1 : 0;
+   pos += (size_t)neg;
+   if (pos >= end)
+      return(ldaputils_sortkey_invalid(dst, src, len, '\x03'));
+   for(x = pos; x < end; x++)
+      if ( (src[x] < '0') || (src[x] > '9') )
+         return(ldaputils_sortkey_invalid(dst, src, len, '\x03'));
+   for(; ( (pos < end) && (src[pos] == '0') ); pos++);
+   n = end - pos;
+
+   // encodes zero
+   if (!(n))
+   {
+      dst[0] = '\x01';
+      return(1);
+   };
+
+   // encodes sign and number of digits
+   dst[0] = ((neg)) ? '\x00' : '\x02';
+   for(x = 0; x < 4; x++)
+      dst[1+x] = (char)((((neg)) ? ~n : n) >> (24 - (x * 8)));
+
+   // encodes digits
+   for(x = 0; x < n; x++)
+      dst[5+x] = ((neg)) ? (char)('9' - src[pos+x] + '0') : src[pos+x];
+
+   return(n + 5);
+}
+
+
+// encodes value which is not valid for its syntax after all valid values
+size_t
+ldaputils_sortkey_invalid(
+         char *                        dst,
+         const char *                  src,
+         size_t                        len,
+         char                          prefix )
+{
+   dst[0] = prefix;
+   memcpy(&dst[1], src, len);
+   return(len + 1);
+}
+
+
+// encodes numericStringOrderingMatch value with spaces removed
+size_t
+ldaputils_sortkey_numeric(
+         char *                        dst,
+         const char *                  src,
+         size_t                        len )
+{
+   size_t      x;
+   size_t      n;
+   for(x = 0, n = 0; x < len; x++)
+      if (src[x] != ' ')
+         dst[n++] = src[x];
+   return(n);
+}
+
+
+// encodes octetStringOrderingMatch value
+size_t
+ldaputils_sortkey_octet(
+         char *                        dst,
+         const char *                  src,
+         size_t                        len )
+{
+   memcpy(dst, src, len);
+   return(len);
+}
+
+
+/// encodes string value with insignificant spaces removed
+/// @param[out] dst        buffer of at least len bytes
+/// @param[in]  src        value to encode
+/// @param[in]  len        length of value
+/// @param[in]  fold       fold ASCII letters to lower case
+///
+/// Leading and trailing spaces are removed and runs of spaces are replaced
+/// with a single space, as RFC 4518 prepares strings for matching.
+///
+/// @return    Returns length of key
+size_t
+ldaputils_sortkey_string(
+         char *                        dst,
+         const char *                  src,
+         size_t                        len,
+         int                           fold )
+{
+   size_t         x;
+   size_t         n;
+   unsigned char  c;
+
+   for(x = 0, n = 0; x < len; x++)
+   {
+      if ( (src[x] == ' ') && ( (!(n)) || (dst[n-1] == ' ') ) )
+         continue;
+      c        = (unsigned char)src[x];
+      dst[n++] = (char)( ((fold) && (c >= 'A') && (c <= 'Z')) ? (c | 0x20) : c );
+   };
+   if ( ((n)) && (dst[n-1] == ' ') )
+      n--;
+
+   return(n);
+}
+
+
+/* end of source file */
@@ -0,0 +1,114 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2025 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file lib/libldaputils/lsort.h contains prototypes for parallel sort functions and variables
+ */
+#ifndef _LIB_LIBLDAPUTILS_LSORT_H
+#define _LIB_LIBLDAPUTILS_LSORT_H 1
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+// MARK: - Headers
+
+#include "libldaputils.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+// MARK: - Definitions
+
+// smallest number of elements sorted by a single thread
+#define LDAPUTILS_SORT_MIN_CHUNK       16384
+
+// number of entries retrieved concurrently when merging spilled runs
+#define LDAPUTILS_SPILL_FETCH_BATCH    256
+
+// maximum number of sorted runs merged at once, each holding an open file
+#define LDAPUTILS_SPILL_FANIN          64
+
+// size of buffer required to encode sort key of value with length len
+#define LDAPUTILS_SORTKEY_SIZE(len)    ((len) + 32)
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+// MARK: - Prototypes
+
+extern int
+ldaputils_spill_add(
+         LDAPUtilsSpill *              spill,
+         const struct berval *         key,
+         const char *                  dn );
+
+
+extern void
+ldaputils_spill_free(
+         LDAPUtilsSpill *              spill );
+
+
+extern int
+ldaputils_spill_initialize(
+         LDAPUtilsSpill **             spillp,
+         size_t                        max_memory,
+         size_t                        threads );
+
+
+extern int
+ldaputils_spill_next(
+         LDAPUtilsSpill *              spill,
+         const char **                 dnp );
+
+
+extern LDAPUtilsKeyFunc
+ldaputils_sortkey_func(
+         const char *                  rule );
+
+
+extern int
+ldaputils_sort(
+         void *                        base,
+         size_t                        nel,
+         size_t                        width,
+         int                           (*compar)(const void *, const void *),
+         size_t                        threads );
+
+#endif /* end of header file */
@@ -48,9 +48,12 @@
 #include <ldap.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <assert.h>
 
+#include "larena.h"
 #include "lconfig.h"
+#include "ldn.h"
 #include "lentry.h"
 
 
@@ -64,6 +67,9 @@
 #define LDAPUTILS_TREE_SPACE 0
 #define LDAPUTILS_TREE_DATA 1
 
+#define LDAPUTILS_TREE_INDEX_MIN_CHILDREN    8
+#define LDAPUTILS_TREE_INDEX_MIN_SIZE        16
+
 /////////////////
 //             //
 //  Datatypes  //
@@ -73,20 +79,39 @@
 
 struct ldap_utils_tree
 {
-   char *               rdn;
+   const char *         rdn;        // interned in table of root
    LDAPUtilsEntry *     entry;
    LDAPUtilsTree *      parent;
    size_t               children_len;
-   LDAPUtilsTree **     children;
+   size_t               children_size;
+   size_t               index_size; // power of two, at most half full
+   LDAPUtilsTree **     children;   // ordered by RDN only if sorted is set
+   LDAPUtilsTree **     index;      // open addressing hash of children
+   LDAPUtilsDNCache *   dncache;    // DN suffixes and tree arena, only set on root
+   size_t               descendants;
+   size_t               leafs;      // descendants without children
+   size_t               branches;   // children with children
+   size_t               height;     // levels of descendants
+   int                  sorted;
+   int                  counted;    // statistics are current, only set on root
 };
 
 typedef struct ldap_utils_tree_recur LDAPUtilsTreeRecursion;
+typedef struct ldap_utils_tree_search LDAPUtilsTreeSearch;
 
 struct ldap_utils_tree_recur
 {
    char *               map;
    size_t               lastline;   // last line contained data
    LDAPUtilsTreeOpts *  opts;
+   LDAPUtilsOutput *    out;
+};
+
+struct ldap_utils_tree_search
+{
+   LDAPUtilsTree *      tree;
+   int                  copy;
+   int                  pad0;
 };
 
 
@@ -100,29 +125,62 @@ struct ldap_utils_tree_recur
 static int
 ldaputils_tree_add_dn_components(
          LDAPUtilsTree *               tree,
-         char **                       components,
+         const char * const *          components,
          size_t                        components_len,
+         LDAPUtilsDNSuffix *           suffix,
          LDAPUtilsTree **              nodep );
 
 
+static int
+ldaputils_tree_child_cmp(
+         const void *                  ptr1,
+         const void *                  ptr2 );
+
+
 static LDAPUtilsTree *
 ldaputils_tree_child_find(
          LDAPUtilsTree *               tree,
-         const char *                  rdn,
-         size_t *                      prevp );
+         const char *                  rdn );
 
 
 static LDAPUtilsTree *
 ldaputils_tree_child_init(
          LDAPUtilsTree *               tree,
+         LDAPUtilsArena *              arena,
          const char *                  rdn );
 
 
 static void
-ldaputils_tree_level_count_recursive(
+ldaputils_tree_children_sort(
+         LDAPUtilsTree *               tree );
+
+
+static LDAPUtilsDNCache *
+ldaputils_tree_dncache(
+         LDAPUtilsTree *               tree );
+
+
+static int
+ldaputils_tree_index(
          LDAPUtilsTree *               tree,
-         size_t                        level,
-         size_t *                      depthp );
+         LDAPUtilsArena *              arena,
+         size_t                        count );
+
+
+static size_t
+ldaputils_tree_index_hash(
+         const char *                  rdn );
+
+
+static LDAPUtilsTree **
+ldaputils_tree_index_slot(
+         LDAPUtilsTree *               tree,
+         const char *                  rdn );
+
+
+static LDAPUtilsTree *
+ldaputils_tree_root(
+         LDAPUtilsTree *               tree );
 
 
 static void
@@ -147,6 +205,18 @@ ldaputils_tree_print_recursive(
          LDAPUtilsTreeRecursion *      recur );
 
 
+static int
+ldaputils_tree_search_entry(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 msg,
+         void *                        context );
+
+
+static void
+ldaputils_tree_stats(
+         LDAPUtilsTree *               tree );
+
+
 /////////////////
 //             //
 //  Functions  //
@@ -157,6 +227,9 @@ ldaputils_tree_print_recursive(
 /// retrieves LDAP entries from result
 /// @param[in] ld      refernce to LDAP socket data
 /// @param[in] res     refernce to LDAP result message
+///
+/// The complete result chain must be retained while the tree is built, use
+/// ldaputils_tree_search() to build the tree as the entries are received.
 LDAPUtilsTree *
 ldaputils_get_tree(
          LDAP *                        ld,
@@ -164,14 +237,8 @@ ldaputils_get_tree(
          int                           copy )
 {
    int                  err;
-   char *               name;
-   char *               str;
-   BerElement *         ber;
    LDAPMessage *        msg;
-   struct berval **     vals;
-   LDAPUtilsEntry *     entry;
    LDAPUtilsTree *      tree;
-   LDAPUtilsTree *      node;
 
    assert(ld  != NULL);
    assert(res != NULL);
@@ -182,51 +249,11 @@ ldaputils_get_tree(
    msg = ldap_first_entry(ld, res);
    while(msg)
    {
-      // add node to tree
-      if ((str = ldap_get_dn(ld, msg)) == NULL)
+      if ((err = ldaputils_tree_add_message(tree, ld, msg, copy)) != LDAP_SUCCESS)
       {
          ldaputils_tree_free(tree);
          return(NULL);
       };
-      if ((err = ldaputils_tree_add_dn(tree, str, &node)) != LDAP_SUCCESS)
-      {
-         free(str);
-         ldaputils_tree_free(tree);
-         return(NULL);
-      };
-
-      // copy entry
-      if ((copy))
-      {
-
-         // create entry
-         if ((entry = ldaputils_entry_initialize(str)) == NULL)
-         {
-            free(str);
-            ldaputils_tree_free(tree);
-            return(NULL);
-         };
-
-         // retrieves attributes
-         name = ldap_first_attribute(ld, msg, &ber);
-         while(name != NULL)
-         {
-            // retrieve values
-            if ((vals = ldap_get_values_len(ld, msg, name)) != NULL)
-            {
-               ldaputils_entry_add_attribute(entry, name, vals);
-               ldaputils_value_free_len(vals);
-            };
-
-            name = ldap_next_attribute(ld, msg, ber);
-         };
-         ber_free(ber, 0);
-
-         // save entry
-         node->entry = entry;
-      };
-
-      free(str);
       msg = ldap_next_entry(ld, msg);
    };
 
@@ -240,60 +267,69 @@ ldaputils_tree_add_dn(
          const char *                  dn,
          LDAPUtilsTree **              nodep )
 {
-   char **        components;
-   size_t         components_len;
-   size_t         u;
-   char *         str;
-   int            err;
+   int               err;
+   LDAPUtilsDN *     pdn;
 
    assert(tree  != NULL);
    assert(dn    != NULL);
 
-   // explode DN into components and reverse order
-   if ((components = ldap_explode_dn(dn, 0)) == NULL)
+   // parses DN with parent RDNs interned in the table of the tree
+   if ((pdn = ldaputils_dn_parse(ldaputils_tree_dncache(tree), dn)) == NULL)
       return(LDAP_NO_MEMORY);
-   for(components_len = 0; ((components[components_len])); components_len++);
-   for(u = 0; (u < (components_len/2)); u++)
-   {
-      str                            = components[u];
-      components[u]                  = components[components_len-u-1];
-      components[components_len-u-1] = str;
-   };
 
    // loop through DN components
-   if ((err = ldaputils_tree_add_dn_components(tree, components, components_len, nodep)) != LDAP_SUCCESS)
-   {
-      ldaputils_value_free(components);
-      return(LDAP_NO_MEMORY);
-   };
+   err = ldaputils_tree_add_dn_components(tree, pdn->components, pdn->components_len, pdn->suffix, nodep);
 
-   ldaputils_value_free(components);
+   ldaputils_dn_free(pdn);
 
-   return(LDAP_SUCCESS);
+   return(err);
 }
 
 
+/// adds nodes for DN components to tree
+/// @param[in] tree             reference to tree
+/// @param[in] components       DN components starting with the root
+/// @param[in] components_len   number of DN components
+/// @param[in] suffix           interned suffix of the leading components or NULL
+/// @param[out] nodep           node of last component
+///
+/// Nodes reference their RDN instead of copying it, so components which
+/// are not already interned in the table of the tree, such as the leftmost
+/// RDN of a parsed DN, are interned first.
+///
+/// @return    Returns the error code from the OpenLDAP library
 int
 ldaputils_tree_add_dn_components(
          LDAPUtilsTree *               tree,
-         char **                       components,
+         const char * const *          components,
          size_t                        components_len,
+         LDAPUtilsDNSuffix *           suffix,
          LDAPUtilsTree **              nodep )
 {
-   size_t            cur_comp;
-   LDAPUtilsTree *   child;
+   size_t               cur_comp;
+   const char *         rdn;
+   LDAPUtilsTree *      child;
+   LDAPUtilsDNCache *   dncache;
+   size_t               interned;
+
+   dncache = ldaputils_tree_dncache(tree);
+   ldaputils_tree_root(tree)->counted = 0;
 
    // loop through DN components
+   interned = ((suffix)) ? suffix->depth : 0;
    for (cur_comp = 0; cur_comp < components_len; cur_comp++)
    {
-      child = NULL;
-
-      if ((child = ldaputils_tree_child_init(tree, components[cur_comp])) == NULL)
+      rdn = components[cur_comp];
+      if (cur_comp >= interned)
       {
-         ldaputils_value_free(components);
-         return(LDAP_NO_MEMORY);
+         if ((suffix = ldaputils_dn_intern(dncache, suffix, rdn, strlen(rdn))) == NULL)
+            return(LDAP_NO_MEMORY);
+         rdn = suffix->rdn;
       };
 
+      if ((child = ldaputils_tree_child_init(tree, dncache->arena, rdn)) == NULL)
+         return(LDAP_NO_MEMORY);
+
       // step up to child
       tree = child;
    };
@@ -305,6 +341,100 @@ ldaputils_tree_add_dn_components(
 }
 
 
+/// adds LDAP entry message to tree
+/// @param[in] tree    reference to tree
+/// @param[in] ld      refernce to LDAP socket data
+/// @param[in] msg     refernce to LDAP entry message
+/// @param[in] copy    copy attributes of entry into tree
+///
+/// Without copying attributes, only the DN is decoded from the message and
+/// no entry is allocated.
+///
+/// @return    Returns the error code from the OpenLDAP library
+int
+ldaputils_tree_add_message(
+         LDAPUtilsTree *               tree,
+         LDAP *                        ld,
+         LDAPMessage *                 msg,
+         int                           copy )
+{
+   int                  err;
+   char *               name;
+   char *               str;
+   BerElement *         ber;
+   struct berval        bv;
+   struct berval **     vals;
+   LDAPUtilsDN *        pdn;
+   LDAPUtilsEntry *     entry;
+   LDAPUtilsTree *      node;
+
+   assert(tree != NULL);
+   assert(ld   != NULL);
+   assert(msg  != NULL);
+
+   // parses DN in place when only the structure is needed
+   if (!(copy))
+   {
+      if ((err = ldap_get_dn_ber(ld, msg, &ber, &bv)) != LDAP_SUCCESS)
+         return(err);
+      pdn = ldaputils_dn_parse_bv(ldaputils_tree_dncache(tree), &bv);
+      ber_free(ber, 0);
+      if (!(pdn))
+         return(LDAP_NO_MEMORY);
+      err = ldaputils_tree_add_dn_components(tree, pdn->components, pdn->components_len, pdn->suffix, NULL);
+      ldaputils_dn_free(pdn);
+      return(err);
+   };
+
+   // parses DN once for both the tree and the entry
+   if ((str = ldap_get_dn(ld, msg)) == NULL)
+      return(LDAP_NO_MEMORY);
+   if ((pdn = ldaputils_dn_parse(ldaputils_tree_dncache(tree), str)) == NULL)
+   {
+      ldap_memfree(str);
+      return(LDAP_NO_MEMORY);
+   };
+
+   // add node to tree
+   if ((err = ldaputils_tree_add_dn_components(tree, pdn->components, pdn->components_len, pdn->suffix, &node)) != LDAP_SUCCESS)
+   {
+      ldaputils_dn_free(pdn);
+      ldap_memfree(str);
+      return(err);
+   };
+
+   // create entry
+   if ((entry = ldaputils_entry_initialize_dn(str, pdn)) == NULL)
+   {
+      ldap_memfree(str);
+      return(LDAP_NO_MEMORY);
+   };
+   ldap_memfree(str);
+
+   // retrieves attributes
+   name = ldap_first_attribute(ld, msg, &ber);
+   while(name != NULL)
+   {
+      // retrieve values
+      if ((vals = ldap_get_values_len(ld, msg, name)) != NULL)
+      {
+         ldaputils_entry_add_attribute(entry, name, vals);
+         ldaputils_value_free_len(vals);
+      };
+
+      name = ldap_next_attribute(ld, msg, ber);
+   };
+   ber_free(ber, 0);
+
+   // save entry
+   if ((node->entry))
+      ldaputils_entry_free(node->entry);
+   node->entry = entry;
+
+   return(LDAP_SUCCESS);
+}
+
+
 int
 ldaputils_tree_add_entry(
          LDAPUtilsTree *               tree,
@@ -317,162 +447,173 @@ ldaputils_tree_add_entry(
    assert(tree  != NULL);
    assert(entry != NULL);
 
-   if ((err = ldaputils_tree_add_dn_components(tree, entry->components, entry->components_len, &child)) != LDAP_SUCCESS)
+   if ((err = ldaputils_tree_add_dn_components(tree, entry->components, entry->components_len, NULL, &child)) != LDAP_SUCCESS)
       return(LDAP_NO_MEMORY);
 
    if (!(copy))
       return(LDAP_SUCCESS);
 
    // copy entry into tree
-   if ((tree->entry = ldaputils_entry_copy(entry)) == NULL)
+   if ((child->entry))
+      ldaputils_entry_free(child->entry);
+   if ((child->entry = ldaputils_entry_copy(entry)) == NULL)
       return(LDAP_NO_MEMORY);
 
    return(LDAP_SUCCESS);
 }
 
 
+// compares RDNs of children
+int
+ldaputils_tree_child_cmp(
+         const void *                  ptr1,
+         const void *                  ptr2 )
+{
+   const LDAPUtilsTree * const * child1 = ptr1;
+   const LDAPUtilsTree * const * child2 = ptr2;
+   return(strcasecmp((*child1)->rdn, (*child2)->rdn));
+}
+
+
+/// finds child of node by RDN
+/// @param[in] tree    reference to node
+/// @param[in] rdn     RDN of child
+///
+/// Nodes with few children are searched linearly, otherwise the hash
+/// index of the children is used.
+///
+/// @return    Returns child or NULL if the node does not have the child
 LDAPUtilsTree *
 ldaputils_tree_child_find(
          LDAPUtilsTree *               tree,
-         const char *                  rdn,
-         size_t *                      idxp )
+         const char *                  rdn )
 {
-   size_t         low;
-   size_t         mid;
-   size_t         high;
-   int            res;
+   size_t         u;
 
    assert(tree != NULL);
    assert(rdn  != NULL);
 
-   if (tree->children_len == 0)
-      return(NULL);
-
-   low   = 0;
-   high  = tree->children_len - 1;
-
-   while((high - low) > 1)
-   {
-      mid = (low + high) / 2;
-      res = strcasecmp(rdn, tree->children[mid]->rdn);
-      if (res < 0)
-         high = mid;
-      else if (res > 0)
-         low = mid;
-      else
-      {
-         if ((idxp))
-            *idxp = mid;
-         return(tree->children[mid]);
-      };
-   };
-
-   // checks low value
-   if ((res = strcasecmp(rdn, tree->children[low]->rdn)) == 0)
-   {
-      if ((idxp))
-         *idxp = low;
-      return(tree->children[low]);
-   };
-   if (res < 0)
-   {
-      if ((idxp))
-         *idxp = low;
-      return(NULL);
-   };
+   if ((tree->index))
+      return(*ldaputils_tree_index_slot(tree, rdn));
 
-   // checks high value
-   if ((res = strcasecmp(rdn, tree->children[high]->rdn)) > 0)
-   {
-      if ((idxp))
-         *idxp = high+1;
-      return(NULL);
-   };
-   if ((idxp))
-      *idxp = high;
-   if (res == 0)
-      return(tree->children[high]);
+   for(u = 0; (u < tree->children_len); u++)
+      if (!(strcasecmp(rdn, tree->children[u]->rdn)))
+         return(tree->children[u]);
 
    return(NULL);
 }
 
 
+/// adds child to node unless the node already has the child
+/// @param[in] tree    reference to node
+/// @param[in] arena   arena of the tree
+/// @param[in] rdn     interned RDN of child
+///
+/// Nodes, children lists and indexes are allocated from the arena of the
+/// tree, which also holds the interned RDNs, so that a tree is stored in
+/// a few large blocks and released at once.  Lists replaced while
+/// growing are not reclaimed, which at most doubles their memory.
+///
+/// @return    Returns child or NULL on error
 LDAPUtilsTree *
 ldaputils_tree_child_init(
          LDAPUtilsTree *               tree,
+         LDAPUtilsArena *              arena,
          const char *                  rdn )
 {
    LDAPUtilsTree *   child;
    size_t            size;
-   size_t            idx;
-   size_t            u;
    void *            ptr;
 
    assert(tree  != NULL);
+   assert(arena != NULL);
    assert(rdn   != NULL);
 
-   // increase size of children list
-   size = sizeof(LDAPUtilsTree *) * (tree->children_len + 2);
-   if ((ptr = realloc(tree->children, size)) == NULL)
-      return(NULL);
-   tree->children = ptr;
-   tree->children[tree->children_len+1] = NULL;
-
    // search for existing child
-   idx = 0;
-   if ((child = ldaputils_tree_child_find(tree, rdn, &idx)) != NULL)
+   if ((child = ldaputils_tree_child_find(tree, rdn)) != NULL)
       return(child);
 
+   // grows children list geometrically
+   if (tree->children_len >= tree->children_size)
+   {
+      size = ((tree->children_size)) ? (tree->children_size * 2) : 4;
+      if ((ptr = ldaputils_arena_alloc(arena, (sizeof(LDAPUtilsTree *) * size))) == NULL)
+         return(NULL);
+      if ((tree->children))
+         memcpy(ptr, tree->children, (sizeof(LDAPUtilsTree *) * tree->children_len));
+      tree->children      = ptr;
+      tree->children_size = size;
+   };
+
+   // indexes children once a linear search becomes expensive
+   if ((tree->children_len + 1) >= LDAPUTILS_TREE_INDEX_MIN_CHILDREN)
+      if (ldaputils_tree_index(tree, arena, (tree->children_len + 1)) != LDAP_SUCCESS)
+         return(NULL);
+
    // initialize child
-   if ((child = malloc(sizeof(LDAPUtilsTree))) == NULL)
+   if ((child = ldaputils_arena_alloc(arena, sizeof(LDAPUtilsTree))) == NULL)
       return(NULL);
    memset(child, 0, sizeof(LDAPUtilsTree));
+   child->sorted = 1;
 
-   // copy RDN
-   if ((child->rdn = strdup(rdn)) == NULL)
-   {
-      ldaputils_tree_free(child);
-      return(NULL);
-   };
+   // references interned RDN
+   child->rdn = rdn;
+
+   // children are sorted when printed unless they were added in order
+   if (!(tree->children_len))
+      tree->sorted = 1;
+   else if (strcasecmp(tree->children[tree->children_len-1]->rdn, rdn) > 0)
+      tree->sorted = 0;
 
    // save child to children list
    child->parent                        = tree;
    tree->children[tree->children_len++] = child;
-   tree->children[tree->children_len]   = NULL;
-
-   for (u = tree->children_len; u > idx; u--)
-      tree->children[u] = tree->children[u-1];
-   tree->children[u] = child;
+   if ((tree->index))
+      *ldaputils_tree_index_slot(tree, rdn) = child;
 
    return(child);
 }
 
 
+// sorts children by RDN if they were added out of order
+void
+ldaputils_tree_children_sort(
+         LDAPUtilsTree *               tree )
+{
+   assert(tree != NULL);
+   if ((tree->sorted))
+      return;
+   qsort(tree->children, tree->children_len, sizeof(LDAPUtilsTree *), &ldaputils_tree_child_cmp);
+   tree->sorted = 1;
+   return;
+}
+
+
+// retrieves table of DN suffixes from root of tree
+LDAPUtilsDNCache *
+ldaputils_tree_dncache(
+         LDAPUtilsTree *               tree )
+{
+   assert(tree != NULL);
+   return(ldaputils_tree_root(tree)->dncache);
+}
+
+
 void
 ldaputils_tree_free(
          LDAPUtilsTree *               tree )
 {
    LDAPUtilsTree *   child;
-   LDAPUtilsTree *   parent;
 
    assert(tree != NULL);
 
-   parent = NULL;
-   child  = tree;
-
+   // frees entries of nodes
+   child = tree;
    while(child != NULL)
    {
       // traverse to end of tree
       while(child->children_len > 0)
          child = child->children[(child->children_len--)-1];
-      parent = child->parent;
-
-      // free RDN
-      if ((child->rdn))
-      {
-         free(child->rdn);
-         child->rdn = NULL;
-      };
 
       // free entry
       if ((child->entry))
@@ -481,20 +622,103 @@ ldaputils_tree_free(
          child->entry = NULL;
       };
 
-      // free children array
-      if ((child->children))
-      {
-         free(child->children);
-         child->children = NULL;
-      };
+      child = (child != tree) ? child->parent : NULL;
+   };
+
+   // nodes are released with the arena of the root
+   if ((tree->dncache))
+      ldaputils_dn_cache_free(tree->dncache);
+
+   return;
+}
+
 
-      // free node
-      free(child);
+/// rebuilds hash index of children
+/// @param[in] tree        reference to node
+/// @param[in] arena       arena of the tree
+/// @param[in] count       number of children to index
+///
+/// The index is kept at most half full so that linear probing remains
+/// short.
+///
+/// @return    Returns LDAP_SUCCESS or LDAP_NO_MEMORY
+int
+ldaputils_tree_index(
+         LDAPUtilsTree *               tree,
+         LDAPUtilsArena *              arena,
+         size_t                        count )
+{
+   size_t               size;
+   size_t               u;
+   LDAPUtilsTree **     index;
 
-      child = parent;
+   assert(tree != NULL);
+
+   if ((count * 2) <= tree->index_size)
+      return(LDAP_SUCCESS);
+
+   for(size = LDAPUTILS_TREE_INDEX_MIN_SIZE; (size < (count * 2)); size *= 2);
+
+   if ((index = ldaputils_arena_alloc(arena, (sizeof(LDAPUtilsTree *) * size))) == NULL)
+      return(LDAP_NO_MEMORY);
+   memset(index, 0, (sizeof(LDAPUtilsTree *) * size));
+
+   tree->index      = index;
+   tree->index_size = size;
+   for(u = 0; (u < tree->children_len); u++)
+      *ldaputils_tree_index_slot(tree, tree->children[u]->rdn) = tree->children[u];
+
+   return(LDAP_SUCCESS);
+}
+
+
+// case insensitive FNV-1a hash of RDN
+size_t
+ldaputils_tree_index_hash(
+         const char *                  rdn )
+{
+   size_t         hash;
+   unsigned char  c;
+
+   assert(rdn != NULL);
+
+   hash = (size_t)2166136261U;
+   for(; ((*rdn)); rdn++)
+   {
+      c     = (unsigned char)*rdn;
+      hash ^= (size_t)( ((c >= 'A') && (c <= 'Z')) ? (c | 0x20) : c );
+      hash *= (size_t)16777619U;
    };
 
-   return;
+   return(hash);
+}
+
+
+/// finds index slot of child
+/// @param[in] tree        reference to node
+/// @param[in] rdn         RDN of child
+///
+/// @return    Returns slot containing the child, or the empty slot in
+///            which the child would be stored.
+LDAPUtilsTree **
+ldaputils_tree_index_slot(
+         LDAPUtilsTree *               tree,
+         const char *                  rdn )
+{
+   size_t         pos;
+   size_t         mask;
+
+   assert(tree             != NULL);
+   assert(tree->index_size != 0);
+
+   // linear probing always finds an empty slot since the index is at
+   // most half full
+   mask = tree->index_size - 1;
+   for(pos = ldaputils_tree_index_hash(rdn) & mask; ((tree->index[pos])); pos = (pos + 1) & mask)
+      if (!(strcasecmp(tree->index[pos]->rdn, rdn)))
+         break;
+
+   return(&tree->index[pos]);
 }
 
 
@@ -503,20 +727,25 @@ ldaputils_tree_initialize(
          LDAPUtilsEntries *            entries,
          int                           copy )
 {
-   LDAPUtilsTree *   tree;
-   size_t            x;
-   int               err;
+   LDAPUtilsTree *      tree;
+   LDAPUtilsDNCache *   dncache;
+   size_t               x;
+   int                  err;
 
-   // initialize root of tree
-   if ((tree = malloc(sizeof(LDAPUtilsTree))) == NULL)
+   // initialize table of DN suffixes which also holds the nodes
+   if ((dncache = ldaputils_dn_cache_initialize()) == NULL)
       return(NULL);
-   memset(tree, 0, sizeof(LDAPUtilsTree));
 
-   if ((tree->rdn = strdup("")) == NULL)
+   // initialize root of tree
+   if ((tree = ldaputils_arena_alloc(dncache->arena, sizeof(LDAPUtilsTree))) == NULL)
    {
-      ldaputils_tree_free(tree);
+      ldaputils_dn_cache_free(dncache);
       return(NULL);
    };
+   memset(tree, 0, sizeof(LDAPUtilsTree));
+   tree->sorted  = 1;
+   tree->rdn     = "";
+   tree->dncache = dncache;
 
    if (!(entries))
       return(tree);
@@ -535,52 +764,25 @@ ldaputils_tree_initialize(
 }
 
 
+/// counts levels of tree
+/// @param[in] tree    reference to tree
+/// @param[in] opts    display options
+///
+/// @return    Returns the number of levels below the node plus one
 size_t
 ldaputils_tree_level_count(
          LDAPUtilsTree *               tree,
          LDAPUtilsTreeOpts *           opts )
 {
-   size_t          x;
-   LDAPUtilsTree * child;
-   size_t          depth;
+   LDAPUtilsTree *   root;
 
    assert(tree != NULL);
+   assert(opts != NULL);
 
-   depth = 0;
-
-   for(x = 0; x < tree->children_len; x++)
-   {
-      child = tree->children[x];
-      if (!(opts->expandall))
-         while ( (child->children_len == 1) && (!(child->entry)) )
-            child = child->children[0];
-      ldaputils_tree_level_count_recursive(tree->children[x], 1, &depth);
-   };
-
-   return(depth);
-}
-
-
-void
-ldaputils_tree_level_count_recursive(
-         LDAPUtilsTree *               tree,
-         size_t                        level,
-         size_t *                      depthp )
-{
-   size_t x;
-
-   assert(tree   != NULL);
-   assert(depthp != NULL);
-
-   level++;
-
-   if (level > *depthp)
-      *depthp = level;
-
-   for(x = 0; x < tree->children_len; x++)
-      ldaputils_tree_level_count_recursive(tree->children[x], level, depthp);
+   if (!((root = ldaputils_tree_root(tree))->counted))
+      ldaputils_tree_stats(root);
 
-   return;
+   return( (tree->height) ? (tree->height + 1) : 0 );
 }
 
 
@@ -605,11 +807,20 @@ ldaputils_tree_print(
    depth = ldaputils_tree_level_count(tree, opts);
    if ((recur.map = malloc(depth+1)) == NULL)
       return;
+
+   // writes tree after output of caller
+   fflush(stdout);
+   if (ldaputils_output_initialize(&recur.out, STDOUT_FILENO, 0) != LDAP_SUCCESS)
+   {
+      free(recur.map);
+      return;
+   };
    for(x = 0; x < depth; x++)
       recur.map[x] = ' ';
    recur.map[x] = '\0';
 
    // loops through root DNs
+   ldaputils_tree_children_sort(tree);
    for(x = 0; x < tree->children_len; x++)
    {
       strncpy(dn, tree->children[x]->rdn, sizeof(dn)-1);
@@ -628,16 +839,18 @@ ldaputils_tree_print(
          };
       };
       if (opts->style == LDAPUTILS_TREE_BULLETS)
-         printf("* %s\n", dn);
+         ldaputils_output_printf(recur.out, "* %s\n", dn);
       else
-         printf("+--%s\n", dn);
+         ldaputils_output_printf(recur.out, "+--%s\n", dn);
       recur.lastline = LDAPUTILS_TREE_DATA;
       ldaputils_tree_print_entry(child, 0, &recur, 1);
       ldaputils_tree_print_recursive(child, 0, &recur);
 
-      printf("\n");
+      ldaputils_output_puts(recur.out, "\n");
    };
 
+   ldaputils_output_flush(recur.out);
+   ldaputils_output_free(recur.out);
    free(recur.map);
 
    return;
@@ -652,7 +865,6 @@ ldaputils_tree_print_entry(
          size_t                        stop )
 {
    size_t            have_children;
-   size_t            z;
    LDAPUtilsEntry *  entry;
    size_t            attr;
    size_t            val;
@@ -668,18 +880,14 @@ ldaputils_tree_print_entry(
 
    // determines if there are children of this node
    if (recur->opts->noleaf)
-   {
-      have_children = 0;
-      for(z = 0; ((z < tree->children_len)&&((!(have_children)))); z++)
-         have_children = (tree->children[z]->children_len > 0) ? 1 : 0;
-   } else {
+      have_children = (tree->branches) ? 1 : 0;
+   else
       have_children = (tree->children_len) ? 1 : 0;
-   };
 
    if (recur->opts->style == LDAPUTILS_TREE_BULLETS)
    {
       ldaputils_tree_print_indent(tree, level, recur);
-      printf("  * Attributes\n");
+      ldaputils_output_puts(recur->out, "  * Attributes\n");
    };
 
    // loops through attributes
@@ -692,13 +900,13 @@ ldaputils_tree_print_entry(
          // prints attribute and value
          if (recur->opts->style == LDAPUTILS_TREE_BULLETS)
          {
-            printf("  - %s: ", entry->attrs[attr]->name);
-            fwrite(entry->attrs[attr]->vals[val]->bv_val, 1, entry->attrs[attr]->vals[val]->bv_len, stdout);
-            printf("\n");
+            ldaputils_output_printf(recur->out, "  - %s: ", entry->attrs[attr]->name);
+            ldaputils_output_write(recur->out, entry->attrs[attr]->vals[val]->bv_val, entry->attrs[attr]->vals[val]->bv_len);
+            ldaputils_output_puts(recur->out, "\n");
          } else {
-            printf("  %c  %s: ", (have_children) ? '|' : ' ', entry->attrs[attr]->name);
-            fwrite(entry->attrs[attr]->vals[val]->bv_val, 1, entry->attrs[attr]->vals[val]->bv_len, stdout);
-            printf("\n");
+            ldaputils_output_printf(recur->out, "  %c  %s: ", (have_children) ? '|' : ' ', entry->attrs[attr]->name);
+            ldaputils_output_write(recur->out, entry->attrs[attr]->vals[val]->bv_val, entry->attrs[attr]->vals[val]->bv_len);
+            ldaputils_output_puts(recur->out, "\n");
          };
       };
    };
@@ -710,7 +918,7 @@ ldaputils_tree_print_entry(
       if (!(recur->opts->compact))
       {
          ldaputils_tree_print_indent(tree, level, recur);
-         printf("\n");
+         ldaputils_output_puts(recur->out, "\n");
          recur->lastline = LDAPUTILS_TREE_SPACE;
       };
    } else if ((entry->attrs_count > 0) && (!(recur->opts->compact)))
@@ -719,9 +927,9 @@ ldaputils_tree_print_entry(
       {
          ldaputils_tree_print_indent(tree, level+1, recur);
          if ((have_children))
-            printf("  |\n");
+            ldaputils_output_puts(recur->out, "  |\n");
          else
-            printf("\n");
+            ldaputils_output_puts(recur->out, "\n");
       };
       recur->lastline = LDAPUTILS_TREE_SPACE;
    };
@@ -746,13 +954,16 @@ ldaputils_tree_print_indent(
    {
       case LDAPUTILS_TREE_BULLETS:
       for(y = 0; y < level; y++)
-         printf("  ");
+         ldaputils_output_puts(recur->out, "  ");
       break;
 
       default:
-      printf(" ");
+      ldaputils_output_puts(recur->out, " ");
       for(y = 1; y < level; y++)
-         printf("  %c", recur->map[y]);
+      {
+         ldaputils_output_puts(recur->out, "  ");
+         ldaputils_output_putc(recur->out, recur->map[y]);
+      };
       break;
    };
 }
@@ -764,12 +975,15 @@ ldaputils_tree_print_recursive(
          size_t                        level,
          LDAPUtilsTreeRecursion *      recur )
 {
-   size_t x;
-   size_t y;
-   size_t stop;
-   size_t noleaf;
-   size_t leaf_count;
-   size_t children_count;
+   size_t            x;
+   size_t            stop;
+   size_t            noleaf;
+   size_t            leaf_count;
+   size_t            branch_count;
+   size_t            children_count;
+   size_t            shown;
+   size_t            hidden;
+   LDAPUtilsTree *   child;
 
    assert(tree != NULL);
 
@@ -779,59 +993,88 @@ ldaputils_tree_print_recursive(
       return;
 
    // loops through children
+   ldaputils_tree_children_sort(tree);
    noleaf         = recur->opts->noleaf;
    stop           = 0;
    children_count = 0;
    leaf_count     = 0;
+   branch_count   = 0;
+   shown          = 0;
+   hidden         = 0;
    for(x = 0; ((x < tree->children_len) && (!(stop))); x++)
    {
-      if (tree->children[x]->children_len == 0)
+      child = tree->children[x];
+      if (child->children_len == 0)
       {
          if ((noleaf))
             continue;
          leaf_count++;
          if ( ((leaf_count+1) > recur->opts->maxleafs) && ((recur->opts->maxleafs)) )
             noleaf = 1;
+      } else {
+         branch_count++;
       };
       children_count++;
+      shown += child->descendants + 1;
 
       // prints indent string
       ldaputils_tree_print_indent(tree, level, recur);
 
       // checks for last non-leaf node
       if ((noleaf))
-      {
-         stop = 1;
-         for(y = (x+1); y < tree->children_len; y++)
-            if (tree->children[y]->children_len != 0)
-            {
-               y = tree->children_len;
-               stop = 0;
-            };
-      };
+         stop = (branch_count < tree->branches) ? 0 : 1;
 
       // checks for max children
       if ( ((recur->opts->maxchildren)) && (children_count >= recur->opts->maxchildren))
          stop = 1;
 
+      // counts entries which are not displayed, except for leafs hidden by
+      // request
+      if ((stop))
+      {
+         hidden = tree->descendants - shown;
+         if ((recur->opts->noleaf))
+            hidden -= tree->children_len - tree->branches;
+      };
+
       // print RDN and update indent map
       if (recur->opts->style == LDAPUTILS_TREE_BULLETS)
       {
-         printf("* %s\n", tree->children[x]->rdn);
-      } else if ( ((x+1) < tree->children_len) && (!(stop)) ) {
+         ldaputils_output_puts(recur->out, "* ");
+         ldaputils_output_puts(recur->out, child->rdn);
+         ldaputils_output_putc(recur->out, '\n');
+      } else if ( ( ((x+1) < tree->children_len) && (!(stop)) ) || ((hidden)) ) {
          recur->map[level] = '|';
-         printf("  +--%s\n", tree->children[x]->rdn);
+         ldaputils_output_puts(recur->out, "  +--");
+         ldaputils_output_puts(recur->out, child->rdn);
+         ldaputils_output_putc(recur->out, '\n');
       } else {
          recur->map[level] = ' ';
-         printf("  \\--%s\n", tree->children[x]->rdn);
+         ldaputils_output_puts(recur->out, "  \\--");
+         ldaputils_output_puts(recur->out, child->rdn);
+         ldaputils_output_putc(recur->out, '\n');
       };
       recur->lastline = LDAPUTILS_TREE_DATA;
 
       // prints requested attributes
-      ldaputils_tree_print_entry(tree->children[x], level, recur, stop);
+      ldaputils_tree_print_entry(child, level, recur, ((stop) && (!(hidden))));
 
       // recurses to next child
-      ldaputils_tree_print_recursive(tree->children[x], level, recur);
+      ldaputils_tree_print_recursive(child, level, recur);
+   };
+
+   // prints number of entries which are not displayed
+   if ((hidden))
+   {
+      ldaputils_tree_print_indent(tree, level, recur);
+      if (recur->opts->style == LDAPUTILS_TREE_BULLETS)
+      {
+         ldaputils_output_printf(recur->out, "* (+%zu more)\n", hidden);
+      } else {
+         recur->map[level] = ' ';
+         ldaputils_output_printf(recur->out, "  \\--(+%zu more)\n", hidden);
+      };
+      recur->lastline = LDAPUTILS_TREE_DATA;
    };
 
    if ((recur->opts->compact))
@@ -845,10 +1088,115 @@ ldaputils_tree_print_recursive(
       return;
    recur->lastline = LDAPUTILS_TREE_SPACE;
    ldaputils_tree_print_indent(tree, level, recur);
-   printf("\n");
+   ldaputils_output_puts(recur->out, "\n");
 
    return;
 }
 
 
+// finds root of tree
+LDAPUtilsTree *
+ldaputils_tree_root(
+         LDAPUtilsTree *               tree )
+{
+   assert(tree != NULL);
+   while ((tree->parent))
+      tree = tree->parent;
+   return(tree);
+}
+
+/// performs LDAP search and adds entries to tree as they are received
+/// @param[in] lud     reference to LDAP utilities struct
+/// @param[in] tree    reference to tree
+/// @param[in] copy    copy attributes of entries into tree
+///
+/// Each entry is freed once it is added to the tree, so that only the tree
+/// is retained.  Paged results are requested one page at a time.  If a
+/// window was requested with `--offset' and `--count', the entries within
+/// the window are retrieved with ldaputils_search_sorted().
+///
+/// @return    Returns the error code from the OpenLDAP library
+/// @see       ldaputils_search_stream, ldaputils_search_sorted
+int
+ldaputils_tree_search(
+         LDAPUtils *                   lud,
+         LDAPUtilsTree *               tree,
+         int                           copy )
+{
+   LDAPUtilsTreeSearch     search;
+
+   assert(lud  != NULL);
+   assert(tree != NULL);
+
+   memset(&search, 0, sizeof(search));
+   search.tree = tree;
+   search.copy = copy;
+
+   if (lud->vlvcount > 0)
+      return(ldaputils_search_sorted(lud, &ldaputils_tree_search_entry, &search));
+
+   return(ldaputils_search_stream(lud, &ldaputils_tree_search_entry, &search));
+}
+
+
+// adds search entry to tree
+int
+ldaputils_tree_search_entry(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 msg,
+         void *                        context )
+{
+   LDAPUtilsTreeSearch *   search;
+
+   assert(lud     != NULL);
+   assert(msg     != NULL);
+   assert(context != NULL);
+
+   search = context;
+
+   return(ldaputils_tree_add_message(search->tree, lud->ld, msg, search->copy));
+}
+
+
+/// computes statistics of each node in a single post-order pass
+/// @param[in] tree    reference to node
+///
+/// The statistics of the whole tree are recomputed when the tree is
+/// printed or its levels are counted after nodes were added.
+void
+ldaputils_tree_stats(
+         LDAPUtilsTree *               tree )
+{
+   size_t            x;
+   LDAPUtilsTree *   child;
+
+   assert(tree != NULL);
+
+   tree->descendants = 0;
+   tree->leafs       = 0;
+   tree->branches    = 0;
+   tree->height      = 0;
+
+   for(x = 0; x < tree->children_len; x++)
+   {
+      child = tree->children[x];
+      ldaputils_tree_stats(child);
+      tree->descendants += child->descendants + 1;
+      if (child->children_len == 0)
+      {
+         tree->leafs++;
+      } else {
+         tree->leafs += child->leafs;
+         tree->branches++;
+      };
+      if (tree->height < (child->height + 1))
+         tree->height = child->height + 1;
+   };
+
+   if (!(tree->parent))
+      tree->counted = 1;
+
+   return;
+}
+
 /* end of source file */
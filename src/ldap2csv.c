@@ -65,6 +65,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
 #include <unistd.h>
 #include <string.h>
 #include <strings.h>
@@ -93,6 +95,13 @@
 
 #define MY_SHORT_OPTIONS LDAPUTILS_OPTIONS_COMMON LDAPUTILS_OPTIONS_SEARCH "o:"
 
+#define MY_COLUMN_ATTR     0
+#define MY_COLUMN_DN       1
+#define MY_COLUMN_RDN      2
+#define MY_COLUMN_UFN      3
+#define MY_COLUMN_DCE      4
+#define MY_COLUMN_ADC      5
+
 
 /////////////////
 //             //
@@ -103,15 +112,60 @@
 
 /* configuration union */
 typedef struct my_config MyConfig;
+typedef struct my_column MyColumn;
+typedef struct my_alias MyAlias;
+typedef struct my_worker MyWorker;
+
+
+// name of attribute printed in column
+struct my_alias
+{
+   const char *       name;
+   size_t             len;
+   size_t             column;
+};
+
+
+// compiled column of output
+struct my_column
+{
+   int                type;     // MY_COLUMN_ATTR, MY_COLUMN_DN, etc
+   int                pad0;
+   char **            names;    // names of attribute type from schema
+};
+
+
+// state of thread formatting entries
+struct my_worker
+{
+   MyConfig *         cnf;
+   LDAPUtilsDNCache * dncache;
+   size_t             held_len;
+   BerVarray *        vals;     // values of each column of current entry
+   BerVarray *        held;     // values assigned to columns of entry
+};
+
+
 struct my_config
 {
-   LDAPUtils *    lud;
-   LDAPSchema *   lsd;
-   const char *   filter;
-   const char *   prog_name;
-   const char **  defvals;
-   const char **  titles;
-   char           output[LDAPUTILS_OPT_LEN];
+   LDAPUtils *        lud;
+   size_t             parallel;
+   int                ordered;
+   int                separator;
+   LDAPSchema *       lsd;
+   LDAPUtilsOutput *  out;
+   size_t             threads;
+   size_t             columns_len;
+   size_t             aliases_size;  // power of two, at most half full
+   MyColumn *         columns;
+   MyAlias *          aliases;       // open addressing hash of column names
+   void **            workers;       // MyWorker of each formatting thread
+   char *             sortrule;
+   const char *       filter;
+   const char *       prog_name;
+   const char **      defvals;
+   const char **      titles;
+   char               output[LDAPUTILS_OPT_LEN];
 };
 
 
@@ -137,10 +191,53 @@ my_config(
          MyConfig **                   cnfp );
 
 
-static int
-my_results(
+// adds name of attribute printed in column
+static void
+my_alias(
          MyConfig *                    cnf,
-         LDAPMessage *                 res );
+         const char *                  name,
+         size_t                        column );
+
+
+// case insensitive FNV-1a hash of attribute description
+static size_t
+my_alias_hash(
+         const char *                  name,
+         size_t                        len );
+
+
+// compiles columns and names of attributes printed in columns
+static int
+my_columns(
+         MyConfig *                    cnf );
+
+
+// formats entry
+static int
+my_format(
+         LDAP *                        ld,
+         LDAPMessage *                 msg,
+         LDAPUtilsOutput *             out,
+         void *                        context );
+
+
+// prints entry
+static int
+my_result(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 msg,
+         void *                        context );
+
+
+static int
+my_search(
+         MyConfig *                    cnf );
+
+
+// determines ordering matching rule of sort attribute
+static void
+my_sortrule(
+         MyConfig *                    cnf );
 
 
 // fress resources
@@ -149,6 +246,12 @@ my_unbind(
          MyConfig *                    cnf );
 
 
+// allocates state of threads formatting entries
+static int
+my_workers(
+         MyConfig *                    cnf );
+
+
 /////////////////
 //             //
 //  Functions  //
@@ -164,6 +267,17 @@ ldaputils_usage(
    printf("Usage: %s [options] [filter] attributes[:values[:title]]...\n", PROGRAM_NAME);
    ldaputils_usage_search(MY_SHORT_OPTIONS);
    ldaputils_usage_common(MY_SHORT_OPTIONS);
+   printf("Window Options:\n");
+   printf("  --offset=num              position of first entry within sorted results (default: 1)\n");
+   printf("  --count=num               number of entries to retrieve from sorted results\n");
+   printf("Parallel Options:\n");
+   printf("  --parallel=num            search subtrees of base DN using `num' connections\n");
+   printf("  --ordered                 print subtrees in order when searching in parallel\n");
+   printf("  --sort-threads=num        sort results in memory using `num' threads\n");
+   printf("  --max-memory=MiB          sort results larger than `MiB' using temporary files\n");
+   printf("  --format-threads=num      format entries using `num' threads\n");
+   printf("Output Options:\n");
+   printf("  --separator=char          separator of multiple values (default: |)\n");
    printf("Special Attributes:\n");
    printf("  dn                        entry's DN\n");
    printf("  rdn                       entry's relative DN\n");
@@ -186,7 +300,6 @@ main(
    int                  x;
    int                  err;
    MyConfig *           cnf;
-   LDAPMessage *        res;
 
    cnf = NULL;
 
@@ -211,35 +324,165 @@ main(
       my_unbind(cnf);
       return(1);
    };
+   my_sortrule(cnf);
 
-   // performs LDAP search
-   if ((err = ldaputils_search(cnf->lud, &res)) != LDAP_SUCCESS)
+   // maps attribute names to columns
+   if ((err = my_columns(cnf)) != LDAP_SUCCESS)
+   {
+      fprintf(stderr, "%s: %s\n", ldaputils_get_prog_name(cnf->lud), ldap_err2string(err));
+      my_unbind(cnf);
+      return(1);
+   };
+   if ((err = my_workers(cnf)) != LDAP_SUCCESS)
    {
-      fprintf(stderr, "%s: ldaputils_search(): %s\n", ldaputils_get_prog_name(cnf->lud), ldap_err2string(err));
+      fprintf(stderr, "%s: %s\n", ldaputils_get_prog_name(cnf->lud), ldap_err2string(err));
       my_unbind(cnf);
       return(1);
    };
 
    // prints attribute names
-   printf("\"%s\"", cnf->titles[0]);
-   for(x = 1; ((cnf->titles[x])); x++)
-      printf(",\"%s\"", cnf->titles[x]);
-   printf("\n");
+   for(x = 0; ((cnf->titles[x])); x++)
+   {
+      ldaputils_output_write(cnf->out, ((x > 0) ? ",\"" : "\""), ((x > 0) ? 2 : 1));
+      ldaputils_output_csv(cnf->out, cnf->titles[x], strlen(cnf->titles[x]), 0);
+      ldaputils_output_putc(cnf->out, '"');
+   };
+   ldaputils_output_putc(cnf->out, '\n');
 
-   // prints values
-   if ((err = my_results(cnf, res)) != LDAP_SUCCESS)
+   // performs LDAP search and prints values
+   if ((err = my_search(cnf)) != LDAP_SUCCESS)
    {
+      if (err != LDAP_NO_MEMORY)
+         fprintf(stderr, "%s: ldaputils_search(): %s\n", ldaputils_get_prog_name(cnf->lud), ldap_err2string(err));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // writes remaining output
+   if ((err = ldaputils_output_flush(cnf->out)) != LDAP_SUCCESS)
+   {
+      fprintf(stderr, "%s: write(): %s\n", ldaputils_get_prog_name(cnf->lud), ldap_err2string(err));
       my_unbind(cnf);
       return(1);
    };
 
-   ldap_msgfree(res);
    my_unbind(cnf);
 
    return(0);
 }
 
 
+// adds name of attribute printed in column
+void
+my_alias(
+         MyConfig *                    cnf,
+         const char *                  name,
+         size_t                        column )
+{
+   size_t      len;
+   size_t      mask;
+   size_t      pos;
+
+   assert(cnf  != NULL);
+   assert(name != NULL);
+
+   len  = strlen(name);
+   mask = cnf->aliases_size - 1;
+
+   for(pos = my_alias_hash(name, len) & mask; ((cnf->aliases[pos].name)); pos = (pos + 1) & mask)
+      if ( (cnf->aliases[pos].column == column) && (cnf->aliases[pos].len == len) && (!(strncasecmp(cnf->aliases[pos].name, name, len))) )
+         return;
+
+   cnf->aliases[pos].name   = name;
+   cnf->aliases[pos].len    = len;
+   cnf->aliases[pos].column = column;
+
+   return;
+}
+
+
+// case insensitive FNV-1a hash of attribute description
+size_t
+my_alias_hash(
+         const char *                  name,
+         size_t                        len )
+{
+   size_t         hash;
+   size_t         u;
+   unsigned char  c;
+
+   assert(name != NULL);
+
+   hash = (size_t)2166136261U;
+   for(u = 0; (u < len); u++)
+   {
+      c     = (unsigned char)name[u];
+      hash ^= (size_t)( ((c >= 'A') && (c <= 'Z')) ? (c | 0x20) : c );
+      hash *= (size_t)16777619U;
+   };
+
+   return(hash);
+}
+
+
+// compiles columns and names of attributes printed in columns
+int
+my_columns(
+         MyConfig *                    cnf )
+{
+   size_t                     x;
+   size_t                     y;
+   size_t                     count;
+   const char *               name;
+   LDAPSchemaAttributeType *  attr;
+
+   assert(cnf != NULL);
+
+   for(cnf->columns_len = 0; ((cnf->lud->attrs[cnf->columns_len])); cnf->columns_len++);
+   if ((cnf->columns = malloc(sizeof(MyColumn) * cnf->columns_len)) == NULL)
+      return(LDAP_NO_MEMORY);
+   memset(cnf->columns, 0, (sizeof(MyColumn) * cnf->columns_len));
+
+   // determines type of column and names of attribute types from schema
+   count = 0;
+   for(x = 0; (x < cnf->columns_len); x++)
+   {
+      name = cnf->lud->attrs[x];
+      if      (!(strcasecmp("dn",  name)))  cnf->columns[x].type = MY_COLUMN_DN;
+      else if (!(strcasecmp("rdn", name)))  cnf->columns[x].type = MY_COLUMN_RDN;
+      else if (!(strcasecmp("ufn", name)))  cnf->columns[x].type = MY_COLUMN_UFN;
+      else if (!(strcasecmp("dce", name)))  cnf->columns[x].type = MY_COLUMN_DCE;
+      else if (!(strcasecmp("adc", name)))  cnf->columns[x].type = MY_COLUMN_ADC;
+      else                                  cnf->columns[x].type = MY_COLUMN_ATTR;
+      if (cnf->columns[x].type != MY_COLUMN_ATTR)
+         continue;
+      if ((attr = ldapschema_find_attributetype(cnf->lsd, name)) != NULL)
+         if (ldapschema_get_info_attributetype(cnf->lsd, attr, LDAPSCHEMA_FLD_NAME, &cnf->columns[x].names) != 0)
+            return(LDAP_NO_MEMORY);
+      for(y = 0; ( ((cnf->columns[x].names)) && ((cnf->columns[x].names[y])) ); y++);
+      count += y + 1;
+   };
+
+   // allocates hash of names
+   for(cnf->aliases_size = 16; (cnf->aliases_size < (count * 2)); cnf->aliases_size *= 2);
+   if ((cnf->aliases = malloc(sizeof(MyAlias) * cnf->aliases_size)) == NULL)
+      return(LDAP_NO_MEMORY);
+   memset(cnf->aliases, 0, (sizeof(MyAlias) * cnf->aliases_size));
+
+   // maps requested name and names from schema to column
+   for(x = 0; (x < cnf->columns_len); x++)
+   {
+      if (cnf->columns[x].type != MY_COLUMN_ATTR)
+         continue;
+      my_alias(cnf, cnf->lud->attrs[x], x);
+      for(y = 0; ( ((cnf->columns[x].names)) && ((cnf->columns[x].names[y])) ); y++)
+         my_alias(cnf, cnf->columns[x].names[y], x);
+   };
+
+   return(LDAP_SUCCESS);
+}
+
+
 /// parses configuration
 /// @param[in] argc   number of arguments
 /// @param[in] argv   array of arguments
@@ -250,21 +493,31 @@ my_config(
          char *                        argv[],
          MyConfig **                   cnfp )
 {
-   int         c;
-   int         err;
-   int         option_index;
-   char *      str;
-   MyConfig *  cnf;
-   size_t      len;
-   size_t      size;
+   int            c;
+   int            err;
+   int            option_index;
+   char *         str;
+   const char *   msg;
+   MyConfig *     cnf;
+   size_t         len;
+   size_t         num;
+   size_t         size;
 
    static char   short_options[] = MY_SHORT_OPTIONS;
    static struct option long_options[] =
    {
-      {"help",          no_argument, 0, 'h'},
-      {"verbose",       no_argument, 0, 'v'},
-      {"version",       no_argument, 0, 'V'},
-      {NULL,            0,           0, 0  }
+      {"parallel",      required_argument, 0, '1'},
+      {"ordered",       no_argument,       0, '2'},
+      {"offset",        required_argument, 0, '3'},
+      {"count",         required_argument, 0, '4'},
+      {"sort-threads",  required_argument, 0, '5'},
+      {"max-memory",    required_argument, 0, '6'},
+      {"separator",     required_argument, 0, '7'},
+      {"format-threads",required_argument, 0, '8'},
+      {"help",          no_argument,       0, 'h'},
+      {"verbose",       no_argument,       0, 'v'},
+      {"version",       no_argument,       0, 'V'},
+      {NULL,            0,                 0, 0  }
    };
 
    // allocates memory for configuration
@@ -274,6 +527,8 @@ my_config(
       return(1);
    };
    memset(cnf, 0, sizeof(MyConfig));
+   cnf->separator = '|';
+   cnf->threads   = 1;
 
    // initialize ldap utilities
    if ((err = ldaputils_initialize(&cnf->lud, PROGRAM_NAME)) != LDAP_SUCCESS)
@@ -291,6 +546,14 @@ my_config(
       return(1);
    };
 
+   // initialize buffered output
+   if ((err = ldaputils_output_initialize(&cnf->out, STDOUT_FILENO, 0)) != LDAP_SUCCESS)
+   {
+      fprintf(stderr, "%s: ldaputils_output_initialize(): %s\n", PROGRAM_NAME, ldap_err2string(err));
+      my_unbind(cnf);
+      return(1);
+   };
+
    // loops through args
    option_index = 0;
    while((c = getopt_long(argc, argv, short_options, long_options, &option_index)) != -1)
@@ -315,6 +578,73 @@ my_config(
          my_unbind(cnf);
          return(1);
 
+         case '1':
+         if (ldaputils_getopt_size(cnf->lud, "parallel", optarg, 0, LDAPUTILS_CONNS_MAX, &cnf->parallel) != 0)
+         {
+            my_unbind(cnf);
+            return(1);
+         };
+         break;
+
+         case '2':
+         cnf->ordered = 1;
+         break;
+
+         case '3':
+         if (ldaputils_getopt_size(cnf->lud, "offset", optarg, 0, INT_MAX, &num) != 0)
+         {
+            my_unbind(cnf);
+            return(1);
+         };
+         cnf->lud->vlvoffset = (int)num;
+         break;
+
+         case '4':
+         if (ldaputils_getopt_size(cnf->lud, "count", optarg, 1, INT_MAX, &num) != 0)
+         {
+            my_unbind(cnf);
+            return(1);
+         };
+         cnf->lud->vlvcount = (int)num;
+         break;
+
+         case '5':
+         if (ldaputils_getopt_size(cnf->lud, "sort-threads", optarg, 0, LDAPUTILS_THREADS_MAX, &num) != 0)
+         {
+            my_unbind(cnf);
+            return(1);
+         };
+         cnf->lud->sortthreads = (int)num;
+         break;
+
+         case '6':
+         if (ldaputils_getopt_size(cnf->lud, "max-memory", optarg, 0, (SIZE_MAX >> 20), &num) != 0)
+         {
+            my_unbind(cnf);
+            return(1);
+         };
+         cnf->lud->maxmemory = num << 20;
+         break;
+
+         case '7':
+         if ( (strlen(optarg) != 1) || (optarg[0] == '"') || (optarg[0] == '\\') )
+         {
+            fprintf(stderr, "%s: invalid separator `%s'\n", PROGRAM_NAME, optarg);
+            fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+            my_unbind(cnf);
+            return(1);
+         };
+         cnf->separator = optarg[0];
+         break;
+
+         case '8':
+         if (ldaputils_getopt_size(cnf->lud, "format-threads", optarg, 1, LDAPUTILS_THREADS_MAX, &cnf->threads) != 0)
+         {
+            my_unbind(cnf);
+            return(1);
+         };
+         break;
+
          // argument error
          case '?':
          fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
@@ -332,6 +662,25 @@ my_config(
 
    cnf->prog_name = ldaputils_get_prog_name(cnf->lud);
 
+   // checks virtual list view arguments
+   if ( ((cnf->lud->vlvoffset)) || ((cnf->lud->vlvcount)) )
+   {
+      msg = NULL;
+      if (cnf->lud->vlvcount < 1)
+         msg = "--count must be greater than zero";
+      else if (!(cnf->lud->sortattr))
+         msg = "--offset and --count require a sort attribute (-S)";
+      else if (cnf->lud->pagesize > 0)
+         msg = "--offset and --count cannot be used with -E pr=size";
+      if ((msg))
+      {
+         fprintf(stderr, "%s: %s\n", PROGRAM_NAME, msg);
+         fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+         my_unbind(cnf);
+         return(1);
+      };
+   };
+
    // saves filter
    if (argc > optind)
    {
@@ -409,196 +758,229 @@ my_config(
 }
 
 
-// prints results
+// formats entry
 int
-my_results(
-         MyConfig *                    cnf,
-         LDAPMessage *                 res )
+my_format(
+         LDAP *                        ld,
+         LDAPMessage *                 msg,
+         LDAPUtilsOutput *             out,
+         void *                        context )
 {
-   int                        x;
-   int                        y;
-   void *                     ptr;
-   char *                     buff;
-   size_t                     bufflen;
-   char *                     dn;
-   char **                    dns;
-   char *                     dnstr;
-   char *                     delim;
-   LDAPMessage *              msg;
-   struct berval **           vals;
-   LDAP *                     ld;
-   LDAPSchemaAttributeType *  attr;
-   char **                    names;
-
-   assert(cnf != NULL);
-   assert(res != NULL);
-
-   ld = ldaputils_get_ld(cnf->lud);
-
-   // initialize buffer
-   bufflen = 32;
-   if ((buff = malloc(bufflen)) == NULL)
+   int                        rc;
+   int                        used;
+   size_t                     x;
+   size_t                     y;
+   size_t                     pos;
+   size_t                     mask;
+   const char *               dnstr;
+   LDAPUtilsDN *              pdn;
+   struct berval              dn;
+   struct berval              bv;
+   BerVarray                  vals;
+   BerElement *               ber;
+   MyColumn *                 column;
+   MyAlias *                  alias;
+   MyWorker *                 worker;
+   MyConfig *                 cnf;
+
+   assert(ld      != NULL);
+   assert(msg     != NULL);
+   assert(out     != NULL);
+   assert(context != NULL);
+
+   worker = context;
+   cnf    = worker->cnf;
+   pdn    = NULL;
+   mask   = cnf->aliases_size - 1;
+
+   // retrieve DN
+   ber = NULL;
+   if (ldap_get_dn_ber(ld, msg, &ber, &dn) != LDAP_SUCCESS)
    {
-      fprintf(stderr, "%s: malloc(): out of virtual memory\n", cnf->prog_name);
+      if ((ber))
+         ber_free(ber, 0);
+      fprintf(stderr, "%s: ldap_get_dn_ber(): out of virtual memory\n", cnf->prog_name);
       return(LDAP_NO_MEMORY);
    };
 
-   // sorts entries
-#ifdef USE_LDAP_DEPRECATED
-   if ((cnf->lud->sortattr))
-      ldap_sort_entries(ld, &res, cnf->lud->sortattr, strcasecmp);
-#endif
-
-   // loops through entries
-   msg = ldap_first_entry(ld, res);
-   while ((msg))
+   // walks attributes of entry once, assigning values to columns
+   vals             = NULL;
+   worker->held_len = 0;
+   for(rc = ldap_get_attribute_ber(ld, msg, ber, &bv, &vals); ((rc == LDAP_SUCCESS) && ((bv.bv_val))); rc = ldap_get_attribute_ber(ld, msg, ber, &bv, &vals))
    {
-      printf("\"");
-
-      // retrieve DN and make CSV safe
-      if ((dn = ldap_get_dn(ld, msg)) == NULL)
-      {
-         fprintf(stderr, "%s: malloc(): out of virtual memory\n", cnf->prog_name);
-         free(buff);
-         return(LDAP_NO_MEMORY);
-      };
-      delim = dn;
-      while((delim = strchr(delim, '"')) != NULL)
-         delim[0] = '\'';
-
-      // loop through attributes
-      for(x = 0; (cnf->lud->attrs[x] != NULL); x++)
+      used = 0;
+      if ( ((vals)) && ((vals[0].bv_val)) )
       {
-         // print delimiter
-         if (x > 0)
-            printf("\",\"");
-
-         // prints dn if specified
-         if (strcasecmp("dn", cnf->lud->attrs[x]) == 0)
+         for(pos = my_alias_hash(bv.bv_val, bv.bv_len) & mask; ((cnf->aliases[pos].name)); pos = (pos + 1) & mask)
          {
-            printf("%s", dn);
-            continue;
+            alias = &cnf->aliases[pos];
+            if ( (alias->len != bv.bv_len) || ((strncasecmp(alias->name, bv.bv_val, bv.bv_len))) )
+               continue;
+            if ((worker->vals[alias->column]))
+               continue;
+            worker->vals[alias->column] = vals;
+            used = 1;
          };
+      };
+      if ((used))
+         worker->held[worker->held_len++] = vals;
+      else if ((vals))
+         ber_memfree(vals);
+      vals = NULL;
+   };
+   ber_free(ber, 0);
+   if (rc != LDAP_SUCCESS)
+      fprintf(stderr, "%s: ldap_get_attribute_ber(): %s\n", cnf->prog_name, ldap_err2string(rc));
+   else
+      ldaputils_output_putc(out, '"');
+
+   // loop through columns
+   for(x = 0; ((rc == LDAP_SUCCESS) && (x < cnf->columns_len)); x++)
+   {
+      column = &cnf->columns[x];
 
-         // print RDN
-         if (strcasecmp("rdn", cnf->lud->attrs[x]) == 0)
-         {
-            if ((dns = ldap_explode_dn(dn, 0)) == NULL)
-            {
-               fprintf(stderr, "%s: ldap_explode_dn(): out of virtual memory\n", cnf->prog_name);
-               free(buff);
-               return(LDAP_NO_MEMORY);
-            };
-            printf("%s", dns[0]);
-            ldaputils_value_free(dns);
-            continue;
-         };
+      // print delimiter
+      if (x > 0)
+         ldaputils_output_write(out, "\",\"", 3);
 
-         // print DN in UFN format
-         if (strcasecmp("ufn", cnf->lud->attrs[x]) == 0)
-         {
-            if ((dnstr = ldap_dn2ufn(dn)) == NULL)
-            {
-               fprintf(stderr, "%s: ldap_dn2ufn(): out of virtual memory\n", cnf->prog_name);
-               free(buff);
-               return(LDAP_NO_MEMORY);
-            };
-            printf("%s", dnstr);
-            ldap_memfree(dnstr);
-            continue;
-         };
+      switch(column->type)
+      {
+         // prints dn
+         case MY_COLUMN_DN:
+         ldaputils_output_csv(out, dn.bv_val, dn.bv_len, 0);
+         break;
 
-         // print DN in DCE format
-         if (strcasecmp("dce", cnf->lud->attrs[x]) == 0)
+         // print RDN or DN in UFN, DCE, or AD canonical format
+         case MY_COLUMN_RDN:
+         case MY_COLUMN_UFN:
+         case MY_COLUMN_DCE:
+         case MY_COLUMN_ADC:
+         // parses DN once for all formats of entry
+         if ( (!(pdn)) && ((pdn = ldaputils_dn_parse_bv(worker->dncache, &dn)) == NULL) )
          {
-            if ((dnstr = ldap_dn2dcedn(dn)) == NULL)
-            {
-               fprintf(stderr, "%s: ldap_dn2dcedn(): out of virtual memory\n", cnf->prog_name);
-               free(buff);
-               return(LDAP_NO_MEMORY);
-            };
-            printf("%s", dnstr);
-            ldap_memfree(dnstr);
-            continue;
+            fprintf(stderr, "%s: ldaputils_dn_parse(): out of virtual memory\n", cnf->prog_name);
+            rc = LDAP_NO_MEMORY;
+            break;
          };
-
-         // print DN in AD canonical format
-         if (strcasecmp("adc", cnf->lud->attrs[x]) == 0)
+         if (column->type == MY_COLUMN_RDN)
+            dnstr = ldaputils_dn_get_rdn(pdn);
+         else if (column->type == MY_COLUMN_UFN)
+            dnstr = ldaputils_dn_get_ufn(pdn);
+         else if (column->type == MY_COLUMN_DCE)
+            dnstr = ldaputils_dn_get_dce(pdn);
+         else
+            dnstr = ldaputils_dn_get_adc(pdn);
+         if (!(dnstr))
          {
-            if ((dnstr = ldap_dn2ad_canonical(dn)) == NULL)
-            {
-               fprintf(stderr, "%s: ldap_dn2ad_canonical(): out of virtual memory\n", cnf->prog_name);
-               free(buff);
-               return(LDAP_NO_MEMORY);
-            };
-            printf("%s", dnstr);
-            ldap_memfree(dnstr);
-            continue;
+            fprintf(stderr, "%s: ldap_dn2str(): out of virtual memory\n", cnf->prog_name);
+            rc = LDAP_NO_MEMORY;
+            break;
          };
+         ldaputils_output_csv(out, dnstr, strlen(dnstr), 0);
+         break;
 
-         // retrieves values
-         names = NULL;
-         vals  = NULL;
-         if ((attr = ldapschema_find_attributetype(cnf->lsd, cnf->lud->attrs[x])) != NULL)
-            ldapschema_get_info_attributetype(cnf->lsd, attr, LDAPSCHEMA_FLD_NAME, &names);
-         for(y = 0; (((names)) && ((names[y])) && (!(vals))); y++)
-            vals = ldap_get_values_len(ld, msg, names[y]);
-         if (!(vals))
-            vals = ldap_get_values_len(ld, msg, cnf->lud->attrs[x]);
-         if (!(vals))
+         // prints values, escaping separators in every value so that single
+         // and joined values are read back the same way
+         default:
+         if ((vals = worker->vals[x]) == NULL)
          {
-            printf("%s", cnf->defvals[x]);
-            continue;
+            ldaputils_output_csv(out, cnf->defvals[x], strlen(cnf->defvals[x]), 0);
+            break;
          };
-
-         // processes values
-         for(y = 0; (y < ldap_count_values_len(vals)); y++)
+         for(y = 0; ((vals[y].bv_val)); y++)
          {
-            // adjusts size of buffer
-            if (bufflen < (vals[y]->bv_len + 1))
-            {
-               bufflen = vals[y]->bv_len + 1;
-               if ((ptr = realloc(buff, bufflen)) == NULL)
-               {
-                  fprintf(stderr, "%s: realloc(): out of virtual memory\n", cnf->prog_name);
-                  free(buff);
-                  return(LDAP_NO_MEMORY);
-               };
-               buff = ptr;
-            };
-
-            // copies value into buffer
-            memcpy(buff, vals[y]->bv_val, vals[y]->bv_len);
-            buff[vals[y]->bv_len] = '\0';
-
-            // replace double quotation character with single quotation character
-            delim = buff;
-            while((delim = strchr(delim, '"')) != NULL)
-               delim[0] = '\'';
-            delim = buff;
-            while((delim = strchr(delim, '|')) != NULL)
-               delim[0] = ':';
-
-            // print value
             if (y > 0)
-               printf("|%s", buff);
-            else
-               printf("%s", buff);
+               ldaputils_output_putc(out, cnf->separator);
+            ldaputils_output_csv(out, vals[y].bv_val, vals[y].bv_len, cnf->separator);
          };
-         ldap_value_free_len(vals);
+         break;
       };
-      printf("\"\n");
+   };
 
-      // frees DN
-      ldap_memfree(dn);
+   // frees values and DN
+   for(x = 0; (x < worker->held_len); x++)
+      ber_memfree(worker->held[x]);
+   for(x = 0; (x < cnf->columns_len); x++)
+      worker->vals[x] = NULL;
+   ldaputils_dn_free(pdn);
 
-      // retrieves next entry
-      msg = ldap_next_entry(ld, msg);
-   };
+   if (rc != LDAP_SUCCESS)
+      return(rc);
 
-   free(buff);
+   return(ldaputils_output_write(out, "\"\n", 2));
+}
 
-   return(LDAP_SUCCESS);
+
+// prints entry
+int
+my_result(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 msg,
+         void *                        context )
+{
+   MyConfig *        cnf;
+
+   assert(context != NULL);
+
+   cnf = context;
+
+   return(my_format(ldaputils_get_ld(lud), msg, cnf->out, cnf->workers[0]));
+}
+
+
+// performs search and prints results
+int
+my_search(
+         MyConfig *                    cnf )
+{
+   int                  err;
+   int                  rc;
+   LDAPUtilsPipeline *  pipe;
+
+   assert(cnf != NULL);
+
+   // sorted results are requested from the server when supported
+   if ((cnf->lud->sortattr))
+      return(ldaputils_search_sorted(cnf->lud, &my_result, cnf));
+
+   if (cnf->threads < 2)
+      return(ldaputils_search_parallel(cnf->lud, cnf->parallel, cnf->ordered, &my_result, cnf));
+
+   // formats entries in other threads while results are received
+   if ((err = ldaputils_pipeline_initialize(&pipe, cnf->out, NULL, cnf->threads, &my_format, cnf->workers)) != LDAP_SUCCESS)
+      return(err);
+   err = ldaputils_search_parallel(cnf->lud, cnf->parallel, cnf->ordered, &ldaputils_pipeline_entry, pipe);
+   rc  = ldaputils_pipeline_finish(pipe, NULL);
+
+   return((err != LDAP_SUCCESS) ? err : rc);
+}
+
+
+// determines ordering matching rule of sort attribute
+void
+my_sortrule(
+         MyConfig *                    cnf )
+{
+   LDAPSchemaAttributeType *  attr;
+   LDAPSchemaMatchingRule *   rule;
+
+   assert(cnf != NULL);
+
+   if (!(cnf->lud->sortattr))
+      return;
+   if ((attr = ldapschema_find_attributetype(cnf->lsd, cnf->lud->sortattr)) == NULL)
+      return;
+
+   // values are compared by type when results are sorted locally
+   rule = NULL;
+   ldapschema_get_info_attributetype(cnf->lsd, attr, LDAPSCHEMA_FLD_ORDERING, &rule);
+   if (!(rule))
+      return;
+   if (ldapschema_get_info_matchingrule(cnf->lsd, rule, LDAPSCHEMA_FLD_OID, &cnf->sortrule) != 0)
+      return;
+   cnf->lud->sortrule = cnf->sortrule;
+
+   return;
 }
 
 
@@ -607,11 +989,20 @@ void
 my_unbind(
          MyConfig *                    cnf )
 {
+   size_t         x;
+   MyWorker *     worker;
+
    assert(cnf != NULL);
 
    if ((cnf->lsd))
       ldapschema_free(cnf->lsd);
 
+   if ((cnf->sortrule))
+      free(cnf->sortrule);
+
+   if ((cnf->out))
+      ldaputils_output_free(cnf->out);
+
    if ((cnf->lud))
       ldaputils_unbind(cnf->lud);
 
@@ -621,9 +1012,73 @@ my_unbind(
    if ((cnf->titles))
       free(cnf->titles);
 
+   if ((cnf->columns))
+   {
+      for(x = 0; (x < cnf->columns_len); x++)
+         if ((cnf->columns[x].names))
+            ldapschema_value_free(cnf->columns[x].names);
+      free(cnf->columns);
+   };
+
+   if ((cnf->aliases))
+      free(cnf->aliases);
+
+   if ((cnf->workers))
+   {
+      for(x = 0; (x < cnf->threads); x++)
+      {
+         if ((worker = cnf->workers[x]) == NULL)
+            continue;
+         if ((worker->dncache))
+            ldaputils_dn_cache_free(worker->dncache);
+         if ((worker->vals))
+            free(worker->vals);
+         if ((worker->held))
+            free(worker->held);
+         free(worker);
+      };
+      free(cnf->workers);
+   };
+
+
    free(cnf);
 
    return;
 }
 
+
+// allocates state of threads formatting entries
+int
+my_workers(
+         MyConfig *                    cnf )
+{
+   size_t         x;
+   MyWorker *     worker;
+
+   assert(cnf != NULL);
+
+   if ((cnf->workers = malloc(sizeof(void *) * cnf->threads)) == NULL)
+      return(LDAP_NO_MEMORY);
+   memset(cnf->workers, 0, (sizeof(void *) * cnf->threads));
+
+   // each thread parses DNs with its own table of DN suffixes
+   for(x = 0; (x < cnf->threads); x++)
+   {
+      if ((worker = malloc(sizeof(MyWorker))) == NULL)
+         return(LDAP_NO_MEMORY);
+      memset(worker, 0, sizeof(MyWorker));
+      cnf->workers[x] = worker;
+      worker->cnf     = cnf;
+      if ((worker->dncache = ldaputils_dn_cache_initialize()) == NULL)
+         return(LDAP_NO_MEMORY);
+      if ((worker->vals = malloc(sizeof(BerVarray) * cnf->columns_len)) == NULL)
+         return(LDAP_NO_MEMORY);
+      memset(worker->vals, 0, (sizeof(BerVarray) * cnf->columns_len));
+      if ((worker->held = malloc(sizeof(BerVarray) * cnf->columns_len)) == NULL)
+         return(LDAP_NO_MEMORY);
+   };
+
+   return(LDAP_SUCCESS);
+}
+
 /* end of source file */
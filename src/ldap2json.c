@@ -36,13 +36,14 @@
  *  Simple Build:
  *     export CFLAGS='-DPROGRAM_NAME="ldap2json" -Wall -I../include'
  *     gcc ${CFLAGS} -c ldap2json.c
- *     gcc ${CFLAGS} -lldap -o ldap2json ldap2json.o ../lib/libldaputils.a
+ *     gcc ${CFLAGS} -lldap -o ldap2json ldap2json.o ../lib/libldaputils.a \
+ *             ../lib/libldapschema.a
  *
  *  Libtool Build:
  *     export CFLAGS='-DPROGRAM_NAME="ldap2json" -Wall -I../include'
  *     libtool --mode=compile --tag=CC gcc ${CFLAGS} -c ldap2json.c
  *     libtool --mode=link    --tag=CC gcc ${CFLAGS} -lldap -o ldap2json \
- *             ldap2json.lo ../lib/libldaputils.a
+ *             ldap2json.lo ../lib/libldaputils.a ../lib/libldapschema.la
  *
  *  Libtool Clean:
  *     libtool --mode=clean rm -f ldap2json.lo ldap2json
@@ -65,6 +66,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <string.h>
 #include <strings.h>
@@ -77,6 +79,7 @@
 #endif
 #include <ldap.h>
 #include <ldaputils.h>
+#include <ldapschema.h>
 
 
 ///////////////////
@@ -101,15 +104,47 @@
 // MARK: - Datatypes
 
 // configuration union
+typedef struct my_attr MyAttr;
 typedef struct my_config MyConfig;
+typedef struct my_worker MyWorker;
+
+
+// attribute of entry being formatted
+struct my_attr
+{
+   struct berval      name;
+   BerVarray          vals;
+};
+
+
+// state of thread formatting entries
+struct my_worker
+{
+   MyConfig *         cnf;
+   LDAPUtilsDNCache * dncache;
+   size_t             attrs_len;
+   size_t             attrs_size;
+   MyAttr *           attrs;    // attributes of current entry
+};
+
+
 struct my_config
 {
-   size_t         attrs_len;
-   LDAPUtils *    lud;
-   const char *   filter;
-   const char *   prog_name;
-   const char **  defvals;
-   char           output[LDAPUTILS_OPT_LEN];
+   size_t             attrs_len;
+   size_t             count;
+   LDAPUtils *        lud;
+   size_t             parallel;
+   int                ordered;
+   int                ndjson;
+   LDAPSchema *       lsd;
+   LDAPUtilsOutput *  out;
+   size_t             threads;
+   void **            workers;       // MyWorker of each formatting thread
+   char *             sortrule;
+   const char *       filter;
+   const char *       prog_name;
+   const char **      defvals;
+   char               output[LDAPUTILS_OPT_LEN];
 };
 
 
@@ -135,10 +170,42 @@ my_config(
          MyConfig **                   cnfp );
 
 
+// formats entry
 static int
-my_results(
+my_format(
+         LDAP *                        ld,
+         LDAPMessage *                 msg,
+         LDAPUtilsOutput *             out,
+         void *                        context );
+
+
+// prints name of next member of entry
+static int
+my_member(
          MyConfig *                    cnf,
-         LDAPMessage *                 res );
+         LDAPUtilsOutput *             out,
+         size_t                        member,
+         const char *                  name,
+         size_t                        len );
+
+
+// prints entry
+static int
+my_result(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 msg,
+         void *                        context );
+
+
+static int
+my_search(
+         MyConfig *                    cnf );
+
+
+// determines ordering matching rule of sort attribute
+static void
+my_sortrule(
+         MyConfig *                    cnf );
 
 
 // fress resources
@@ -147,6 +214,12 @@ my_unbind(
          MyConfig *                    cnf );
 
 
+// allocates state of threads formatting entries
+static int
+my_workers(
+         MyConfig *                    cnf );
+
+
 /////////////////
 //             //
 //  Functions  //
@@ -162,6 +235,14 @@ ldaputils_usage(
    printf("Usage: %s [options] [filter] [attributes[:values]...]\n", PROGRAM_NAME);
    ldaputils_usage_search(MY_SHORT_OPTIONS);
    ldaputils_usage_common(MY_SHORT_OPTIONS);
+   printf("Parallel Options:\n");
+   printf("  --parallel=num            search subtrees of base DN using `num' connections\n");
+   printf("  --ordered                 print subtrees in order when searching in parallel\n");
+   printf("  --sort-threads=num        sort results in memory using `num' threads\n");
+   printf("  --max-memory=MiB          sort results larger than `MiB' using temporary files\n");
+   printf("  --format-threads=num      format entries using `num' threads\n");
+   printf("Output Options:\n");
+   printf("  --ndjson                  print each entry as a JSON object on a single line\n");
    printf("Special Attributes:\n");
    printf("  dn                        entry's DN\n");
    printf("  rdn                       entry's relative DN\n");
@@ -183,7 +264,6 @@ main(
 {
    int               err;
    MyConfig *        cnf;
-   LDAPMessage *     res;
 
    cnf = NULL;
 
@@ -201,22 +281,51 @@ main(
       return(1);
    };
 
-   // performs LDAP search
-   if ((err = ldaputils_search(cnf->lud, &res)) != LDAP_SUCCESS)
+   // fetches schema for ordering of sorted results
+   if ((cnf->lud->sortattr))
+   {
+      if ( ((err = ldapschema_fetch(cnf->lsd, cnf->lud->ld)) != LDAP_SUCCESS) && (err != LDAPSCHEMA_SCHEMA_ERROR) )
+      {
+         fprintf(stderr, "%s: ldapschema_fetch(): %s\n", cnf->lud->prog_name, ldapschema_err2string(err));
+         my_unbind(cnf);
+         return(1);
+      };
+      my_sortrule(cnf);
+   };
+   if ((err = my_workers(cnf)) != LDAP_SUCCESS)
    {
-      fprintf(stderr, "%s: ldaputils_search(): %s\n", ldaputils_get_prog_name(cnf->lud), ldap_err2string(err));
+      fprintf(stderr, "%s: %s\n", ldaputils_get_prog_name(cnf->lud), ldap_err2string(err));
       my_unbind(cnf);
       return(1);
    };
 
-   // prints values
-   if ((err = my_results(cnf, res)) != LDAP_SUCCESS)
+   // print header
+   if (!(cnf->ndjson))
+      ldaputils_output_puts(cnf->out, "[\n");
+
+   // performs LDAP search and prints values
+   if ((err = my_search(cnf)) != LDAP_SUCCESS)
    {
+      if (err != LDAP_NO_MEMORY)
+         fprintf(stderr, "%s: ldaputils_search(): %s\n", ldaputils_get_prog_name(cnf->lud), ldap_err2string(err));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // print footer
+   if ( ((cnf->count)) && (!(cnf->ndjson)) )
+      ldaputils_output_puts(cnf->out, "\n");
+   if (!(cnf->ndjson))
+      ldaputils_output_puts(cnf->out, "]\n");
+
+   // writes remaining output
+   if ((err = ldaputils_output_flush(cnf->out)) != LDAP_SUCCESS)
+   {
+      fprintf(stderr, "%s: write(): %s\n", ldaputils_get_prog_name(cnf->lud), ldap_err2string(err));
       my_unbind(cnf);
       return(1);
    };
 
-   ldap_msgfree(res);
    my_unbind(cnf);
 
    return(0);
@@ -236,16 +345,23 @@ my_config(
    int         c;
    int         err;
    int         option_index;
+   size_t      num;
    char *      str;
    MyConfig *  cnf;
 
    static char   short_options[] = MY_SHORT_OPTIONS;
    static struct option long_options[] =
    {
-      {"help",          no_argument, 0, 'h'},
-      {"verbose",       no_argument, 0, 'v'},
-      {"version",       no_argument, 0, 'V'},
-      {NULL,            0,           0, 0  }
+      {"parallel",      required_argument, 0, '1'},
+      {"ordered",       no_argument,       0, '2'},
+      {"sort-threads",  required_argument, 0, '3'},
+      {"max-memory",    required_argument, 0, '4'},
+      {"ndjson",        no_argument,       0, '5'},
+      {"format-threads",required_argument, 0, '6'},
+      {"help",          no_argument,       0, 'h'},
+      {"verbose",       no_argument,       0, 'v'},
+      {"version",       no_argument,       0, 'V'},
+      {NULL,            0,                 0, 0  }
    };
 
    // allocates memory for configuration
@@ -255,6 +371,7 @@ my_config(
       return(1);
    };
    memset(cnf, 0, sizeof(MyConfig));
+   cnf->threads = 1;
 
    // initialize ldap utilities
    if ((err = ldaputils_initialize(&cnf->lud, PROGRAM_NAME)) != LDAP_SUCCESS)
@@ -264,6 +381,22 @@ my_config(
       return(1);
    };
 
+   // initialize ldap schema
+   if ((err = ldapschema_initialize(&cnf->lsd)) != LDAP_SUCCESS)
+   {
+      fprintf(stderr, "%s: ldapschema_initialize(): %s\n", PROGRAM_NAME, ldapschema_err2string(err));
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // initialize buffered output
+   if ((err = ldaputils_output_initialize(&cnf->out, STDOUT_FILENO, 0)) != LDAP_SUCCESS)
+   {
+      fprintf(stderr, "%s: ldaputils_output_initialize(): %s\n", PROGRAM_NAME, ldap_err2string(err));
+      my_unbind(cnf);
+      return(1);
+   };
+
    // loops through args
    option_index = 0;
    while((c = getopt_long(argc, argv, short_options, long_options, &option_index)) != -1)
@@ -288,6 +421,48 @@ my_config(
          my_unbind(cnf);
          return(1);
 
+         case '1':
+         if (ldaputils_getopt_size(cnf->lud, "parallel", optarg, 0, LDAPUTILS_CONNS_MAX, &cnf->parallel) != 0)
+         {
+            my_unbind(cnf);
+            return(1);
+         };
+         break;
+
+         case '2':
+         cnf->ordered = 1;
+         break;
+
+         case '3':
+         if (ldaputils_getopt_size(cnf->lud, "sort-threads", optarg, 0, LDAPUTILS_THREADS_MAX, &num) != 0)
+         {
+            my_unbind(cnf);
+            return(1);
+         };
+         cnf->lud->sortthreads = (int)num;
+         break;
+
+         case '4':
+         if (ldaputils_getopt_size(cnf->lud, "max-memory", optarg, 0, (SIZE_MAX >> 20), &num) != 0)
+         {
+            my_unbind(cnf);
+            return(1);
+         };
+         cnf->lud->maxmemory = num << 20;
+         break;
+
+         case '5':
+         cnf->ndjson = 1;
+         break;
+
+         case '6':
+         if (ldaputils_getopt_size(cnf->lud, "format-threads", optarg, 1, LDAPUTILS_THREADS_MAX, &cnf->threads) != 0)
+         {
+            my_unbind(cnf);
+            return(1);
+         };
+         break;
+
          // argument error
          case '?':
          fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
@@ -360,170 +535,305 @@ my_config(
 }
 
 
-// prints results
+// prints name of next member of entry
 int
-my_results(
+my_member(
          MyConfig *                    cnf,
-         LDAPMessage *                 res )
+         LDAPUtilsOutput *             out,
+         size_t                        member,
+         const char *                  name,
+         size_t                        len )
 {
-   int               x;
-   int               y;
-   int               len;
-   char *            dnstr;
-   char *            dn;
-   char **           dns;
-   char *            delim;
-   LDAPMessage *     msg;
-   char **           vals;
-   LDAP *            ld;
-   BerElement *      ber;
-   char *            attr;
+   assert(cnf  != NULL);
+   assert(out  != NULL);
+   assert(name != NULL);
 
-   assert(cnf != NULL);
-   assert(res != NULL);
+   if ((member))
+      ldaputils_output_puts(out, ((cnf->ndjson)) ? "," : ",\n");
+   if (!(cnf->ndjson))
+      ldaputils_output_puts(out, "      ");
+   ldaputils_output_json(out, name, len);
 
-   ld = ldaputils_get_ld(cnf->lud);
+   return(ldaputils_output_puts(out, ((cnf->ndjson)) ? ":" : ": "));
+}
 
-   // sorts entries
-#ifdef USE_LDAP_DEPRECATED
-   if ((cnf->lud->sortattr))
-      ldap_sort_entries(ld, &res, cnf->lud->sortattr, strcasecmp);
-#endif
 
-   // print header
-   printf("[\n");
+// formats entry
+int
+my_format(
+         LDAP *                        ld,
+         LDAPMessage *                 msg,
+         LDAPUtilsOutput *             out,
+         void *                        context )
+{
+   int               rc;
+   size_t            x;
+   size_t            y;
+   size_t            len;
+   size_t            size;
+   size_t            members;
+   void *            ptr;
+   const char *      dnstr;
+   const char *      dnattr;
+   LDAPUtilsDN *     pdn;
+   struct berval     dn;
+   struct berval     bv;
+   BerVarray         vals;
+   BerElement *      ber;
+   MyAttr *          attr;
+   MyWorker *        worker;
+   MyConfig *        cnf;
+
+   assert(ld      != NULL);
+   assert(msg     != NULL);
+   assert(out     != NULL);
+   assert(context != NULL);
+
+   worker = context;
+   cnf    = worker->cnf;
 
-   // loops through entries
-   msg = ldap_first_entry(ld, res);
-   while ((msg))
+   // retrieve DN
+   ber = NULL;
+   if (ldap_get_dn_ber(ld, msg, &ber, &dn) != LDAP_SUCCESS)
    {
-      // retrieve first attribute
-      attr = ldap_first_attribute(ld, msg, &ber);
+      if ((ber))
+         ber_free(ber, 0);
+      fprintf(stderr, "%s: ldap_get_dn_ber(): out of virtual memory\n", cnf->prog_name);
+      return(LDAP_NO_MEMORY);
+   };
 
-      // retrieve DN and make CSV safe
-      if ((dn = ldap_get_dn(ld, msg)) == NULL)
+   // walks attributes of entry once, values are printed from the BER
+   // buffer of the entry after the pseudo attributes
+   vals              = NULL;
+   worker->attrs_len = 0;
+   for(rc = ldap_get_attribute_ber(ld, msg, ber, &bv, &vals); ((rc == LDAP_SUCCESS) && ((bv.bv_val))); rc = ldap_get_attribute_ber(ld, msg, ber, &bv, &vals))
+   {
+      if (worker->attrs_len >= worker->attrs_size)
       {
-         fprintf(stderr, "%s: malloc(): out of virtual memory\n", cnf->prog_name);
-         return(LDAP_NO_MEMORY);
+         size = ((worker->attrs_size)) ? (worker->attrs_size * 2) : 16;
+         if ((ptr = realloc(worker->attrs, (sizeof(MyAttr) * size))) == NULL)
+         {
+            if ((vals))
+               ber_memfree(vals);
+            rc = LDAP_NO_MEMORY;
+            break;
+         };
+         worker->attrs      = ptr;
+         worker->attrs_size = size;
       };
-      delim = dn;
-      while((delim = strchr(delim, '"')) != NULL)
-         delim[0] = '\'';
+      worker->attrs[worker->attrs_len].name = bv;
+      worker->attrs[worker->attrs_len].vals = vals;
+      worker->attrs_len++;
+      vals = NULL;
+   };
+   ber_free(ber, 0);
+   if (rc != LDAP_SUCCESS)
+   {
+      fprintf(stderr, "%s: ldap_get_attribute_ber(): %s\n", cnf->prog_name, ldap_err2string(rc));
+      for(x = 0; (x < worker->attrs_len); x++)
+         if ((worker->attrs[x].vals))
+            ber_memfree(worker->attrs[x].vals);
+      return(rc);
+   };
 
-      // start entry
-      if ((dns = ldap_explode_dn(dn, 0)) == NULL)
-      {
-         fprintf(stderr, "%s: ldap_explode_dn(): out of virtual memory\n", cnf->prog_name);
-         return(LDAP_NO_MEMORY);
-      };
-      printf("   {\n");
+   // start entry
+   pdn     = NULL;
+   members = 0;
+   ldaputils_output_puts(out, ((cnf->ndjson)) ? "{" : "   {\n");
 
-      // loop through psuedo attributes
-      for(x = 0; (((cnf->lud->attrs)) && ((cnf->lud->attrs[x]))); x++)
+   // loop through psuedo attributes
+   for(x = 0; ( (rc == LDAP_SUCCESS) && ((cnf->lud->attrs)) && ((cnf->lud->attrs[x])) ); x++)
+   {
+      if (strcasecmp("dn", cnf->lud->attrs[x]) == 0)
+      {
+         my_member(cnf, out, members++, "dn", 2);
+         ldaputils_output_json(out, dn.bv_val, dn.bv_len);
+      }
+      else if ( (!(strcasecmp("rdn", cnf->lud->attrs[x]))) || (!(strcasecmp("ufn", cnf->lud->attrs[x]))) ||
+                (!(strcasecmp("dce", cnf->lud->attrs[x]))) || (!(strcasecmp("adc", cnf->lud->attrs[x]))) )
       {
-         if (strcasecmp("dn", cnf->lud->attrs[x]) == 0)
-            printf("      \"dn\": \"%s\"", dn);
-         else if (strcasecmp("rdn", cnf->lud->attrs[x]) == 0)
-            printf("      \"rdn\": \"%s\"", dns[0]);
-         else if (strcasecmp("ufn", cnf->lud->attrs[x]) == 0)
+         // parses DN once for all formats of entry
+         if ( (!(pdn)) && ((pdn = ldaputils_dn_parse_bv(worker->dncache, &dn)) == NULL) )
+         {
+            fprintf(stderr, "%s: ldaputils_dn_parse_bv(): out of virtual memory\n", cnf->prog_name);
+            rc = LDAP_NO_MEMORY;
+            break;
+         };
+         if (!(strcasecmp("rdn", cnf->lud->attrs[x])))
          {
-            if ((dnstr = ldap_dn2ufn(dn)) == NULL)
-            {
-               fprintf(stderr, "%s: ldap_dn2ufn(): out of virtual memory\n", cnf->prog_name);
-               return(LDAP_NO_MEMORY);
-            };
-            printf("      \"ufn\": \"%s\"", dnstr);
-            ldap_memfree(dnstr);
+            dnattr = "rdn";
+            dnstr  = ldaputils_dn_get_rdn(pdn);
          }
-         else if (strcasecmp("dce", cnf->lud->attrs[x]) == 0)
+         else if (!(strcasecmp("ufn", cnf->lud->attrs[x])))
          {
-            if ((dnstr = ldap_dn2dcedn(dn)) == NULL)
-            {
-               fprintf(stderr, "%s: ldap_dn2dcedn(): out of virtual memory\n", cnf->prog_name);
-               return(LDAP_NO_MEMORY);
-            };
-            printf("      \"dce\": \"%s\"", dnstr);
-            ldap_memfree(dnstr);
+            dnattr = "ufn";
+            dnstr  = ldaputils_dn_get_ufn(pdn);
          }
-         else if (strcasecmp("adc", cnf->lud->attrs[x]) == 0)
+         else if (!(strcasecmp("dce", cnf->lud->attrs[x])))
          {
-            if ((dnstr = ldap_dn2ad_canonical(dn)) == NULL)
-            {
-               fprintf(stderr, "%s: ldap_dn2ad_canonical(): out of virtual memory\n", cnf->prog_name);
-               return(LDAP_NO_MEMORY);
-            };
-            printf("      \"adc\": \"%s\"", dnstr);
-            ldap_memfree(dnstr);
+            dnattr = "dce";
+            dnstr  = ldaputils_dn_get_dce(pdn);
          }
          else
          {
-            if ((vals = ldaputils_get_values(ld, msg, cnf->lud->attrs[x])) != NULL)
-            {
-               ldaputils_value_free(vals);
-               continue;
-            };
-            if (cnf->defvals[x] == NULL)
-               continue;
-            printf("      \"%s\": \"%s\"", cnf->lud->attrs[x], cnf->defvals[x]);
+            dnattr = "adc";
+            dnstr  = ldaputils_dn_get_adc(pdn);
          };
-
-         if ( ((cnf->lud->attrs[x+1])) || ((attr)) )
-            printf(",\n");
-         else
-            printf("\n");
+         if (!(dnstr))
+         {
+            fprintf(stderr, "%s: ldap_dn2str(): out of virtual memory\n", cnf->prog_name);
+            rc = LDAP_NO_MEMORY;
+            break;
+         };
+         my_member(cnf, out, members++, dnattr, 3);
+         ldaputils_output_json(out, dnstr, strlen(dnstr));
+      }
+      else
+      {
+         // prints default value of attribute missing from entry
+         len = strlen(cnf->lud->attrs[x]);
+         for(y = 0; (y < worker->attrs_len); y++)
+         {
+            attr = &worker->attrs[y];
+            if ( (attr->name.bv_len == len) && (!(strncasecmp(attr->name.bv_val, cnf->lud->attrs[x], len))) )
+               break;
+         };
+         if ( (y < worker->attrs_len) || (cnf->defvals[x] == NULL) )
+            continue;
+         my_member(cnf, out, members++, cnf->lud->attrs[x], len);
+         ldaputils_output_json(out, cnf->defvals[x], strlen(cnf->defvals[x]));
       };
+   };
 
-      ldaputils_value_free(dns);
-      ldap_memfree(dn);
+   // loop through attributes
+   for(x = 0; ( (rc == LDAP_SUCCESS) && (x < worker->attrs_len) ); x++)
+   {
+      attr = &worker->attrs[x];
+      vals = attr->vals;
+      my_member(cnf, out, members++, attr->name.bv_val, attr->name.bv_len);
 
-      // loop through attributes
-      while ((attr))
+      if ( (!(vals)) || (!(vals[0].bv_val)) )
       {
-         // retrieves values
-         if ((vals = ldaputils_get_values(ld, msg, attr)) == NULL)
-         {
-            for(x = 0; ( ((cnf->lud->attrs[x])) && (!(strcasecmp(attr, cnf->lud->attrs[x])))); x++);
-            if ((cnf->defvals[x]))
-                printf("      \"%s\": \"%s\"", attr, cnf->defvals[x]);
-            else
-               printf("      \"%s\": null", attr);
-         }
-         else if (vals[1] == NULL)
-         {
-            printf("      \"%s\": \"%s\"", attr, vals[0]);
-            ldaputils_value_free(vals);
-         }
+         for(y = 0; ( ((cnf->lud->attrs)) && ((cnf->lud->attrs[y])) ); y++)
+            if ( (strlen(cnf->lud->attrs[y]) == attr->name.bv_len) && (!(strncasecmp(cnf->lud->attrs[y], attr->name.bv_val, attr->name.bv_len))) )
+               break;
+         if ( ((cnf->lud->attrs)) && ((cnf->defvals[y])) )
+            ldaputils_output_json(out, cnf->defvals[y], strlen(cnf->defvals[y]));
          else
+            ldaputils_output_puts(out, "null");
+      }
+      else if (vals[1].bv_val == NULL)
+      {
+         ldaputils_output_json_value(out, vals[0].bv_val, vals[0].bv_len);
+      }
+      else
+      {
+         ldaputils_output_putc(out, '[');
+         for(y = 0; ((vals[y].bv_val)); y++)
          {
-            printf("      \"%s\": [", attr);
-            for(len = 0; ((vals[len])); len++);
-            for(y = 0; (y < len); y++)
-            {
-               if (y > 0)
-                  printf(", \"%s\"", vals[y]);
-               else
-                  printf(" \"%s\"", vals[y]);
-            };
-            printf(" ]");
-            ldaputils_value_free(vals);
+            if (y > 0)
+               ldaputils_output_puts(out, ((cnf->ndjson)) ? "," : ", ");
+            else if (!(cnf->ndjson))
+               ldaputils_output_putc(out, ' ');
+            ldaputils_output_json_value(out, vals[y].bv_val, vals[y].bv_len);
          };
-         if ((attr = ldap_next_attribute(ld, msg, ber)) == NULL)
-            printf("\n");
-         else
-            printf(",\n");
+         ldaputils_output_puts(out, ((cnf->ndjson)) ? "]" : " ]");
       };
-      ber_free(ber, 0);
-
-      // retrieves next entry
-      if ((msg = ldap_next_entry(ld, msg)) == NULL)
-         printf("   }\n");
-      else
-         printf("   },\n");
    };
 
-   printf("]\n");
+   // frees values and DN
+   for(x = 0; (x < worker->attrs_len); x++)
+      if ((worker->attrs[x].vals))
+         ber_memfree(worker->attrs[x].vals);
+   worker->attrs_len = 0;
+   ldaputils_dn_free(pdn);
+
+   if (rc != LDAP_SUCCESS)
+      return(rc);
+
+   // end entry
+   if ((cnf->ndjson))
+      return(ldaputils_output_puts(out, "}\n"));
+   if ((members))
+      ldaputils_output_puts(out, "\n");
+   return(ldaputils_output_puts(out, "   }"));
+}
 
-   return(LDAP_SUCCESS);
+
+// prints entry
+int
+my_result(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 msg,
+         void *                        context )
+{
+   MyConfig *        cnf;
+
+   assert(context != NULL);
+
+   cnf = context;
+
+   // separate entry from previous entry
+   if ( ((cnf->count++)) && (!(cnf->ndjson)) )
+      ldaputils_output_puts(cnf->out, ",\n");
+
+   return(my_format(ldaputils_get_ld(lud), msg, cnf->out, cnf->workers[0]));
+}
+
+
+// performs search and prints results
+int
+my_search(
+         MyConfig *                    cnf )
+{
+   int                  err;
+   int                  rc;
+   LDAPUtilsPipeline *  pipe;
+
+   assert(cnf != NULL);
+
+   // sorted results are requested from the server when supported
+   if ((cnf->lud->sortattr))
+      return(ldaputils_search_sorted(cnf->lud, &my_result, cnf));
+
+   if (cnf->threads < 2)
+      return(ldaputils_search_parallel(cnf->lud, cnf->parallel, cnf->ordered, &my_result, cnf));
+
+   // formats entries in other threads while results are received
+   if ((err = ldaputils_pipeline_initialize(&pipe, cnf->out, ((cnf->ndjson)) ? NULL : ",\n", cnf->threads, &my_format, cnf->workers)) != LDAP_SUCCESS)
+      return(err);
+   err = ldaputils_search_parallel(cnf->lud, cnf->parallel, cnf->ordered, &ldaputils_pipeline_entry, pipe);
+   rc  = ldaputils_pipeline_finish(pipe, &cnf->count);
+
+   return((err != LDAP_SUCCESS) ? err : rc);
+}
+
+
+// determines ordering matching rule of sort attribute
+void
+my_sortrule(
+         MyConfig *                    cnf )
+{
+   LDAPSchemaAttributeType *  attr;
+   LDAPSchemaMatchingRule *   rule;
+
+   assert(cnf != NULL);
+
+   if (!(cnf->lud->sortattr))
+      return;
+   if ((attr = ldapschema_find_attributetype(cnf->lsd, cnf->lud->sortattr)) == NULL)
+      return;
+
+   // values are compared by type when results are sorted locally
+   rule = NULL;
+   ldapschema_get_info_attributetype(cnf->lsd, attr, LDAPSCHEMA_FLD_ORDERING, &rule);
+   if (!(rule))
+      return;
+   if (ldapschema_get_info_matchingrule(cnf->lsd, rule, LDAPSCHEMA_FLD_OID, &cnf->sortrule) != 0)
+      return;
+   cnf->lud->sortrule = cnf->sortrule;
+
+   return;
 }
 
 
@@ -532,17 +842,74 @@ void
 my_unbind(
          MyConfig *                    cnf )
 {
+   size_t         x;
+   MyWorker *     worker;
+
    assert(cnf != NULL);
 
+   if ((cnf->lsd))
+      ldapschema_free(cnf->lsd);
+
+   if ((cnf->sortrule))
+      free(cnf->sortrule);
+
+   if ((cnf->out))
+      ldaputils_output_free(cnf->out);
+
    if ((cnf->lud))
       ldaputils_unbind(cnf->lud);
 
    if ((cnf->defvals))
       free(cnf->defvals);
 
+   if ((cnf->workers))
+   {
+      for(x = 0; (x < cnf->threads); x++)
+      {
+         if ((worker = cnf->workers[x]) == NULL)
+            continue;
+         if ((worker->dncache))
+            ldaputils_dn_cache_free(worker->dncache);
+         if ((worker->attrs))
+            free(worker->attrs);
+         free(worker);
+      };
+      free(cnf->workers);
+   };
+
    free(cnf);
 
    return;
 }
 
+
+// allocates state of threads formatting entries
+int
+my_workers(
+         MyConfig *                    cnf )
+{
+   size_t         x;
+   MyWorker *     worker;
+
+   assert(cnf != NULL);
+
+   if ((cnf->workers = malloc(sizeof(void *) * cnf->threads)) == NULL)
+      return(LDAP_NO_MEMORY);
+   memset(cnf->workers, 0, (sizeof(void *) * cnf->threads));
+
+   // each thread parses DNs with its own table of DN suffixes
+   for(x = 0; (x < cnf->threads); x++)
+   {
+      if ((worker = malloc(sizeof(MyWorker))) == NULL)
+         return(LDAP_NO_MEMORY);
+      memset(worker, 0, sizeof(MyWorker));
+      cnf->workers[x] = worker;
+      worker->cnf     = cnf;
+      if ((worker->dncache = ldaputils_dn_cache_initialize()) == NULL)
+         return(LDAP_NO_MEMORY);
+   };
+
+   return(LDAP_SUCCESS);
+}
+
 /* end of source file */
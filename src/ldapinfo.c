@@ -90,6 +90,15 @@
 
 #define MY_SHORT_OPTIONS LDAPUTILS_OPTIONS_COMMON LDAPUTILS_OPTIONS_SEARCH "o:"
 
+// results of searches submitted after the root DSE
+#define MY_RES_VERSION        0
+#define MY_RES_SCHEMA         1
+#define MY_RES_LISTENERS      2
+#define MY_RES_CONNECTIONS    3
+#define MY_RES_OPERATIONS     4
+#define MY_RES_DATABASES      5
+#define MY_RES_LEN            6
+
 
 /////////////////
 //             //
@@ -198,31 +207,48 @@ my_fields(
 static char *
 my_monitor(
          MyConfig *                    cnf,
-         const char *                  base );
+         LDAPMessage *                 res );
 
 
 static int
 my_monitor_connections(
          MyConfig *                    cnf,
-         const char *                  base );
+         LDAPMessage *                 res );
 
 
 static int
 my_monitor_database(
          MyConfig *                    cnf,
-         const char *                  base );
+         LDAPMessage *                 res );
 
 
 static int
 my_monitor_listeners(
          MyConfig *                    cnf,
-         const char *                  base );
+         LDAPMessage *                 res );
 
 
 static int
 my_monitor_operations(
          MyConfig *                    cnf,
-         const char *                  base );
+         LDAPMessage *                 res );
+
+
+// submits schema and monitor searches
+static void
+my_requests(
+         MyConfig *                    cnf,
+         char **                       schema,
+         char **                       monitor,
+         LDAPMessage **                results );
+
+
+// stores successful search result
+static int
+my_retain(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 res,
+         void *                        context );
 
 
 // parses RootDSE
@@ -234,7 +260,7 @@ my_rootdse(
 static int
 my_schema(
          MyConfig *                    cnf,
-         const char *                  base );
+         LDAPMessage *                 res );
 
 
 // fress resources
@@ -486,52 +512,29 @@ my_fields(
 char *
 my_monitor(
          MyConfig *                    cnf,
-         const char *                  base )
+         LDAPMessage *                 res )
 {
-   int               rc;
-   int               err;
-   int               msgid;
    char *            str;
    char *            vers;
    char **           vars;
    LDAP *            ld;
-   LDAPMessage *     res;
    LDAPMessage *     msg;
-   struct timeval    timeout;
 
    ld  = cnf->lud->ld;
 
-   // searches for cn=Connections,<monitor>
-   timeout.tv_sec  = 5;
-   timeout.tv_usec = 0;
-   if ((err = ldap_search_ext(ld, base, LDAP_SCOPE_BASE, "(objectclass=*)", cnf->lud->attrs, 0, NULL, NULL, &timeout, -1, &msgid)) != LDAP_SUCCESS)
-      return(NULL);
-   if ((err = ldap_result(ld, msgid, LDAP_MSG_ALL, NULL, &res)) < 1)
+   if (!(res))
       return(NULL);
 
-   // parses result
-   rc = ldap_parse_result(ld, res, &err, NULL, NULL, NULL, NULL, 0);
-   if ((rc != LDAP_SUCCESS) || (err != LDAP_SUCCESS))
-   {
-      ldap_msgfree(res);
-      return(NULL);
-   };
-
    // retrieves entry
    msg   = ldap_first_entry(ld, res);
 
    if ((vars = ldaputils_get_values(ld, msg, "monitoredInfo")) == NULL)
-   {
-      ldap_msgfree(res);
       return(NULL);
-   };
    if (!(vars[0][0]))
    {
       ldaputils_value_free(vars);
-      ldap_msgfree(res);
       return(NULL);
    };
-   ldap_msgfree(res);
 
    if (!(strstr(vars[0], "OpenLDAP: ")))
    {
@@ -551,41 +554,20 @@ my_monitor(
 int
 my_monitor_connections(
          MyConfig *                    cnf,
-         const char *                  base )
+         LDAPMessage *                 res )
 {
-   int               rc;
-   int               err;
-   int               msgid;
    int               count;
    char **           name;
    char **           vals;
    char              buff[256];
-   char              dn[256];
    LDAP *            ld;
-   LDAPMessage *     res;
    LDAPMessage *     msg;
-   struct timeval    timeout;
 
    ld  = cnf->lud->ld;
 
-   // searches for cn=Connections,<monitor>
-   timeout.tv_sec  = 5;
-   timeout.tv_usec = 0;
-   strncpy(dn, "cn=Connections,", sizeof(dn));
-   strncat(dn, base, (sizeof(dn)-strlen(dn)-1));
-   if ((err = ldap_search_ext(ld, dn, LDAP_SCOPE_ONE, "(objectclass=*)", cnf->lud->attrs, 0, NULL, NULL, &timeout, -1, &msgid)) != LDAP_SUCCESS)
-      return(-1);
-   if ((err = ldap_result(ld, msgid, LDAP_MSG_ALL, NULL, &res)) < 1)
+   if (!(res))
       return(-1);
 
-   // parses result
-   rc = ldap_parse_result(ld, res, &err, NULL, NULL, NULL, NULL, 0);
-   if ((rc != LDAP_SUCCESS) || (err != LDAP_SUCCESS))
-   {
-      ldap_msgfree(res);
-      return(-1);
-   };
-
    // retrieves entry
    count = 0;
    msg   = ldap_first_entry(ld, res);
@@ -642,40 +624,19 @@ my_monitor_connections(
 int
 my_monitor_database(
          MyConfig *                    cnf,
-         const char *                  base )
+         LDAPMessage *                 res )
 {
-   int               rc;
-   int               err;
-   int               msgid;
    int               count;
    size_t            s;
    char **           vals;
-   char              dn[256];
    char              buff[256];
    LDAP *            ld;
-   LDAPMessage *     res;
    LDAPMessage *     msg;
-   struct timeval    timeout;
 
    ld  = cnf->lud->ld;
 
-   // searches for cn=Databases,cn=monitor
-   timeout.tv_sec  = 5;
-   timeout.tv_usec = 0;
-   strncpy(dn, "cn=Databases,", sizeof(dn));
-   strncat(dn, base, (sizeof(dn)-strlen(dn)-1));
-   if ((err = ldap_search_ext(ld, dn, LDAP_SCOPE_ONE, "(objectclass=*)", cnf->lud->attrs, 0, NULL, NULL, &timeout, -1, &msgid)) != LDAP_SUCCESS)
-      return(-1);
-   if ((err = ldap_result(ld, msgid, LDAP_MSG_ALL, NULL, &res)) < 1)
-      return(-1);
-
-   // parses result
-   rc = ldap_parse_result(ld, res, &err, NULL, NULL, NULL, NULL, 0);
-   if ((rc != LDAP_SUCCESS) || (err != LDAP_SUCCESS))
-   {
-      ldap_msgfree(res);
+   if (!(res))
       return(-1);
-   };
 
    // retrieves entry
    count = 0;
@@ -730,42 +691,21 @@ my_monitor_database(
 int
 my_monitor_listeners(
          MyConfig *                    cnf,
-         const char *                  base )
+         LDAPMessage *                 res )
 {
-   int               rc;
-   int               err;
-   int               msgid;
    int               count;
    char *            uri;
    char **           uris;
    char *            addr;
    char **           addrs;
-   char              dn[256];
    char              buff[256];
    LDAP *            ld;
-   LDAPMessage *     res;
    LDAPMessage *     msg;
-   struct timeval    timeout;
 
    ld  = cnf->lud->ld;
 
-   // searches for cn=Connections,<monitor>
-   timeout.tv_sec  = 5;
-   timeout.tv_usec = 0;
-   strncpy(dn, "cn=Listeners,", sizeof(dn));
-   strncat(dn, base, (sizeof(dn)-strlen(dn)-1));
-   if ((err = ldap_search_ext(ld, dn, LDAP_SCOPE_ONE, "(objectclass=*)", cnf->lud->attrs, 0, NULL, NULL, &timeout, -1, &msgid)) != LDAP_SUCCESS)
-      return(-1);
-   if ((err = ldap_result(ld, msgid, LDAP_MSG_ALL, NULL, &res)) < 1)
-      return(-1);
-
-   // parses result
-   rc = ldap_parse_result(ld, res, &err, NULL, NULL, NULL, NULL, 0);
-   if ((rc != LDAP_SUCCESS) || (err != LDAP_SUCCESS))
-   {
-      ldap_msgfree(res);
+   if (!(res))
       return(-1);
-   };
 
    // retrieves entry
    count = 0;
@@ -836,42 +776,21 @@ my_monitor_listeners(
 int
 my_monitor_operations(
          MyConfig *                    cnf,
-         const char *                  base )
+         LDAPMessage *                 res )
 {
-   int               rc;
-   int               err;
-   int               msgid;
    int               count;
    char **           cn;
    char **           initiated;
    char **           completed;
-   char              dn[256];
    char              buff[256];
    LDAP *            ld;
-   LDAPMessage *     res;
    LDAPMessage *     msg;
-   struct timeval    timeout;
 
    ld  = cnf->lud->ld;
 
-   // searches for cn=Connections,<monitor>
-   timeout.tv_sec  = 5;
-   timeout.tv_usec = 0;
-   strncpy(dn, "cn=Operations,", sizeof(dn));
-   strncat(dn, base, (sizeof(dn)-strlen(dn)-1));
-   if ((err = ldap_search_ext(ld, dn, LDAP_SCOPE_ONE, "(objectclass=*)", cnf->lud->attrs, 0, NULL, NULL, &timeout, -1, &msgid)) != LDAP_SUCCESS)
-      return(-1);
-   if ((err = ldap_result(ld, msgid, LDAP_MSG_ALL, NULL, &res)) < 1)
+   if (!(res))
       return(-1);
 
-   // parses result
-   rc = ldap_parse_result(ld, res, &err, NULL, NULL, NULL, NULL, 0);
-   if ((rc != LDAP_SUCCESS) || (err != LDAP_SUCCESS))
-   {
-      ldap_msgfree(res);
-      return(-1);
-   };
-
    // retrieves entry
    count = 0;
    msg   = ldap_first_entry(ld, res);
@@ -940,6 +859,77 @@ my_monitor_operations(
 }
 
 
+// submits schema and monitor searches
+void
+my_requests(
+         MyConfig *                    cnf,
+         char **                       schema,
+         char **                       monitor,
+         LDAPMessage **                results )
+{
+   size_t            x;
+   char              dn[256];
+   LDAPUtilsMux *    mux;
+   struct timeval    timeout;
+
+   static const char * rdns[] =
+   {
+      [MY_RES_LISTENERS]   = "cn=Listeners,",
+      [MY_RES_CONNECTIONS] = "cn=Connections,",
+      [MY_RES_OPERATIONS]  = "cn=Operations,",
+      [MY_RES_DATABASES]   = "cn=Databases,",
+   };
+
+   if ((ldaputils_mux_initialize(&mux, cnf->lud)) != LDAP_SUCCESS)
+      return;
+
+   timeout.tv_sec  = 5;
+   timeout.tv_usec = 0;
+
+   // searches for subschema entry
+   if ((schema))
+      ldaputils_mux_search(mux, schema[0], LDAP_SCOPE_BASE, "(objectclass=*)", cnf->lud->attrs, &timeout, &my_retain, &results[MY_RES_SCHEMA]);
+
+   // searches for <monitor> and the children of cn=...,<monitor>
+   if ((monitor))
+   {
+      ldaputils_mux_search(mux, monitor[0], LDAP_SCOPE_BASE, "(objectclass=*)", cnf->lud->attrs, &timeout, &my_retain, &results[MY_RES_VERSION]);
+      for(x = MY_RES_LISTENERS; x < MY_RES_LEN; x++)
+      {
+         strncpy(dn, rdns[x], sizeof(dn));
+         strncat(dn, monitor[0], (sizeof(dn)-strlen(dn)-1));
+         ldaputils_mux_search(mux, dn, LDAP_SCOPE_ONE, "(objectclass=*)", cnf->lud->attrs, &timeout, &my_retain, &results[x]);
+      };
+   };
+
+   // waits for all searches to complete
+   ldaputils_mux_result(mux, &timeout);
+   ldaputils_mux_free(mux);
+
+   return;
+}
+
+
+// stores successful search result
+int
+my_retain(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 res,
+         void *                        context )
+{
+   int               rc;
+   int               err;
+
+   rc = ldap_parse_result(ldaputils_get_ld(lud), res, &err, NULL, NULL, NULL, NULL, 0);
+   if ((rc != LDAP_SUCCESS) || (err != LDAP_SUCCESS))
+      return(LDAP_SUCCESS);
+
+   *((LDAPMessage **)context) = res;
+
+   return(LDAPUTILS_SEARCH_RETAIN);
+}
+
+
 // parses RootDSE
 int
 my_rootdse(
@@ -957,6 +947,7 @@ my_rootdse(
    LDAP *            ld;
    LDAPMessage *     res;
    LDAPMessage *     msg;
+   LDAPMessage *     results[MY_RES_LEN];
    struct timeval    timeout;
 
    ld  = cnf->lud->ld;
@@ -1006,9 +997,11 @@ my_rootdse(
    // retrieve DNs
    schema   = ldaputils_get_values(ld, msg, "subschemaSubentry");
    monitor  = ldaputils_get_values(ld, msg, "monitorContext");
-   vers     = NULL;
-   if ((monitor))
-      vers  = my_monitor(cnf, monitor[0]);
+
+   // retrieves schema and monitor entries
+   memset(results, 0, sizeof(results));
+   my_requests(cnf, schema, monitor, results);
+   vers     = my_monitor(cnf, results[MY_RES_VERSION]);
 
    // obtain vendor name and version
    if ((vals = ldaputils_get_values(ld, msg, "vendorName")) != NULL)
@@ -1055,26 +1048,26 @@ my_rootdse(
 
    // print schema
    if ((schema))
-      my_schema(cnf, schema[0]);
+      my_schema(cnf, results[MY_RES_SCHEMA]);
 
    // display monitoring information
    if ((monitor))
    {
       // listeners
-      my_monitor_listeners(cnf, monitor[0]);
+      my_monitor_listeners(cnf, results[MY_RES_LISTENERS]);
 
       // connection stats
-      my_monitor_connections(cnf, monitor[0]);
+      my_monitor_connections(cnf, results[MY_RES_CONNECTIONS]);
 
       // operations
-      my_monitor_operations(cnf, monitor[0]);
+      my_monitor_operations(cnf, results[MY_RES_OPERATIONS]);
    };
 
    // obtain naming contexts
    vals = ldaputils_get_values(ld, msg, "namingContexts");
    if ((monitor))
    {
-      if ((rc = my_monitor_database(cnf, monitor[0])) == -1)
+      if ((rc = my_monitor_database(cnf, results[MY_RES_DATABASES])) == -1)
          my_fields("Naming contexts:", vals, 0);
       printf("\n");
    }
@@ -1090,6 +1083,9 @@ my_rootdse(
       ldaputils_value_free(monitor);
    if ((vers))
       free(vers);
+   for(s = 0; s < MY_RES_LEN; s++)
+      if ((results[s]))
+         ldap_msgfree(results[s]);
 
    // obtain supported controls
    if ((vals = ldaputils_get_values(ld, msg, "supportedControl")) != NULL)
@@ -1133,36 +1129,18 @@ my_rootdse(
 int
 my_schema(
          MyConfig *                    cnf,
-         const char *                  base )
+         LDAPMessage *                 res )
 {
-   int               rc;
-   int               err;
-   int               msgid;
    int               i;
    char **           vals;
    char              buff[256];
    LDAP *            ld;
-   LDAPMessage *     res;
    LDAPMessage *     msg;
-   struct timeval    timeout;
 
    ld  = cnf->lud->ld;
 
-   // searches for cn=Connections,<monitor>
-   timeout.tv_sec  = 5;
-   timeout.tv_usec = 0;
-   if ((err = ldap_search_ext(ld, base, LDAP_SCOPE_BASE, "(objectclass=*)", cnf->lud->attrs, 0, NULL, NULL, &timeout, -1, &msgid)) != LDAP_SUCCESS)
-      return(-1);
-   if ((err = ldap_result(ld, msgid, LDAP_MSG_ALL, NULL, &res)) < 1)
-      return(-1);
-
-   // parses result
-   rc = ldap_parse_result(ld, res, &err, NULL, NULL, NULL, NULL, 0);
-   if ((rc != LDAP_SUCCESS) || (err != LDAP_SUCCESS))
-   {
-      ldap_msgfree(res);
+   if (!(res))
       return(-1);
-   };
 
    // retrieves entry
    msg   = ldap_first_entry(ld, res);
@@ -65,6 +65,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <unistd.h>
 #include <string.h>
 #include <strings.h>
@@ -89,6 +90,8 @@
 
 #define MY_SHORT_OPTIONS LDAPUTILS_OPTIONS_COMMON LDAPUTILS_OPTIONS_SEARCH "87:6:5:4:3"
 
+#define MY_LAZY_OUTSTANDING 64   // maximum one level searches waiting for results
+
 
 /////////////////
 //             //
@@ -99,13 +102,32 @@
 
 /* configuration union */
 typedef struct my_config MyConfig;
+typedef struct my_level  MyLevel;
 struct my_config
 {
    LDAPUtils *          lud;
    int                  copy_entry;
-   int                  pad0;
+   int                  lazy;
    char *               basedn;
+   LDAPUtilsTree *      tree;
    LDAPUtilsTreeOpts    treeopts;
+   LDAPUtilsMux *       mux;
+   MyLevel **           levels;
+   size_t               levels_len;
+   size_t               levels_size;
+   size_t               levels_next;
+   size_t               levels_done;
+};
+
+
+/* search for the children of a node when expanding lazily */
+struct my_level
+{
+   MyConfig *           cnf;
+   char *               dn;
+   size_t               depth;
+   int                  scope;
+   int                  sizelimit;
 };
 
 
@@ -131,6 +153,43 @@ my_config(
          MyConfig **                   cnfp );
 
 
+// expands tree one level at a time
+static int
+my_lazy(
+         MyConfig *                    cnf );
+
+
+// queues search of a node
+static int
+my_lazy_queue(
+         MyConfig *                    cnf,
+         char *                        dn,
+         size_t                        depth,
+         int                           scope );
+
+
+// adds children of a node to tree and queues their searches
+static int
+my_lazy_result(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 res,
+         void *                        context );
+
+
+// submits queued searches
+static int
+my_lazy_submit(
+         MyConfig *                    cnf );
+
+
+// adds entry of lazy expansion to tree
+static int
+my_result(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 msg,
+         void *                        context );
+
+
 // fress resources
 static void
 my_unbind(
@@ -152,6 +211,11 @@ ldaputils_usage(
    printf("Usage: %s [options] [filter] [attributes...]\n", PROGRAM_NAME);
    ldaputils_usage_search(MY_SHORT_OPTIONS);
    ldaputils_usage_common(MY_SHORT_OPTIONS);
+   printf("Window Options:\n");
+   printf("  --offset=num              position of first entry within sorted results (default: 1)\n");
+   printf("  --count=num               number of entries to retrieve from sorted results\n");
+   printf("Search Options:\n");
+   printf("  --lazy                    retrieve only the displayed levels with one level searches\n");
    printf("Display Options:\n");
    printf("  --noleaf                  do not print leaf nodes\n");
    printf("  --max-depth=num           maximum depth to display\n");
@@ -177,8 +241,6 @@ main(
    int               i;
    char *            str;
    MyConfig *        cnf;
-   LDAPMessage *     res;
-   LDAPUtilsTree *   tree;
 
    cnf = NULL;
 
@@ -196,31 +258,34 @@ main(
       return(1);
    };
 
-   // performs LDAP search
-   if ((err = ldaputils_search(cnf->lud, &res)) != LDAP_SUCCESS)
+   // initialize tree
+   if ((cnf->tree = ldaputils_tree_initialize(NULL, 0)) == NULL)
    {
-      fprintf(stderr, "%s: ldaputils_search(): %s\n", cnf->lud->prog_name, ldap_err2string(err));
+      fprintf(stderr, "%s: ldaputils_tree_initialize(): out of virtual memory\n", cnf->lud->prog_name);
       my_unbind(cnf);
       return(1);
    };
 
-   // retrieve entries
-   if ((tree = ldaputils_get_tree(cnf->lud->ld, res, cnf->copy_entry)) == NULL)
+   // performs LDAP search and adds entries to tree as they arrive
+   if ((cnf->lazy))
+      err = my_lazy(cnf);
+   else
+      err = ldaputils_tree_search(cnf->lud, cnf->tree, cnf->copy_entry);
+   if (err != LDAP_SUCCESS)
    {
-      fprintf(stderr, "%s: ldaputils_get_entries(): out of virtual memory\n", cnf->lud->prog_name);
+      fprintf(stderr, "%s: ldaputils_search(): %s\n", cnf->lud->prog_name, ldap_err2string(err));
       my_unbind(cnf);
-      ldap_msgfree(res);
       return(1);
    };
-   ldap_msgfree(res);
 
    // print header
    if (cnf->lud->silent < 2)
    {
       printf("#\n");
       ldap_get_option(cnf->lud->ld, LDAP_OPT_DEFBASE, &str);
-      switch(cnf->lud->scope)
+      switch( ((cnf->lazy)) ? -1 : cnf->lud->scope )
       {
+         case -1:                  printf("# base: %s with lazy expansion\n", str); break;
          case LDAP_SCOPE_ONE:      printf("# base: %s with scope one\n", str); break;
          case LDAP_SCOPE_SUBTREE:  printf("# base: %s with scope subtree\n", str); break;
          case LDAP_SCOPE_BASE:     printf("# base: %s with scope base\n", str); break;
@@ -239,10 +304,9 @@ main(
    };
 
    // displays entries
-   ldaputils_tree_print(tree, &cnf->treeopts);
+   ldaputils_tree_print(cnf->tree, &cnf->treeopts);
 
    // frees resources
-   ldaputils_tree_free(tree);
    my_unbind(cnf);
 
    return(0);
@@ -259,10 +323,12 @@ my_config(
          char *                        argv[],
          MyConfig **                   cnfp )
 {
-   int        c;
-   int        err;
-   int        option_index;
-   MyConfig * cnf;
+   int            c;
+   int            err;
+   int            option_index;
+   size_t         num;
+   const char *   msg;
+   MyConfig *     cnf;
 
    static char   short_options[] = MY_SHORT_OPTIONS;
    static struct option long_options[] =
@@ -279,6 +345,9 @@ my_config(
       {"maxdepth",      required_argument, 0, '7'},
       {"no-leafs",      no_argument,       0, '8'},
       {"noleafs",       no_argument,       0, '8'},
+      {"offset",        required_argument, 0, '9'},
+      {"count",         required_argument, 0, '1'},
+      {"lazy",          no_argument,       0, 'A'},
       {"help",          no_argument,       0, 'h'},
       {"verbose",       no_argument,       0, 'v'},
       {"version",       no_argument,       0, 'V'},
@@ -365,6 +434,28 @@ my_config(
          cnf->treeopts.noleaf = 1;
          break;
 
+         case '9':
+         if (ldaputils_getopt_size(cnf->lud, "offset", optarg, 0, INT_MAX, &num) != 0)
+         {
+            my_unbind(cnf);
+            return(1);
+         };
+         cnf->lud->vlvoffset = (int)num;
+         break;
+
+         case '1':
+         if (ldaputils_getopt_size(cnf->lud, "count", optarg, 1, INT_MAX, &num) != 0)
+         {
+            my_unbind(cnf);
+            return(1);
+         };
+         cnf->lud->vlvcount = (int)num;
+         break;
+
+         case 'A':
+         cnf->lazy = 1;
+         break;
+
          // argument error
          case '?':
          fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
@@ -391,6 +482,34 @@ my_config(
       };
    };
 
+   // checks lazy expansion arguments
+   if ( ((cnf->lazy)) && ( ((cnf->lud->vlvoffset)) || ((cnf->lud->vlvcount)) ) )
+   {
+      fprintf(stderr, "%s: --lazy cannot be used with --offset or --count\n", PROGRAM_NAME);
+      fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+      my_unbind(cnf);
+      return(1);
+   };
+
+   // checks virtual list view arguments
+   if ( ((cnf->lud->vlvoffset)) || ((cnf->lud->vlvcount)) )
+   {
+      msg = NULL;
+      if (cnf->lud->vlvcount < 1)
+         msg = "--count must be greater than zero";
+      else if (!(cnf->lud->sortattr))
+         msg = "--offset and --count require a sort attribute (-S)";
+      else if (cnf->lud->pagesize > 0)
+         msg = "--offset and --count cannot be used with -E pr=size";
+      if ((msg))
+      {
+         fprintf(stderr, "%s: %s\n", PROGRAM_NAME, msg);
+         fprintf(stderr, "Try `%s --help' for more information.\n", PROGRAM_NAME);
+         my_unbind(cnf);
+         return(1);
+      };
+   };
+
    // configures LDAP attributes to return in results
    if (argc > optind)
    {
@@ -405,20 +524,15 @@ my_config(
          cnf->lud->attrs[c] = argv[optind+c];
       cnf->lud->attrs[c] = NULL;
    } else {
+      // only DNs are needed to build the tree
       if (!(cnf->lud->attrs = (char **) malloc(sizeof(char *) * 2)))
       {
          fprintf(stderr, "%s: out of virtual memory\n", PROGRAM_NAME);
          my_unbind(cnf);
          return(1);
       };
-      cnf->lud->attrs[0] = NULL;
+      cnf->lud->attrs[0] = LDAP_NO_ATTRS;
       cnf->lud->attrs[1] = NULL;
-      if ((cnf->lud->attrs[0] = strdup("structuralObjectClass")) == NULL)
-      {
-         fprintf(stderr, "%s: out of virtual memory\n", PROGRAM_NAME);
-         my_unbind(cnf);
-         return(1);
-      };
    };
 
    // reads password
@@ -434,13 +548,238 @@ my_config(
 }
 
 
+/// expands tree one level at a time
+/// @param[in] cnf    reference to configuration
+///
+/// Instead of retrieving the whole subtree, the children of each node are
+/// retrieved with a one level search limited to the number of nodes which
+/// are displayed.  The searches of sibling branches share the connection
+/// and are outstanding at the same time.  Nodes on the deepest displayed
+/// level are only checked for a single child so that they are not mistaken
+/// for leafs.
+///
+/// The server chooses which children are returned within the size limit,
+/// so the displayed children are not the first ones in RDN order, leafs are
+/// limited only after they are retrieved, and children which were not
+/// retrieved are not included in the number of truncated entries.
+///
+/// @return    Returns the error code from the OpenLDAP library
+int
+my_lazy(
+         MyConfig *                    cnf )
+{
+   int         err;
+   char *      base;
+
+   assert(cnf != NULL);
+
+   if ((err = ldaputils_mux_initialize(&cnf->mux, cnf->lud)) != LDAP_SUCCESS)
+      return(err);
+
+   // queues search of the base entry
+   base = NULL;
+   ldap_get_option(cnf->lud->ld, LDAP_OPT_DEFBASE, &base);
+   if ((err = my_lazy_queue(cnf, base, 0, LDAP_SCOPE_BASE)) != LDAP_SUCCESS)
+   {
+      if ((base))
+         ldap_memfree(base);
+      return(err);
+   };
+
+   if ((err = my_lazy_submit(cnf)) != LDAP_SUCCESS)
+      return(err);
+
+   return(ldaputils_mux_result(cnf->mux, NULL));
+}
+
+
+// queues search of a node
+int
+my_lazy_queue(
+         MyConfig *                    cnf,
+         char *                        dn,
+         size_t                        depth,
+         int                           scope )
+{
+   size_t         size;
+   size_t         maxdepth;
+   void *         ptr;
+   MyLevel *      level;
+
+   assert(cnf != NULL);
+
+   // grows queue
+   if (cnf->levels_len >= cnf->levels_size)
+   {
+      size = (cnf->levels_size) ? (cnf->levels_size * 2) : 64;
+      if ((ptr = realloc(cnf->levels, (sizeof(MyLevel *) * size))) == NULL)
+         return(LDAP_NO_MEMORY);
+      cnf->levels      = ptr;
+      cnf->levels_size = size;
+   };
+
+   if ((level = malloc(sizeof(MyLevel))) == NULL)
+      return(LDAP_NO_MEMORY);
+   memset(level, 0, sizeof(MyLevel));
+   level->cnf       = cnf;
+   level->dn        = dn;
+   level->depth     = depth;
+   level->scope     = scope;
+   level->sizelimit = -1;
+
+   // limits children to the number displayed
+   maxdepth = cnf->treeopts.maxdepth;
+   if (scope == LDAP_SCOPE_ONELEVEL)
+   {
+      if ( ((maxdepth)) && ((depth+1) >= maxdepth) )
+         level->sizelimit = 1;
+      else if ((cnf->treeopts.maxchildren))
+         level->sizelimit = (int)cnf->treeopts.maxchildren;
+   };
+
+   cnf->levels[cnf->levels_len++] = level;
+
+   return(LDAP_SUCCESS);
+}
+
+
+// adds children of a node to tree and queues their searches
+int
+my_lazy_result(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 res,
+         void *                        context )
+{
+   int            rc;
+   int            err;
+   size_t         depth;
+   size_t         maxdepth;
+   char *         dn;
+   LDAP *         ld;
+   LDAPMessage *  msg;
+   MyLevel *      level;
+   MyConfig *     cnf;
+
+   assert(lud     != NULL);
+   assert(res     != NULL);
+   assert(context != NULL);
+
+   level    = context;
+   cnf      = level->cnf;
+   ld       = ldaputils_get_ld(lud);
+   maxdepth = cnf->treeopts.maxdepth;
+   depth    = (level->scope == LDAP_SCOPE_BASE) ? level->depth : (level->depth + 1);
+   err      = LDAP_SUCCESS;
+
+   cnf->levels_done++;
+
+   for(msg = ldap_first_message(ld, res); ((msg)); msg = ldap_next_message(ld, msg))
+   {
+      switch(ldap_msgtype(msg))
+      {
+         case LDAP_RES_SEARCH_ENTRY:
+         if ((err = my_result(lud, msg, cnf)) != LDAP_SUCCESS)
+            return(err);
+         // nodes below the deepest displayed level are not expanded
+         if ( ((maxdepth)) && (depth >= maxdepth) )
+            break;
+         if ((dn = ldap_get_dn(ld, msg)) == NULL)
+            return(LDAP_NO_MEMORY);
+         if ((err = my_lazy_queue(cnf, dn, depth, LDAP_SCOPE_ONELEVEL)) != LDAP_SUCCESS)
+         {
+            ldap_memfree(dn);
+            return(err);
+         };
+         break;
+
+         case LDAP_RES_SEARCH_RESULT:
+         if ((err = ldap_parse_result(ld, msg, &rc, NULL, NULL, NULL, NULL, 0)) != LDAP_SUCCESS)
+            return(err);
+         // size limit is expected when children exceed the displayed nodes
+         if ( (rc != LDAP_SUCCESS) && (rc != LDAP_SIZELIMIT_EXCEEDED) )
+            return(rc);
+         break;
+
+         default:
+         break;
+      };
+   };
+
+   return(my_lazy_submit(cnf));
+}
+
+
+// submits queued searches
+int
+my_lazy_submit(
+         MyConfig *                    cnf )
+{
+   int            err;
+   char *         attrs[2];
+   char **        attrsp;
+   MyLevel *      level;
+
+   assert(cnf != NULL);
+
+   attrs[0] = LDAP_NO_ATTRS;
+   attrs[1] = NULL;
+
+   while ( (cnf->levels_next < cnf->levels_len) && ((cnf->levels_next - cnf->levels_done) < MY_LAZY_OUTSTANDING) )
+   {
+      level  = cnf->levels[cnf->levels_next++];
+      attrsp = ( ((cnf->copy_entry)) && (level->sizelimit != 1) ) ? cnf->lud->attrs : attrs;
+      err    = ldaputils_mux_search_ext(cnf->mux, level->dn, level->scope, cnf->lud->filter, attrsp, NULL, level->sizelimit, &my_lazy_result, level);
+      if (err != LDAP_SUCCESS)
+         return(err);
+   };
+
+   return(LDAP_SUCCESS);
+}
+
+
+// adds entry of lazy expansion to tree
+int
+my_result(
+         LDAPUtils *                   lud,
+         LDAPMessage *                 msg,
+         void *                        context )
+{
+   MyConfig *  cnf;
+
+   assert(lud     != NULL);
+   assert(msg     != NULL);
+   assert(context != NULL);
+
+   cnf = context;
+
+   return(ldaputils_tree_add_message(cnf->tree, ldaputils_get_ld(lud), msg, cnf->copy_entry));
+}
+
+
 // fress resources
 void
 my_unbind(
          MyConfig *                    cnf )
 {
+   size_t   x;
+
    assert(cnf != NULL);
 
+   if ((cnf->mux))
+      ldaputils_mux_free(cnf->mux);
+
+   for(x = 0; x < cnf->levels_len; x++)
+   {
+      if ((cnf->levels[x]->dn))
+         ldap_memfree(cnf->levels[x]->dn);
+      free(cnf->levels[x]);
+   };
+   if ((cnf->levels))
+      free(cnf->levels);
+
+   if ((cnf->tree))
+      ldaputils_tree_free(cnf->tree);
+
    if ((cnf->lud))
       ldaputils_unbind(cnf->lud);
 
@@ -0,0 +1,144 @@
+/*
+ *  Compares per-object malloc() with the libldaputils arena allocator using
+ *  the allocation pattern of ldaputils_get_entries().  Run each mode in a
+ *  separate process so the peak RSS is not shared:
+ *
+ *     make tests/arenabench
+ *     ./tests/arenabench malloc 1000000
+ *     ./tests/arenabench arena  1000000
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "larena.h"
+
+#define MY_ATTRS     8
+#define MY_VALUES    2
+#define MY_PTRS      (7 + (MY_ATTRS * (3 + (2 * MY_VALUES))))
+
+int main(int argc, char * argv[]);
+
+int main(int argc, char * argv[])
+{
+   size_t            x;
+   size_t            y;
+   size_t            z;
+   size_t            count;
+   size_t            allocs;
+   size_t            n;
+   int               arena_mode;
+   char              dn[128];
+   char              val[64];
+   void **           entries;
+   void **           ptrs;
+   struct berval *         bv;
+   LDAPUtilsArena *        arena;
+   LDAPUtilsArenaBlock *   block;
+   struct rusage     usage;
+   struct timespec   start;
+   struct timespec   stop;
+
+   if (argc != 3)
+   {
+      fprintf(stderr, "Usage: %s malloc|arena entries\n", argv[0]);
+      return(1);
+   };
+   arena_mode = !(strcmp(argv[1], "arena"));
+   count      = (size_t)strtoull(argv[2], NULL, 10);
+   allocs     = 0;
+   arena      = NULL;
+
+   if ((entries = calloc(count, sizeof(void *))) == NULL)
+      return(1);
+   if ((arena_mode) && ((arena = ldaputils_arena_initialize(0)) == NULL))
+      return(1);
+
+   clock_gettime(CLOCK_MONOTONIC, &start);
+
+   for(x = 0; x < count; x++)
+   {
+      snprintf(dn, sizeof(dn), "uid=user%zu,ou=People,dc=example,dc=com", x);
+
+      // entry, DN, four DN components and the attribute list
+      if (!(arena_mode))
+      {
+         n       = 0;
+         ptrs    = malloc(sizeof(void *) * MY_PTRS);
+         ptrs[n++] = malloc(64);
+         ptrs[n++] = strdup(dn);
+         ptrs[n++] = malloc(sizeof(char *) * 5);
+         for(y = 0; y < 4; y++)
+            ptrs[n++] = strdup("ou=People");
+         for(y = 0; y < MY_ATTRS; y++)
+         {
+            ptrs[n++] = malloc(sizeof(void *) * 3);
+            ptrs[n++] = strdup("attributeName");
+            ptrs[n++] = malloc(sizeof(struct berval *) * (MY_VALUES + 1));
+            for(z = 0; z < MY_VALUES; z++)
+            {
+               snprintf(val, sizeof(val), "value %zu of entry %zu", z, x);
+               bv         = malloc(sizeof(struct berval));
+               bv->bv_len = strlen(val);
+               bv->bv_val = malloc(bv->bv_len);
+               memcpy(bv->bv_val, val, bv->bv_len);
+               ptrs[n++]  = bv;
+               ptrs[n++]  = bv->bv_val;
+            };
+         };
+         allocs    += n + 1;
+         entries[x] = ptrs;
+         continue;
+      };
+
+      entries[x] = ldaputils_arena_alloc(arena, 64);
+      ldaputils_arena_strdup(arena, dn);
+      ldaputils_arena_alloc(arena, sizeof(char *) * 5);
+      for(y = 2; y < 6; y++)
+         ldaputils_arena_strdup(arena, "ou=People");
+      ldaputils_arena_alloc(arena, sizeof(void *) * 16);
+      for(y = 0; y < MY_ATTRS; y++)
+      {
+         ldaputils_arena_alloc(arena, sizeof(void *) * 3);
+         ldaputils_arena_strdup(arena, "attributeName");
+         ldaputils_arena_alloc(arena, sizeof(struct berval *) * (MY_VALUES + 1));
+         bv = ldaputils_arena_alloc(arena, sizeof(struct berval) * MY_VALUES);
+         for(z = 0; z < MY_VALUES; z++)
+         {
+            snprintf(val, sizeof(val), "value %zu of entry %zu", z, x);
+            bv[z].bv_len = strlen(val);
+            bv[z].bv_val = ldaputils_arena_memdup(arena, val, bv[z].bv_len);
+         };
+      };
+   };
+
+   // frees memory
+   if ((arena_mode))
+   {
+      for(block = arena->blocks; ((block)); block = block->next)
+         allocs++;
+      ldaputils_arena_free(arena);
+   } else {
+      for(x = 0; x < count; x++)
+      {
+         ptrs = entries[x];
+         for(y = 0; y < MY_PTRS; y++)
+            free(ptrs[y]);
+         free(ptrs);
+      };
+   };
+   free(entries);
+
+   clock_gettime(CLOCK_MONOTONIC, &stop);
+   getrusage(RUSAGE_SELF, &usage);
+
+   printf("mode:        %s\n", argv[1]);
+   printf("entries:     %zu\n", count);
+   printf("allocations: %zu\n", allocs);
+   printf("seconds:     %.3f\n", (double)(stop.tv_sec - start.tv_sec) + ((double)(stop.tv_nsec - start.tv_nsec) / 1e9));
+   printf("peak RSS:    %ld KiB\n", usage.ru_maxrss);
+
+   return(0);
+}
@@ -0,0 +1,375 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2025 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file tests/dntest.c checks parsing of DNs into RDNs
+ */
+
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+// MARK: - Headers
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ldap.h>
+#include "libldaputils.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+// MARK: - Definitions
+
+#define MY_RDNS      8
+
+
+/////////////////
+//             //
+//  Datatypes  //
+//             //
+/////////////////
+// MARK: - Datatypes
+
+typedef struct my_test MyTest;
+struct my_test
+{
+   const char *      dn;
+   size_t            len;               // length of DN, or 0 to use strlen()
+   int               valid;
+   const char *      rdns[MY_RDNS];     // RDNs starting with the root
+   const char *      norm[MY_RDNS];     // case folded RDNs starting with the root
+   const char *      ufn;
+   const char *      adc;
+};
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+// MARK: - Variables
+
+static const MyTest my_tests[] =
+{
+   // RDNs are returned as spelled, normalized forms are case folded
+   {  "cn=John Doe,ou=People,dc=Example,dc=COM", 0, 1,
+      { "dc=COM", "dc=Example", "ou=People", "cn=John Doe", NULL },
+      { "dc=com", "dc=example", "ou=people", "cn=john doe", NULL },
+      "John Doe, People, Example.COM", "Example.COM/People/John Doe" },
+
+   // the root DSE has no RDNs
+   {  "", 0, 1, { NULL }, { NULL }, "", "" },
+
+   // escaped characters are reencoded
+   {  "cn=Doe\\, John,ou=People,dc=example,dc=com", 0, 1,
+      { "dc=com", "dc=example", "ou=People", "cn=Doe\\2C John", NULL },
+      { "dc=com", "dc=example", "ou=people", "cn=doe\\2c john", NULL },
+      "Doe\\2C John, People, example.com", "example.com/People/Doe\\, John" },
+   {  "cn=\\48\\49\\c3\\a9,dc=com", 0, 1,
+      { "dc=com", "cn=HI\xc3\xa9", NULL },
+      { "dc=com", "cn=hi\xc3\xa9", NULL },
+      "HI\\C3\\A9, com", "com/HI\xc3\xa9" },
+   {  "cn=  spaced\\  ,dc=com", 0, 1,
+      { "dc=com", "cn=spaced\\20", NULL },
+      { "dc=com", "cn=spaced\\20", NULL },
+      "spaced\\20, com", "com/spaced " },
+   {  "cn=#04024869,dc=com", 0, 1,
+      { "dc=com", "cn=#04024869", NULL },
+      { "dc=com", "cn=#04024869", NULL },
+      "#04024869, com", "com/#04024869" },
+
+   // multi-valued RDNs are kept together
+   {  "CN=a\\+b+UID=x,dc=com", 0, 1,
+      { "dc=com", "CN=a\\2Bb+UID=x", NULL },
+      { "dc=com", "cn=a\\2bb+uid=x", NULL },
+      "a\\2Bb + x, com", "com/a+b,x" },
+
+   // counted strings are not read past their length
+   {  "uid=jdoe,dc=example,dc=com,dc=invalid,", 26, 1,
+      { "dc=com", "dc=example", "uid=jdoe", NULL },
+      { "dc=com", "dc=example", "uid=jdoe", NULL },
+      "jdoe, example.com", "example.com/jdoe" },
+
+   // invalid DNs are rejected
+   {  "cn=foo,bad",             0, 0, { NULL }, { NULL }, NULL, NULL },
+   {  "cn=foo,dc=com,",         0, 0, { NULL }, { NULL }, NULL, NULL },
+   {  "cn=a\"q\",dc=com",       0, 0, { NULL }, { NULL }, NULL, NULL },
+   {  NULL, 0, 0, { NULL }, { NULL }, NULL, NULL }
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+// MARK: - Prototypes
+
+extern int
+main(
+         int                           argc,
+         char *                        argv[] );
+
+
+static int
+my_check(
+         const MyTest *                test,
+         LDAPUtilsDNCache *            cache );
+
+
+static int
+my_check_list(
+         const MyTest *                test,
+         const char *                  name,
+         const char * const *          list,
+         size_t                        len,
+         const char * const *          expect );
+
+
+static int
+my_check_shared(
+         LDAPUtilsDNCache *            cache );
+
+
+static int
+my_check_str(
+         const MyTest *                test,
+         const char *                  name,
+         const char *                  str,
+         const char *                  expect );
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+// MARK: - Functions
+
+/// main statement
+/// @param[in] argc   number of arguments
+/// @param[in] argv   array of arguments
+int
+main(
+         int                           argc,
+         char *                        argv[] )
+{
+   int                  failed;
+   size_t               x;
+   LDAPUtilsDNCache *   cache;
+
+   if (argc > 1)
+   {
+      fprintf(stderr, "Usage: %s\n", argv[0]);
+      return(1);
+   };
+
+   if ((cache = ldaputils_dn_cache_initialize()) == NULL)
+   {
+      fprintf(stderr, "%s: out of virtual memory\n", argv[0]);
+      return(1);
+   };
+
+   failed = 0;
+
+   // parses each DN with a private table and with a shared table
+   for(x = 0; ((my_tests[x].dn)); x++)
+   {
+      failed += my_check(&my_tests[x], NULL);
+      failed += my_check(&my_tests[x], cache);
+   };
+
+   failed += my_check_shared(cache);
+
+   ldaputils_dn_cache_free(cache);
+
+   printf("%zu tests, %i failed\n", x, failed);
+
+   return( ((failed)) ? 1 : 0 );
+}
+
+
+// parses DN and compares the results with the expected values
+int
+my_check(
+         const MyTest *                test,
+         LDAPUtilsDNCache *            cache )
+{
+   int                  failed;
+   size_t               len;
+   struct berval        bv;
+   LDAPUtilsDN *        pdn;
+   const char * const * list;
+
+   bv.bv_val = (char *)test->dn;
+   bv.bv_len = ((test->len)) ? test->len : strlen(test->dn);
+
+   pdn = ldaputils_dn_parse_bv(cache, &bv);
+
+   if (!(test->valid))
+   {
+      if (!(pdn))
+         return(0);
+      printf("FAIL: `%s': parsed invalid DN\n", test->dn);
+      ldaputils_dn_free(pdn);
+      return(1);
+   };
+   if (!(pdn))
+   {
+      printf("FAIL: `%s': unable to parse DN\n", test->dn);
+      return(1);
+   };
+
+   failed = 0;
+
+   list    = ldaputils_dn_get_components(pdn, &len);
+   failed += my_check_list(test, "components", list, len, test->rdns);
+
+   list    = ldaputils_dn_get_normalized(pdn, &len);
+   failed += my_check_list(test, "normalized", list, len, test->norm);
+
+   len     = 0;
+   while((test->rdns[len]))
+      len++;
+   failed += my_check_str(test, "rdn", ldaputils_dn_get_rdn(pdn), ((len)) ? test->rdns[len-1] : "");
+   failed += my_check_str(test, "ufn", ldaputils_dn_get_ufn(pdn), test->ufn);
+   failed += my_check_str(test, "adc", ldaputils_dn_get_adc(pdn), test->adc);
+
+   ldaputils_dn_free(pdn);
+
+   return(failed);
+}
+
+
+// compares list of RDNs with expected list
+int
+my_check_list(
+         const MyTest *                test,
+         const char *                  name,
+         const char * const *          list,
+         size_t                        len,
+         const char * const *          expect )
+{
+   size_t      x;
+
+   for(x = 0; ( (x < len) && ((expect[x])) ); x++)
+      if (strcmp(list[x], expect[x]) != 0)
+         break;
+
+   if ( (x == len) && (!(expect[x])) && (!(list[x])) )
+      return(0);
+
+   printf("FAIL: `%s': %s:", test->dn, name);
+   for(x = 0; (x < len); x++)
+      printf(" `%s'", list[x]);
+   printf("\n");
+
+   return(1);
+}
+
+
+// verifies parents of DNs parsed with the same table share storage and
+// that leaf RDNs are not added to the table
+int
+my_check_shared(
+         LDAPUtilsDNCache *            cache )
+{
+   int                  failed;
+   size_t               count;
+   size_t               len1;
+   size_t               len2;
+   LDAPUtilsDN *        pdn1;
+   LDAPUtilsDN *        pdn2;
+   const char * const * list1;
+   const char * const * list2;
+
+   pdn1  = ldaputils_dn_parse(cache, "uid=jdoe,ou=People,dc=example,dc=com");
+   count = cache->count;
+   pdn2  = ldaputils_dn_parse(cache, "uid=jsmith,ou=People,dc=example,dc=com");
+   if ( (!(pdn1)) || (!(pdn2)) )
+   {
+      printf("FAIL: unable to parse DNs with shared table\n");
+      ldaputils_dn_free(pdn1);
+      ldaputils_dn_free(pdn2);
+      return(1);
+   };
+
+   failed = 0;
+
+   list1 = ldaputils_dn_get_components(pdn1, &len1);
+   list2 = ldaputils_dn_get_components(pdn2, &len2);
+   if ( (len1 != 4) || (len2 != 4) || (list1[2] != list2[2]) || (list1[0] != list2[0]) )
+   {
+      printf("FAIL: parents of DNs parsed with shared table are not shared\n");
+      failed++;
+   };
+   if (cache->count != count)
+   {
+      printf("FAIL: leaf RDN added to shared table\n");
+      failed++;
+   };
+   if (strcmp(list1[3], "uid=jdoe") != 0)
+   {
+      printf("FAIL: `%s': leaf RDN changed by sibling\n", list1[3]);
+      failed++;
+   };
+
+   ldaputils_dn_free(pdn1);
+   ldaputils_dn_free(pdn2);
+
+   return(failed);
+}
+
+
+// compares string with expected string
+int
+my_check_str(
+         const MyTest *                test,
+         const char *                  name,
+         const char *                  str,
+         const char *                  expect )
+{
+   if ( ((str)) && (!(strcmp(str, expect))) )
+      return(0);
+   printf("FAIL: `%s': %s: `%s' expected `%s'\n", test->dn, name, ((str)) ? str : "(null)", expect);
+   return(1);
+}
+
+/* end of source file */
@@ -0,0 +1,132 @@
+/*
+ *  Compares per-field stdio calls with the libldaputils buffered output when
+ *  writing rows in the format of ldap2csv.  Statistics are written to
+ *  standard error:
+ *
+ *     make tests/outputbench
+ *     ./tests/outputbench stdio  2000000 /dev/null
+ *     ./tests/outputbench output 2000000 /dev/null
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <ldap.h>
+#include <ldaputils.h>
+
+#define MY_COLUMNS   8
+#define MY_VALUES    2
+
+int main(int argc, char * argv[]);
+
+int main(int argc, char * argv[])
+{
+   size_t            x;
+   size_t            y;
+   size_t            z;
+   size_t            count;
+   size_t            bytes;
+   int               fd;
+   int               output_mode;
+   double            secs;
+   char              dn[128];
+   char              vals[MY_COLUMNS][MY_VALUES][64];
+   FILE *            fs;
+   LDAPUtilsOutput * out;
+   struct timespec   start;
+   struct timespec   stop;
+
+   if (argc != 4)
+   {
+      fprintf(stderr, "Usage: %s stdio|output entries file\n", argv[0]);
+      return(1);
+   };
+   output_mode = !(strcmp(argv[1], "output"));
+   count       = (size_t)strtoull(argv[2], NULL, 10);
+   bytes       = 0;
+   fs          = NULL;
+   out         = NULL;
+
+   for(y = 0; y < MY_COLUMNS; y++)
+      for(z = 0; z < MY_VALUES; z++)
+         snprintf(vals[y][z], sizeof(vals[y][z]), "value %zu of attribute %zu", z, y);
+
+   if ((fd = open(argv[3], O_WRONLY|O_CREAT|O_TRUNC, 0644)) == -1)
+   {
+      perror(argv[3]);
+      return(1);
+   };
+   if ((output_mode) && (ldaputils_output_initialize(&out, fd, 0) != LDAP_SUCCESS))
+      return(1);
+   if ( (!(output_mode)) && ((fs = fdopen(fd, "w")) == NULL) )
+      return(1);
+
+   clock_gettime(CLOCK_MONOTONIC, &start);
+
+   for(x = 0; x < count; x++)
+   {
+      snprintf(dn, sizeof(dn), "uid=user%zu,ou=People,dc=example,dc=com", x);
+      bytes += strlen(dn) + 4;
+
+      if (!(output_mode))
+      {
+         fprintf(fs, "\"");
+         fprintf(fs, "%s", dn);
+         for(y = 0; y < MY_COLUMNS; y++)
+         {
+            fprintf(fs, "\",\"");
+            for(z = 0; z < MY_VALUES; z++)
+            {
+               if (z > 0)
+                  fprintf(fs, "|%s", vals[y][z]);
+               else
+                  fprintf(fs, "%s", vals[y][z]);
+               bytes += strlen(vals[y][z]) + 1;
+            };
+            bytes += 2;
+         };
+         fprintf(fs, "\"\n");
+         continue;
+      };
+
+      ldaputils_output_putc(out, '"');
+      ldaputils_output_puts(out, dn);
+      for(y = 0; y < MY_COLUMNS; y++)
+      {
+         ldaputils_output_write(out, "\",\"", 3);
+         for(z = 0; z < MY_VALUES; z++)
+         {
+            if (z > 0)
+               ldaputils_output_putc(out, '|');
+            ldaputils_output_puts(out, vals[y][z]);
+            bytes += strlen(vals[y][z]) + 1;
+         };
+         bytes += 2;
+      };
+      ldaputils_output_write(out, "\"\n", 2);
+   };
+
+   if ((output_mode))
+   {
+      if (ldaputils_output_flush(out) != LDAP_SUCCESS)
+         return(1);
+      ldaputils_output_free(out);
+      close(fd);
+   } else {
+      fclose(fs);
+   };
+
+   clock_gettime(CLOCK_MONOTONIC, &stop);
+   secs = (double)(stop.tv_sec - start.tv_sec) + ((double)(stop.tv_nsec - start.tv_nsec) / 1e9);
+
+   fprintf(stderr, "mode:        %s\n", argv[1]);
+   fprintf(stderr, "entries:     %zu\n", count);
+   fprintf(stderr, "seconds:     %.3f\n", secs);
+   fprintf(stderr, "entries/s:   %.0f\n", (double)count / secs);
+   fprintf(stderr, "MB/s:        %.1f\n", ((double)bytes / 1e6) / secs);
+
+   return(0);
+}
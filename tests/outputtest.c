@@ -0,0 +1,237 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2025 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file tests/outputtest.c checks escaping of CSV and JSON output
+ */
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+// MARK: - Headers
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ldap.h>
+#include "libldaputils.h"
+
+
+///////////////////
+//               //
+//  Definitions  //
+//               //
+///////////////////
+// MARK: - Definitions
+
+#define MY_CSV          1
+#define MY_JSON         2
+#define MY_JSON_VALUE   3
+
+
+/////////////////
+//             //
+//  Datatypes  //
+//             //
+/////////////////
+// MARK: - Datatypes
+
+typedef struct my_test MyTest;
+struct my_test
+{
+   int               func;
+   int               sep;
+   const char *      data;
+   size_t            len;       // length of data, or 0 to use strlen()
+   const char *      expect;
+};
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+// MARK: - Variables
+
+static const MyTest my_tests[] =
+{
+   // quotes are doubled, delimiters and line breaks are not escaped
+   { MY_CSV,        0,   "plain",                       0, "plain" },
+   { MY_CSV,        0,   "say \"hi\"",                  0, "say \"\"hi\"\"" },
+   { MY_CSV,        0,   "a,b\r\nc",                    0, "a,b\r\nc" },
+   { MY_CSV,        0,   "a|b\\c",                      0, "a|b\\c" },
+
+   // separators and backslashes are escaped when values are joined
+   { MY_CSV,        '|', "a|b\\c",                      0, "a\\|b\\\\c" },
+   { MY_CSV,        '|', "\"|\"",                       0, "\"\"\\|\"\"" },
+   { MY_CSV,        ';', "a|b;c",                       0, "a|b\\;c" },
+   { MY_CSV,        '|', "0123456789012345678901234567890123456789|", 0, "0123456789012345678901234567890123456789\\|" },
+
+   // quotes, backslashes, and control characters are escaped
+   { MY_JSON,       0,   "plain",                       0, "\"plain\"" },
+   { MY_JSON,       0,   "",                            0, "\"\"" },
+   { MY_JSON,       0,   "\"\\/",                       0, "\"\\\"\\\\/\"" },
+   { MY_JSON,       0,   "\b\f\n\r\t",                  0, "\"\\b\\f\\n\\r\\t\"" },
+   { MY_JSON,       0,   "\x01\x1f\x7f",                0, "\"\\u0001\\u001f\x7f\"" },
+   { MY_JSON,       0,   "a\0b",                        3, "\"a\\u0000b\"" },
+   { MY_JSON,       0,   "0123456789abcdef0123456789abcdef0123456789\"", 0, "\"0123456789abcdef0123456789abcdef0123456789\\\"\"" },
+
+   // valid UTF-8 is copied, invalid bytes are replaced with U+FFFD
+   { MY_JSON,       0,   "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80", 0, "\"caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80\"" },
+   { MY_JSON,       0,   "a\xff" "b",                   0, "\"a\xef\xbf\xbd" "b\"" },
+   { MY_JSON,       0,   "\xc0\x80",                    0, "\"\xef\xbf\xbd\xef\xbf\xbd\"" },
+   { MY_JSON,       0,   "\xed\xa0\x80",                0, "\"\xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd\"" },
+   { MY_JSON,       0,   "\xe2\x82",                    0, "\"\xef\xbf\xbd\xef\xbf\xbd\"" },
+   { MY_JSON,       0,   "\xf4\x90\x80\x80",            0, "\"\xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd\"" },
+   { MY_JSON,       0,   "0123456789abcdef0123456789abcdef\x80", 0, "\"0123456789abcdef0123456789abcdef\xef\xbf\xbd\"" },
+
+   // values which are not UTF-8 are encoded with base64
+   { MY_JSON_VALUE, 0,   "caf\xc3\xa9",                 0, "\"caf\xc3\xa9\"" },
+   { MY_JSON_VALUE, 0,   "\xff",                        0, "{\"base64\":\"/w==\"}" },
+   { MY_JSON_VALUE, 0,   "\xff" "f",                    0, "{\"base64\":\"/2Y=\"}" },
+   { MY_JSON_VALUE, 0,   "\xff" "fo",                   0, "{\"base64\":\"/2Zv\"}" },
+   { MY_JSON_VALUE, 0,   "foo\xc3",                     0, "{\"base64\":\"Zm9vww==\"}" },
+   { MY_JSON_VALUE, 0,   "\0\x01\x02",                  3, "\"\\u0000\\u0001\\u0002\"" },
+   { 0, 0, NULL, 0, NULL }
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+// MARK: - Prototypes
+
+extern int
+main(
+         int                           argc,
+         char *                        argv[] );
+
+
+static void
+my_print(
+         const char *                  data,
+         size_t                        len );
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+// MARK: - Functions
+
+/// main statement
+/// @param[in] argc   number of arguments
+/// @param[in] argv   array of arguments
+int
+main(
+         int                           argc,
+         char *                        argv[] )
+{
+   int                  err;
+   int                  failed;
+   size_t               x;
+   size_t               len;
+   LDAPUtilsOutput *    out;
+   const MyTest *       test;
+
+   if (argc > 1)
+   {
+      fprintf(stderr, "Usage: %s\n", argv[0]);
+      return(1);
+   };
+
+   failed = 0;
+
+   for(x = 0; ((my_tests[x].data)); x++)
+   {
+      test = &my_tests[x];
+      len  = ((test->len)) ? test->len : strlen(test->data);
+
+      if (ldaputils_output_initialize(&out, -1, 0) != LDAP_SUCCESS)
+      {
+         fprintf(stderr, "%s: out of virtual memory\n", argv[0]);
+         return(1);
+      };
+      switch(test->func)
+      {
+         case MY_CSV:  err = ldaputils_output_csv(out, test->data, len, test->sep); break;
+         case MY_JSON: err = ldaputils_output_json(out, test->data, len);           break;
+         default:      err = ldaputils_output_json_value(out, test->data, len);     break;
+      };
+
+      if ( (err != LDAP_SUCCESS) || (out->len != strlen(test->expect)) || ((memcmp(out->buff, test->expect, out->len))) )
+      {
+         printf("FAIL: test %zu: input ", x);
+         my_print(test->data, len);
+         printf("\n      expected ");
+         my_print(test->expect, strlen(test->expect));
+         printf("\n      received ");
+         my_print(out->buff, out->len);
+         printf("\n");
+         failed++;
+      };
+
+      ldaputils_output_free(out);
+   };
+
+   printf("%zu tests, %i failed\n", x, failed);
+
+   return( ((failed)) ? 1 : 0 );
+}
+
+
+// prints data with non-printable bytes as hex escapes
+void
+my_print(
+         const char *                  data,
+         size_t                        len )
+{
+   size_t      x;
+
+   for(x = 0; (x < len); x++)
+   {
+      if ( (data[x] < 0x20) || (data[x] > 0x7e) )
+         printf("\\x%02x", (unsigned char)data[x]);
+      else
+         putchar(data[x]);
+   };
+
+   return;
+}
+
+/* end of source file */
@@ -0,0 +1,93 @@
+/*
+ *  Measures how ldaputils_sort() scales from one to many threads when
+ *  sorting pointers to entries by case folded DN keys, the pattern used by
+ *  ldaputils_entries_sort_parallel():
+ *
+ *     make tests/sortbench
+ *     ./tests/sortbench 2000000 16
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lsort.h"
+
+typedef struct my_entry MyEntry;
+struct my_entry
+{
+   size_t            len;
+   char              key[48];
+};
+
+int main(int argc, char * argv[]);
+static int my_cmp(const void * ptr1, const void * ptr2);
+
+int main(int argc, char * argv[])
+{
+   size_t            x;
+   size_t            count;
+   size_t            threads;
+   size_t            max;
+   double            secs;
+   double            base;
+   MyEntry *         entries;
+   MyEntry **        list;
+   struct timespec   start;
+   struct timespec   stop;
+
+   if (argc != 3)
+   {
+      fprintf(stderr, "Usage: %s entries threads\n", argv[0]);
+      return(1);
+   };
+   count = (size_t)strtoull(argv[1], NULL, 10);
+   max   = (size_t)strtoull(argv[2], NULL, 10);
+
+   entries = malloc(sizeof(MyEntry) * count);
+   list    = malloc(sizeof(MyEntry *) * count);
+   if ( (!(entries)) || (!(list)) )
+      return(1);
+
+   srand(1);
+   for(x = 0; x < count; x++)
+      entries[x].len = (size_t)snprintf(entries[x].key, sizeof(entries[x].key), "dc=com%cdc=example%cou=people%cuid=%08x", 0, 0, 0, (unsigned)rand());
+
+   base = 0;
+   printf("threads  seconds  speedup\n");
+   for(threads = 1; threads <= max; threads *= 2)
+   {
+      for(x = 0; x < count; x++)
+         list[x] = &entries[x];
+
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      ldaputils_sort(list, count, sizeof(MyEntry *), &my_cmp, threads);
+      clock_gettime(CLOCK_MONOTONIC, &stop);
+
+      for(x = 1; x < count; x++)
+         if (my_cmp(&list[x-1], &list[x]) > 0)
+            return(fprintf(stderr, "%s: array is not sorted\n", argv[0]), 1);
+
+      secs = (double)(stop.tv_sec - start.tv_sec) + ((double)(stop.tv_nsec - start.tv_nsec) / 1e9);
+      base = ((base)) ? base : secs;
+      printf("%7zu  %7.3f  %6.2fx\n", threads, secs, (base / secs));
+   };
+
+   free(list);
+   free(entries);
+
+   return(0);
+}
+
+static int my_cmp(const void * ptr1, const void * ptr2)
+{
+   int               rc;
+   const MyEntry *   e1;
+   const MyEntry *   e2;
+
+   e1 = *((const MyEntry * const *)ptr1);
+   e2 = *((const MyEntry * const *)ptr2);
+   if ((rc = memcmp(e1->key, e2->key, ((e1->len < e2->len) ? e1->len : e2->len))))
+      return(rc);
+   return((e1->len < e2->len) ? -1 : ((e1->len > e2->len) ? 1 : 0));
+}
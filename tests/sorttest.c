@@ -0,0 +1,459 @@
+/*
+ *  LDAP Utilities
+ *  Copyright (C) 2025 David M. Syzdek <david@syzdek.net>.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     1. Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *
+ *     2. Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *
+ *     3. Neither the name of the copyright holder nor the names of its
+ *        contributors may be used to endorse or promote products derived from
+ *        this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ *  @file tests/sorttest.c checks sort keys of ordering rules, parallel sort, and spilled runs
+ */
+
+///////////////
+//           //
+//  Headers  //
+//           //
+///////////////
+// MARK: - Headers
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ldap.h>
+#include "libldaputils.h"
+#include "lentry.h"
+#include "lsort.h"
+
+
+/////////////////
+//             //
+//  Datatypes  //
+//             //
+/////////////////
+// MARK: - Datatypes
+
+// element wider than a pointer to check copies during merges
+typedef struct my_elem MyElem;
+struct my_elem
+{
+   unsigned          key;
+   unsigned          pad0;
+   unsigned          pad1;
+};
+
+
+typedef struct my_order MyOrder;
+struct my_order
+{
+   const char *      rule;
+   const char *      values[16]; // NULL terminated, in ascending order
+};
+
+
+typedef struct my_sort MySort;
+struct my_sort
+{
+   size_t            nel;
+   size_t            threads;
+};
+
+
+typedef struct my_spill MySpill;
+struct my_spill
+{
+   size_t            nel;
+   size_t            max_memory;
+};
+
+
+/////////////////
+//             //
+//  Variables  //
+//             //
+/////////////////
+// MARK: - Variables
+
+// a value prefixed with '=' sorts equal to the previous value
+static const MyOrder my_orders[] =
+{
+   { "integerOrderingMatch",
+      { "-1000", "-999", "-10", "-9", "-1", "0", "=-0", "=000", "1", "= 1 ", "9", "10", "999", "1000", "12345678901234567890", "x" } },
+   { "2.5.13.15",
+      { "-20", "-19", "-2", "-1", "2", "19", "20", "-", "1.5", NULL } },
+   { "generalizedTimeOrderingMatch",
+      { "19991231235959Z", "20231231230000-0100", "=20240101000000Z", "=20240101010000+0100", "=202401010530+0530",
+        "20240101000000.5Z", "=20240101000000,5Z", "2024010100.5Z", "=20240101003000Z", "=20240101013000+0100",
+        "20240229120000Z", "=2024022912Z", "20240301000000Z", "2024133100Z", NULL } },
+   { NULL, { NULL } }
+};
+
+
+static const MySort my_sorts[] =
+{
+   { 0,                                   4 },
+   { 1,                                   4 },
+   { 1000,                                8 },
+   { (LDAPUTILS_SORT_MIN_CHUNK * 2) - 1,  8 },
+   { (LDAPUTILS_SORT_MIN_CHUNK * 2),      2 },
+   { (LDAPUTILS_SORT_MIN_CHUNK * 3) + 7,  3 },
+   { (LDAPUTILS_SORT_MIN_CHUNK * 3) + 7,  8 },
+   { (LDAPUTILS_SORT_MIN_CHUNK * 5) + 1,  5 },
+   { (LDAPUTILS_SORT_MIN_CHUNK * 7),      7 },
+   { 0,                                   0 }
+};
+
+
+// a budget of one byte writes each record as a separate run
+static const MySpill my_spills[] =
+{
+   { 1000,                                                               SIZE_MAX },
+   { LDAPUTILS_SPILL_FANIN,                                              1 },
+   { LDAPUTILS_SPILL_FANIN + 1,                                          1 },
+   { 1000,                                                               1 },
+   { (LDAPUTILS_SPILL_FANIN * LDAPUTILS_SPILL_FANIN) + LDAPUTILS_SPILL_FANIN + 3, 1 },
+   { 100000,                                                             4096 },
+   { 0,                                                                  0 }
+};
+
+
+//////////////////
+//              //
+//  Prototypes  //
+//              //
+//////////////////
+// MARK: - Prototypes
+
+extern int
+main(
+         int                           argc,
+         char *                        argv[] );
+
+
+static int
+my_cmp(
+         const void *                  ptr1,
+         const void *                  ptr2 );
+
+
+static int
+my_order(
+         const MyOrder *               order );
+
+
+static int
+my_sort(
+         const MySort *                sort );
+
+
+static int
+my_spill(
+         const MySpill *               spill );
+
+
+static int
+my_spill_cmp(
+         const LDAPUtilsSpillRec *     rec1,
+         const LDAPUtilsSpillRec *     rec2 );
+
+
+static void
+my_spill_rec(
+         size_t                        n,
+         char *                        key,
+         char *                        dn,
+         LDAPUtilsSpillRec *           rec );
+
+
+/////////////////
+//             //
+//  Functions  //
+//             //
+/////////////////
+// MARK: - Functions
+
+/// main statement
+/// @param[in] argc   number of arguments
+/// @param[in] argv   array of arguments
+int
+main(
+         int                           argc,
+         char *                        argv[] )
+{
+   int         failed;
+   size_t      x;
+
+   if (argc > 1)
+   {
+      fprintf(stderr, "Usage: %s\n", argv[0]);
+      return(1);
+   };
+
+   failed = 0;
+   for(x = 0; ((my_orders[x].rule)); x++)
+      failed += my_order(&my_orders[x]);
+   for(x = 0; ((my_sorts[x].threads)); x++)
+      failed += my_sort(&my_sorts[x]);
+   for(x = 0; ((my_spills[x].max_memory)); x++)
+      failed += my_spill(&my_spills[x]);
+
+   printf("%i failed\n", failed);
+
+   return( ((failed)) ? 1 : 0 );
+}
+
+
+// compares elements by key
+int
+my_cmp(
+         const void *                  ptr1,
+         const void *                  ptr2 )
+{
+   const MyElem *    e1;
+   const MyElem *    e2;
+
+   e1 = ptr1;
+   e2 = ptr2;
+
+   if (e1->key != e2->key)
+      return( (e1->key < e2->key) ? -1 : 1 );
+   return(0);
+}
+
+
+// checks that sort keys of values are in ascending order
+int
+my_order(
+         const MyOrder *               order )
+{
+   int                  rc;
+   int                  failed;
+   size_t               x;
+   size_t               len;
+   const char *         val;
+   const char *         prev;
+   char                 buff[2][LDAPUTILS_SORTKEY_SIZE(64)];
+   struct berval        key[2];
+   LDAPUtilsKeyFunc     keyfunc;
+
+   failed  = 0;
+   prev    = NULL;
+   keyfunc = ldaputils_sortkey_func(order->rule);
+
+   for(x = 0; ( (x < 16) && ((order->values[x])) ); x++)
+   {
+      val = order->values[x];
+      val = (val[0] == '=') ? &val[1] : val;
+      len = strlen(val);
+
+      key[x%2].bv_val = buff[x%2];
+      key[x%2].bv_len = keyfunc(buff[x%2], val, len);
+      if (!(prev))
+      {
+         prev = val;
+         continue;
+      };
+
+      rc = ldaputils_sortkey_cmp(&key[(x+1)%2], &key[x%2]);
+      if ( (order->values[x][0] == '=') ? (rc != 0) : (rc >= 0) )
+      {
+         printf("FAIL: %s: `%s' %s `%s'\n", order->rule, prev, (order->values[x][0] == '=') ? "!=" : ">=", val);
+         failed++;
+      };
+      prev = val;
+   };
+
+   return(failed);
+}
+
+
+// checks ldaputils_sort() against qsort()
+int
+my_sort(
+         const MySort *                sort )
+{
+   size_t      x;
+   unsigned    seed;
+   MyElem *    elems;
+   MyElem *    expect;
+
+   elems  = malloc(sizeof(MyElem) * (sort->nel + 1));
+   expect = malloc(sizeof(MyElem) * (sort->nel + 1));
+   if ( (!(elems)) || (!(expect)) )
+   {
+      free(elems);
+      free(expect);
+      printf("FAIL: sort %zu elements: out of virtual memory\n", sort->nel);
+      return(1);
+   };
+
+   // fills with many duplicate keys
+   seed = 2463534242U;
+   for(x = 0; (x < sort->nel); x++)
+   {
+      seed ^= seed << 13;
+      seed ^= seed >> 17;
+      seed ^= seed << 5;
+      elems[x].key  = seed % 1000;
+      elems[x].pad0 = elems[x].key;
+      elems[x].pad1 = ~elems[x].key;
+   };
+   memcpy(expect, elems, (sizeof(MyElem) * sort->nel));
+   qsort(expect, sort->nel, sizeof(MyElem), &my_cmp);
+
+   if (ldaputils_sort(elems, sort->nel, sizeof(MyElem), &my_cmp, sort->threads) != LDAP_SUCCESS)
+   {
+      printf("FAIL: sort %zu elements with %zu threads: out of virtual memory\n", sort->nel, sort->threads);
+      free(elems);
+      free(expect);
+      return(1);
+   };
+
+   // elements with equal keys are identical, so any correct sort matches
+   for(x = 0; (x < sort->nel); x++)
+      if ( (elems[x].key != expect[x].key) || (elems[x].pad0 != elems[x].key) || (elems[x].pad1 != ~elems[x].key) )
+         break;
+   free(elems);
+   free(expect);
+   if (x < sort->nel)
+   {
+      printf("FAIL: sort %zu elements with %zu threads: element %zu out of order\n", sort->nel, sort->threads, x);
+      return(1);
+   };
+
+   return(0);
+}
+
+
+// checks that records spilled to disk are returned once in sorted order
+int
+my_spill(
+         const MySpill *               spill )
+{
+   int                  err;
+   size_t               x;
+   size_t               n;
+   char                 buff[2][2][32];
+   const char *         dn;
+   LDAPUtilsSpill *     sp;
+   LDAPUtilsSpillRec    rec[2];
+
+   if (ldaputils_spill_initialize(&sp, spill->max_memory, 1) != LDAP_SUCCESS)
+   {
+      printf("FAIL: spill %zu records: out of virtual memory\n", spill->nel);
+      return(1);
+   };
+
+   for(x = 0; (x < spill->nel); x++)
+   {
+      my_spill_rec(x, buff[0][0], buff[0][1], &rec[0]);
+      if ((err = ldaputils_spill_add(sp, &rec[0].key, rec[0].dn.bv_val)) != LDAP_SUCCESS)
+      {
+         printf("FAIL: spill %zu records: %s\n", spill->nel, ldap_err2string(err));
+         ldaputils_spill_free(sp);
+         return(1);
+      };
+   };
+
+   // each DN identifies the record, which must follow the previous record
+   dn = NULL;
+   for(x = 0; (x <= spill->nel); x++)
+   {
+      if ((err = ldaputils_spill_next(sp, &dn)) != LDAP_SUCCESS)
+      {
+         printf("FAIL: spill %zu records: %s\n", spill->nel, ldap_err2string(err));
+         ldaputils_spill_free(sp);
+         return(1);
+      };
+      if ( (!(dn)) || (x == spill->nel) )
+         break;
+      n = strtoull(&dn[3], NULL, 10);
+      my_spill_rec(n, buff[x%2][0], buff[x%2][1], &rec[x%2]);
+      if ( (n >= spill->nel) || (strcmp(dn, rec[x%2].dn.bv_val) != 0) )
+         break;
+      if ( (x > 0) && (my_spill_cmp(&rec[(x+1)%2], &rec[x%2]) >= 0) )
+         break;
+   };
+   ldaputils_spill_free(sp);
+
+   if ( (x != spill->nel) || ((dn)) )
+   {
+      printf("FAIL: spill %zu records with %zu byte budget: record %zu out of order\n", spill->nel, spill->max_memory, x);
+      return(1);
+   };
+
+   return(0);
+}
+
+
+// compares records the same as the bounded memory sort
+int
+my_spill_cmp(
+         const LDAPUtilsSpillRec *     rec1,
+         const LDAPUtilsSpillRec *     rec2 )
+{
+   int      rc;
+
+   if ( (!(rec1->key.bv_val)) || (!(rec2->key.bv_val)) )
+   {
+      if ( ((rec1->key.bv_val)) || ((rec2->key.bv_val)) )
+         return( ((rec1->key.bv_val)) ? -1 : 1 );
+   }
+   else if ((rc = ldaputils_sortkey_cmp(&rec1->key, &rec2->key)))
+      return(rc);
+
+   return(ldaputils_sortkey_cmp(&rec1->dn, &rec2->dn));
+}
+
+
+// generates sort key and DN of record; every seventh record has no key
+void
+my_spill_rec(
+         size_t                        n,
+         char *                        key,
+         char *                        dn,
+         LDAPUtilsSpillRec *           rec )
+{
+   unsigned    hash;
+
+   hash = (unsigned)n * 2654435761U;
+   key[0] = '\0';
+   if ((n % 7))
+      snprintf(key, 32, "%04u", ((hash >> 16) % 1000));
+   snprintf(dn, 32, "cn=%07zu", n);
+
+   rec->key.bv_val = ((key[0])) ? key : NULL;
+   rec->key.bv_len = strlen(key);
+   rec->dn.bv_val  = dn;
+   rec->dn.bv_len  = strlen(dn);
+
+   return;
+}
+
+
+/* end of source file */